@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <filesystem>
 
 namespace olsh::Builtins {
 
@@ -11,6 +12,7 @@ class Alias {
 private:
     std::map<std::string, std::string> aliases;
     std::string aliasFile;
+    std::filesystem::file_time_type loadedTime{}; // of aliasFile when it was last read
 
     void loadAliases();
     void saveAliases();
@@ -0,0 +1,16 @@
+#ifndef BG_H
+#define BG_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Bg {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //BG_H
@@ -3,6 +3,7 @@
 
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include <vector>
 #include <string>
@@ -12,12 +13,16 @@ namespace olsh {
     class BuiltinRegistry {
     private:
         std::unordered_map<std::string, std::function<int(const std::vector<std::string>&)>> commands;
+        std::unordered_set<std::string> threadSafe;
 
         void registerCommands();
 
     public:
         BuiltinRegistry();
         bool isBuiltin(const std::string& command) const;
+        // true for builtins that only touch their args, the filesystem and Utils::in/out/err,
+        // so a pipeline can run them on a thread of the shell instead of forking
+        bool canRunInThread(const std::string& command) const;
         int execute(const std::string& command, const std::vector<std::string>& args) const;
         std::vector<std::string> getCommandNames() const;
     };
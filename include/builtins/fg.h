@@ -0,0 +1,16 @@
+#ifndef FG_H
+#define FG_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Fg {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //FG_H
@@ -0,0 +1,16 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Hash {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //HASH_H
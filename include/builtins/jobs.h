@@ -0,0 +1,16 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Jobs {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //JOBS_H
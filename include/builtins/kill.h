@@ -0,0 +1,16 @@
+#ifndef KILL_H
+#define KILL_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Kill {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //KILL_H
@@ -0,0 +1,16 @@
+#ifndef SET_H
+#define SET_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Set {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //SET_H
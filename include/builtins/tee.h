@@ -0,0 +1,16 @@
+#ifndef TEE_H
+#define TEE_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Tee {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //TEE_H
@@ -0,0 +1,27 @@
+#ifndef TIME_BUILTIN_H
+#define TIME_BUILTIN_H
+
+#include <string>
+#include <vector>
+
+namespace olsh {
+    class Shell;
+
+namespace Builtins {
+
+class Time {
+public:
+    int execute(const std::vector<std::string>& args);
+    // the shell hands `time ...` lines over before parsing, so a whole pipeline gets timed
+    int run(const std::string& line);
+
+    static void setShellInstance(Shell* shell);
+
+private:
+    static Shell* s_shell;
+};
+
+} // namespace Builtins
+} // namespace olsh
+
+#endif //TIME_BUILTIN_H
@@ -0,0 +1,16 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include <string>
+#include <vector>
+
+namespace olsh::Builtins {
+
+class Wait {
+public:
+    int execute(const std::vector<std::string>& args);
+};
+
+} // namespace olsh::Builtins
+
+#endif //WAIT_H
@@ -0,0 +1,53 @@
+#ifndef COMMAND_CACHE_H
+#define COMMAND_CACHE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+namespace olsh {
+
+// remembers where PATH commands live (and which ones don't exist) so launching
+// them doesn't walk every PATH directory. entries are dropped when PATH changes or
+// when one of its directories is modified
+class CommandCache {
+public:
+    struct Entry {
+        std::string path;
+        size_t dirIndex; // position of the directory in PATH, npos for hash -p entries
+        size_t hits;
+    };
+
+    // absolute path of the command, or "" if it isn't in PATH.
+    // commands containing a / are returned as they are
+    std::string lookup(const std::string& command);
+
+    void add(const std::string& command, const std::string& path); // pinned, like hash -p
+    void forget(const std::string& command);
+    void clear();
+
+    std::vector<std::pair<std::string, Entry>> getEntries() const;
+
+private:
+    static constexpr size_t MAX_MISSES = 256;
+
+    std::unordered_map<std::string, Entry> found;
+    std::unordered_set<std::string> missing;
+
+    std::string pathValue;
+    std::vector<std::string> dirs;
+    std::vector<std::filesystem::file_time_type> dirTimes;
+    bool cacheMisses = true; // off when PATH has relative dirs (they depend on the cwd)
+
+    void validate();
+    void loadPath(const std::string& value);
+    std::string search(const std::string& command, size_t& dirIndex) const;
+};
+
+CommandCache& getCommandCache();
+
+} // namespace olsh
+
+#endif //COMMAND_CACHE_H
@@ -2,20 +2,51 @@
 #define EXECUTOR_H
 
 #include <memory>
+#include <vector>
 #include "../parser/ast.h"
+#include "resource_usage.h"
+
+#ifndef _WIN32
+#include <thread>
+#include <sys/types.h>
+#endif
 
 namespace olsh {
 
 class Executor {
 private:
+    int executeNode(const Parser::ASTNode& node);
     int executeCommand(const Parser::Command& cmd);
     int executePipeline(const Parser::Pipeline& pipeline);
-    int executeRedirection(const Parser::Redirection& redirection);
+    int executeSequence(const Parser::Sequence& sequence);
+    int executeBackground(const Parser::Background& background);
+    int executeBuiltin(const Parser::Command& cmd);
+    int executeBuiltin(const std::string& name, const std::vector<std::string>& args,
+                       const RedirectPlan& redirects);
     int executeExternal(const Parser::Command& cmd);
 
+#ifndef _WIN32
+    // a builtin pipeline stage running on a thread of the shell instead of a forked child
+    struct StageThread {
+        std::thread thread;
+        size_t stage;
+        std::shared_ptr<int> result;
+        std::shared_ptr<ResourceUsage> usage; // the thread's own share (RUSAGE_THREAD)
+    };
+
+    // starts every stage of the pipeline, returns false if the last one couldn't be started.
+    // without threads every builtin stage gets forked (background jobs need real processes).
+    // lastOutFd is where a last stage that's a process writes, -1 keeps the shell's stdout
+    bool launchPipeline(const Parser::Pipeline& pipeline, int firstInFd,
+                        std::vector<pid_t>& pids, pid_t& pgid,
+                        std::vector<StageThread>* threads = nullptr, int lastOutFd = -1);
+    bool runsOnThread(const Parser::Pipeline& pipeline, size_t stage) const;
+#endif
+
 public:
     Executor();
-    int execute(std::unique_ptr<Parser::ASTNode> node);
+    // the tree is only borrowed, it can be a cached one that runs again later
+    int execute(const Parser::Tree& tree);
 };
 
 } // namespace olsh
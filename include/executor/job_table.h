@@ -0,0 +1,87 @@
+#ifndef JOB_TABLE_H
+#define JOB_TABLE_H
+
+#ifndef _WIN32
+
+#include "resource_usage.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <ostream>
+#include <sys/types.h>
+
+namespace olsh {
+
+// one process group started by the shell (a command or a whole pipeline)
+struct Job {
+    enum class State { RUNNING, STOPPED, DONE };
+
+    int id;
+    pid_t pgid;
+    std::vector<pid_t> pids;
+    std::vector<int> statuses; // raw waitpid status per pid, -1 while it's still running
+    State state = State::RUNNING;
+    int status = 0;            // exit status of the last pid once DONE, 128+sig while STOPPED
+    std::string command;
+    bool foreground;
+    std::vector<int> watches;  // event loop watch per pid, -1 once it's reaped
+    std::vector<ResourceUsage> usages; // what each pid used, filled in as they are reaped
+    std::chrono::steady_clock::time_point started;
+};
+
+// every job the shell still knows about. children are reaped from the event loop:
+// each process has a pidfd watch that collects it when it exits, and SIGCHLD (through
+// signalfd) is only used to notice stops and continues
+class JobTable {
+public:
+    JobTable();
+
+    Job& add(pid_t pgid, const std::vector<pid_t>& pids, const std::string& command, bool foreground);
+    void remove(int id);
+
+    Job* find(int id);
+    // %N, %%, %+, %-, %prefix or a pid. sets error when nothing matches
+    Job* resolve(const std::string& spec, std::string& error);
+    Job* current();
+    std::vector<Job*> list();
+
+    // handles whatever the event loop has pending (exits, stops) without blocking
+    void reap();
+    // runs the event loop until the job is done or stopped, returns its exit status
+    int wait(Job& job);
+    // interactive shells print finished jobs before the prompt and forget them
+    void reportDone(std::ostream& out);
+
+    // terminal hand-off for foreground jobs (only when the shell owns a terminal)
+    void giveTerminal(pid_t pgid);
+    void reclaimTerminal();
+    bool isInteractive() const { return interactive; }
+
+    void print(const Job& job, std::ostream& out, bool withPgid = false) const;
+    // a forked copy of the shell doesn't own any of these jobs
+    void resetAfterFork();
+
+    static int decodeStatus(int status);
+
+private:
+    static constexpr size_t MAX_DONE_JOBS = 256;
+
+    std::map<int, Job> jobs;
+    std::vector<int> recent; // job ids, most recently started/stopped last
+    bool interactive = false;
+
+    void collect(int id, size_t index);
+    // with all false only the foreground job is looked at
+    void checkStops(bool all);
+    void record(Job& job, size_t index, int status);
+    void touch(int id);
+};
+
+JobTable& getJobTable();
+
+} // namespace olsh
+
+#endif
+
+#endif //JOB_TABLE_H
@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <functional>
+#include "redirect.h"
+#include "job_table.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -15,14 +18,40 @@ namespace olsh {
 
 class Process {
 public:
-    int execute(const std::string& command, const std::vector<std::string>& args);
+    int execute(const std::string& command, const std::vector<std::string>& args,
+                const RedirectPlan& plan = {});
 
     static bool interruptActive();
 
     static bool isRunning();
 
+#ifndef _WIN32
+    // pipeline support: start a stage without waiting for it.
+    // inFd/outFd of -1 keep the shell's stdin/stdout, pgid 0 starts a new process group
+    // the redirection plan is applied in the child after the stdio setup
+    pid_t start(const std::string& command, const std::vector<std::string>& args,
+                pid_t pgid, int inFd, int outFd, const RedirectPlan& plan = {});
+    // same as start() but runs fn in a forked copy of the shell (for builtins).
+    // closeFd is an extra fd the child must not keep open (the next stage's read end)
+    pid_t startFunction(const std::function<int()>& fn, pid_t pgid,
+                        int inFd, int outFd, int closeFd = -1);
+    // wait for every pid in the group as a foreground job, returns the exit status of the last one.
+    // if it gets stopped (ctrl+z) it stays in the job table under command
+    int waitAll(const std::vector<pid_t>& pids, pid_t pgid, const std::string& command = "");
+    // gives the job the terminal and blocks until it exits or stops (also used by fg)
+    static int waitForeground(Job& job);
+#endif
+
 private:
     std::string buildCommandLine(const std::string& command, const std::vector<std::string>& args);
+#ifndef _WIN32
+    static bool useFork();
+    // -2 means the binary at path doesn't exist (ENOENT), -1 any other failure
+    static pid_t spawnChild(const std::string& path, std::vector<char*>& argv,
+                            pid_t pgid, int inFd, int outFd, const RedirectPlan& plan);
+    static void setupChild(pid_t pgid, int inFd, int outFd);
+    static bool applyPlan(const RedirectPlan& plan);
+#endif
 
     static std::atomic<bool> s_running;
 #ifdef _WIN32
@@ -0,0 +1,36 @@
+#ifndef REDIRECT_H
+#define REDIRECT_H
+
+#include <string>
+#include <vector>
+
+namespace olsh {
+
+// one step of a command's redirection plan, applied in order by whoever starts the command
+struct FdAction {
+    enum class Type {
+        READ,    // fd <  path
+        WRITE,   // fd >  path
+        APPEND,  // fd >> path
+        DUP      // fd >& sourceFd
+    };
+
+    int fd;
+    Type type;
+    std::string path;
+    int sourceFd;
+
+    FdAction(int target, Type t, const std::string& file)
+        : fd(target), type(t), path(file), sourceFd(-1) {}
+    FdAction(int target, int source)
+        : fd(target), type(Type::DUP), sourceFd(source) {}
+
+    // opens path for READ/WRITE/APPEND, returns the new fd or -1
+    int openTarget() const;
+};
+
+using RedirectPlan = std::vector<FdAction>;
+
+} // namespace olsh
+
+#endif //REDIRECT_H
@@ -0,0 +1,51 @@
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace olsh {
+
+// what one command (or pipeline stage) used, from wait4/getrusage
+struct ResourceUsage {
+    std::string command;       // empty when it isn't known (stages of a job continued with fg)
+    double real = 0;           // seconds
+    double user = 0;
+    double sys = 0;
+    long maxRss = 0;           // kB
+    long voluntarySwitches = 0;
+    long involuntarySwitches = 0;
+    long minorFaults = 0;
+    long majorFaults = 0;
+
+#ifndef _WIN32
+    static ResourceUsage fromRusage(const struct rusage& usage, double real);
+    // after - before, except maxRss which is a high-water mark and taken from after
+    static ResourceUsage between(const struct rusage& before, const struct rusage& after, double real);
+#endif
+    // sums the counters, keeps the bigger maxRss and real (stages run at the same time)
+    void add(const ResourceUsage& other);
+    // real=0.012 user=0.004 sys=0.001 maxrss=3456 nvcsw=2 nivcsw=0 minflt=120 majflt=0
+    std::string format() const;
+};
+
+// the last foreground external command or pipeline, one entry per stage
+void setLastUsage(std::vector<ResourceUsage> stages);
+const std::vector<ResourceUsage>& getLastUsage();
+// $OLSH_LAST_RUSAGE (the whole thing) and $OLSH_LAST_RUSAGE_STAGES (stages joined with " / "),
+// like $? they're made up when read and never go into the environment. false for any other
+// name, and before anything ran
+bool appendLastUsage(std::string& out, std::string_view name);
+// bumped by every setLastUsage(), so callers can tell if anything ran in between
+unsigned long getLastUsageGeneration();
+
+ResourceUsage totalUsage(const std::vector<ResourceUsage>& stages);
+
+} // namespace olsh
+
+#endif //RESOURCE_USAGE_H
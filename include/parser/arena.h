@@ -0,0 +1,76 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace olsh::Parser {
+
+// bump allocator for everything one parse produces. nodes, words and arrays are carved out of
+// a few big blocks and all freed together, objects that need it get their destructor run first
+class Arena {
+public:
+    Arena() = default;
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        } else {
+            auto* cleanup = static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+            T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            *cleanup = {[](void* p) { static_cast<T*>(p)->~T(); }, object, cleanups};
+            cleanups = cleanup;
+            return object;
+        }
+    }
+
+    // copies items in, the span stays valid as long as the arena does
+    template<typename T>
+    std::span<const T> copy(std::span<const T> items) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (items.empty()) return {};
+        T* data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        std::uninitialized_copy(items.begin(), items.end(), data);
+        return {data, items.size()};
+    }
+
+    // the copy is null-terminated, so data() can go straight into an argv
+    std::string_view copy(std::string_view text);
+
+    size_t bytesUsed() const;
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+    struct Cleanup {
+        void (*destroy)(void*);
+        void* object;
+        Cleanup* next;
+    };
+
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    Block* blocks = nullptr; // newest first, allocations come from the front one
+    Cleanup* cleanups = nullptr;
+
+    void* allocate(size_t size, size_t align);
+    void release();
+};
+
+} // namespace olsh::Parser
+
+#endif //ARENA_H
@@ -2,8 +2,11 @@
 #define AST_H
 
 #include <string>
+#include <string_view>
+#include <span>
 #include <vector>
-#include <memory>
+#include "arena.h"
+#include "../executor/redirect.h"
 
 namespace olsh::Parser {
 
@@ -11,42 +14,67 @@ enum class CommandType {
     BUILTIN,
     EXTERNAL,
     PIPELINE,
-    REDIRECTION
+    SEQUENCE,
+    BACKGROUND
 };
 
-class ASTNode {
-public:
-    virtual ~ASTNode() = default;
-    virtual CommandType getType() const = 0;
+// nodes are plain tagged structs living in the parse's Arena (no vtable, no unique_ptr).
+// the type is fixed when the node is made, a command is resolved to builtin/external right
+// there so the executor never has to ask the registry again
+struct ASTNode {
+    CommandType type;
+
+    CommandType getType() const { return type; }
+
+protected:
+    explicit ASTNode(CommandType t) : type(t) {}
 };
 
-class Command : public ASTNode {
-public:
-    std::string name;
-    std::vector<std::string> args;
+struct Command : ASTNode {
+    std::string_view name;                 // words are null-terminated copies in the arena
+    std::span<const std::string_view> args;
     bool skipBuiltinLookup;
+    RedirectPlan redirects; // applied by whoever starts the command, in order
 
-    Command(const std::string& cmdName, const std::vector<std::string>& arguments, bool skipBuiltin = {});
-    CommandType getType() const override;
+    Command(std::string_view cmdName, std::span<const std::string_view> arguments, bool skipBuiltin);
+
+    // builtins and Process still want owning strings
+    std::vector<std::string> argVector() const { return {args.begin(), args.end()}; }
 };
 
-class Pipeline : public ASTNode {
-public:
-    std::vector<std::unique_ptr<Command>> commands;
+struct Pipeline : ASTNode {
+    std::span<Command* const> commands;
 
-    Pipeline(std::vector<std::unique_ptr<Command>> cmds);
-    CommandType getType() const override;
+    explicit Pipeline(std::span<Command* const> cmds) : ASTNode(CommandType::PIPELINE), commands(cmds) {}
 };
 
-class Redirection : public ASTNode {
+// a ; b ; c - run one after another
+struct Sequence : ASTNode {
+    std::span<ASTNode* const> nodes;
+
+    explicit Sequence(std::span<ASTNode* const> items) : ASTNode(CommandType::SEQUENCE), nodes(items) {}
+};
+
+// a & - start without waiting for it
+struct Background : ASTNode {
+    ASTNode* node;
+
+    explicit Background(ASTNode* inner) : ASTNode(CommandType::BACKGROUND), node(inner) {}
+};
+
+// what a parse hands out: the root and the arena everything hangs off
+class Tree {
 public:
-    std::unique_ptr<ASTNode> command;
-    std::string filename;
-    bool append;
-    bool input;
+    Tree() = default;
+    Tree(Arena nodes, const ASTNode* node) : arena(std::move(nodes)), root(node) {}
+
+    explicit operator bool() const { return root != nullptr; }
+    const ASTNode& operator*() const { return *root; }
+    const ASTNode* get() const { return root; }
 
-    Redirection(std::unique_ptr<ASTNode> cmd, const std::string& file, bool isAppend = false, bool isInput = false);
-    CommandType getType() const override;
+private:
+    Arena arena;
+    const ASTNode* root = nullptr;
 };
 
 } // namespace olsh::Parser
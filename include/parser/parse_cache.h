@@ -0,0 +1,53 @@
+#ifndef PARSE_CACHE_H
+#define PARSE_CACHE_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "ast.h"
+
+namespace olsh {
+
+// parsed and resolved trees of recently run lines, keyed by the text the parser saw (after
+// alias expansion). a script loop runs the same few lines over and over, this way they are
+// only tokenized and parsed the first time. least recently used entries go first
+class ParseCache {
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t size;
+        size_t capacity;
+    };
+
+    // shared so a tree that is being executed survives getting evicted by what it runs
+    // (a script or time started from inside it)
+    std::shared_ptr<const Parser::Tree> find(std::string_view text);
+    std::shared_ptr<const Parser::Tree> insert(const std::string& text, Parser::Tree tree);
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    static constexpr size_t CAPACITY = 256;
+    // a pasted 1 MB line isn't going to be run again, don't keep it around
+    static constexpr size_t MAX_TEXT = 4096;
+
+    struct Entry {
+        std::string text;
+        std::shared_ptr<const Parser::Tree> tree;
+    };
+
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index; // views of Entry::text
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+ParseCache& getParseCache();
+
+} // namespace olsh
+
+#endif //PARSE_CACHE_H
@@ -12,17 +12,26 @@ class CommandParser {
 private:
     std::vector<Parser::Token> tokens;
     size_t current;
+    Parser::Arena* arena = nullptr; // the one the current parse builds into
+    bool failed = false; // set by syntaxError, the whole line is rejected
+
+    // scratch space reused by every parse, only the finished arrays are copied into the arena
+    std::vector<std::string_view> words;
+    std::vector<Parser::Command*> stages;
+    std::vector<Parser::ASTNode*> items;
 
     const Parser::Token& peek();
     const Parser::Token& advance();
     bool match(Parser::TokenType type);
-    std::unique_ptr<Parser::Command> parseCommand();
-    std::unique_ptr<Parser::Pipeline> parsePipeline();
-    std::unique_ptr<Parser::ASTNode> parseRedirection(std::unique_ptr<Parser::ASTNode> node);
+    void syntaxError(const Parser::Token& token);
+    Parser::Command* parseCommand();
+    Parser::ASTNode* parsePipeline();
+    Parser::ASTNode* parseList();
+    bool parseRedirect(RedirectPlan& plan);
 
 public:
     CommandParser();
-    std::unique_ptr<Parser::ASTNode> parse(const std::string& input);
+    Parser::Tree parse(const std::string& input);
 };
 
 } // namespace olsh
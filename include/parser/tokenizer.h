@@ -1,7 +1,11 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include <array>
+#include <cstdint>
+#include <forward_list>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace olsh::Parser {
@@ -12,6 +16,10 @@ enum class TokenType {
     REDIRECT_OUT,
     REDIRECT_IN,
     REDIRECT_APPEND,
+    REDIRECT_DUP,        // >&
+    REDIRECT_ALL,        // &>  (stdout and stderr)
+    REDIRECT_ALL_APPEND, // &>>
+    IO_NUMBER,           // the 2 in 2> file
     SEMICOLON,
     END_OF_INPUT,
     AMPERSAND,
@@ -19,29 +27,57 @@ enum class TokenType {
     CARET          // skips builtins. idk if i should rename this to like SKIP_BUILTINS but whatever
 };
 
+// value points into the input, or into the tokenizer when escapes had to be removed,
+// so tokens are only good while both of them are
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
 
-    Token(TokenType t, const std::string& v) : type(t), value(v) {}
+    Token(TokenType t, std::string_view v) : type(t), value(v) {}
 };
 
+// what a byte means to the tokenizer. every byte that isn't one of these is part of a word
+// (utf-8 included)
+namespace CharClass {
+    constexpr uint8_t SPACE    = 1 << 0;
+    constexpr uint8_t WORD_END = 1 << 1; // ends an unquoted word: space | > < ;
+    constexpr uint8_t OPERATOR = 1 << 2; // starts a token of its own: | > < ; & ^
+    constexpr uint8_t QUOTE    = 1 << 3;
+    constexpr uint8_t DIGIT    = 1 << 4;
+
+    constexpr std::array<uint8_t, 256> makeTable() {
+        std::array<uint8_t, 256> table{};
+        for (unsigned char c : std::string_view(" \t\n\v\f\r")) table[c] |= SPACE | WORD_END;
+        for (unsigned char c : std::string_view("|><;")) table[c] |= WORD_END | OPERATOR;
+        for (unsigned char c : std::string_view("&^")) table[c] |= OPERATOR;
+        table['"'] |= QUOTE;
+        table['\''] |= QUOTE;
+        for (unsigned char c = '0'; c <= '9'; ++c) table[c] |= DIGIT;
+        return table;
+    }
+
+    inline constexpr std::array<uint8_t, 256> TABLE = makeTable();
+
+    constexpr bool is(char c, uint8_t mask) {
+        return (TABLE[static_cast<unsigned char>(c)] & mask) != 0;
+    }
+}
+
 class Tokenizer {
 private:
-    std::string input;
+    std::string_view input;
     size_t position;
-    size_t length;
+    // quoted strings with escapes in them, the only values that can't be a view of the input
+    std::forward_list<std::string> unescaped;
 
-    char currentChar();
-    char peek();
-    void advance();
-    void skipWhitespace();
-    std::string readWord();
-    std::string readQuotedString(char quote);
+    std::string_view readWord();
+    std::string_view readQuotedString(char quote);
 
 public:
-    Tokenizer(const std::string& input);
+    explicit Tokenizer(std::string_view input);
     std::vector<Token> tokenize();
+    // same, into a vector the caller keeps around
+    void tokenize(std::vector<Token>& tokens);
 };
 
 } // namespace olsh::Parser
@@ -0,0 +1,60 @@
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace olsh::Utils {
+
+// what's inside $((...)) and ((...)), parsed once into a tree of nodes in a flat vector.
+// variables are interned symbols, evaluating never touches the text again.
+// operators are the C ones (bash's set): , = += -= *= /= %= <<= >>= &= ^= |= ?: || && | ^ &
+// == != < <= > >= << >> + - * / % ** ! ~ unary - + and ++ -- on both sides
+class ArithExpr {
+public:
+    // where the values of variables and $1, $#, $? come from
+    struct Context {
+        virtual long long get(uint32_t symbol) = 0;
+        virtual void set(uint32_t symbol, long long value) = 0;
+        virtual long long positional(uint32_t index) = 0;
+        virtual long long argumentCount() = 0;
+        virtual long long status() = 0;
+        virtual ~Context() = default;
+    };
+
+    // false with a message in error if text isn't a valid expression
+    static bool compile(std::string_view text, ArithExpr& out, std::string& error);
+
+    long long evaluate(Context& context) const;
+
+private:
+    enum class Op : uint8_t {
+        NUMBER, VARIABLE, POSITIONAL, ARG_COUNT, STATUS,
+        NEGATE, NOT, BIT_NOT, PRE_INC, PRE_DEC, POST_INC, POST_DEC,
+        POW, MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+        LT, LE, GT, GE, EQ, NE, BIT_AND, BIT_XOR, BIT_OR, AND, OR,
+        TERNARY, ASSIGN, COMMA
+    };
+
+    struct Node {
+        Op op;
+        Op combine = Op::NUMBER; // ASSIGN: the operator of += and friends, NUMBER for plain =
+        uint32_t lhs = 0, rhs = 0, third = 0; // children, third is the else of ?:
+        long long value = 0;     // NUMBER: the number, VARIABLE: the symbol, POSITIONAL: the index
+    };
+
+    std::vector<Node> nodes;
+    uint32_t root = 0;
+
+    static long long apply(Op op, long long a, long long b);
+    long long eval(uint32_t node, Context& context) const;
+
+    friend class ArithCompiler;
+    friend struct ArithCodec; // the compiled-script cache
+};
+
+} // namespace olsh::Utils
+
+#endif //ARITHMETIC_H
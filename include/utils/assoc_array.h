@@ -0,0 +1,42 @@
+#ifndef ASSOC_ARRAY_H
+#define ASSOC_ARRAY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace olsh::Utils {
+
+// what declare -A makes, strings by string. open addressing: a power of two table of
+// indices probed linearly, never more than half full. the entries themselves are one
+// vector in the order their keys were added, so ${map[@]} comes out the way it went in
+// and walking the map is walking that vector
+class AssocArray {
+public:
+    struct Entry {
+        std::string key;
+        std::string value;
+        size_t hash;
+    };
+
+    const std::string* find(std::string_view key) const;
+    // a key that isn't there yet is added with an empty value
+    std::string& operator[](std::string_view key);
+
+    const std::vector<Entry>& entries() const { return items; }
+    size_t size() const { return items.size(); }
+    void clear();
+
+private:
+    std::vector<Entry> items;
+    std::vector<uint32_t> slots; // index into items + 1, 0 is a free slot
+
+    // the slot key is in, or the free one where it would go
+    size_t probe(std::string_view key, size_t hash) const;
+    void grow();
+};
+
+} // namespace olsh::Utils
+
+#endif //ASSOC_ARRAY_H
@@ -0,0 +1,90 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#ifndef _WIN32
+
+#include <functional>
+#include <map>
+#include <chrono>
+#include <signal.h>
+#include <sys/types.h>
+
+namespace olsh::Utils {
+
+// what the kernel told us about a signal. pid/code are only known on linux (0 otherwise)
+struct SignalEvent {
+    int signal;
+    pid_t pid;
+    int code; // CLD_EXITED, CLD_STOPPED, ... for SIGCHLD
+};
+
+// the shell's single-threaded reactor. terminal input, child exits (pidfd), signals (signalfd)
+// and timers all come through one epoll fd and the callbacks run inside runOnce(), so they can
+// touch shell state without atomics or locks. other unix systems get the same thing on poll()
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+    using SignalCallback = std::function<void(const SignalEvent&)>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // every watch returns an id for remove()
+    int watchFd(int fd, Callback onReadable);
+    // fires once when the child exits, the callback still has to reap it
+    int watchChild(pid_t pid, Callback onExit);
+    // the signal stays blocked from now on and only arrives through the loop
+    int watchSignal(int sig, SignalCallback onSignal);
+    int addTimer(std::chrono::milliseconds delay, Callback onExpire, bool repeat = false);
+    void remove(int id);
+
+    // waits up to timeoutMs (-1 forever, 0 only checks) and runs everything that's ready.
+    // returns false if nothing was
+    bool runOnce(int timeoutMs = -1);
+    void runUntil(const std::function<bool()>& done);
+    bool poll() { return runOnce(0); }
+
+    // a forked child starts over with an empty loop and the default signal mask
+    void resetAfterFork();
+
+private:
+    enum class Kind { FD, CHILD, SIGNAL, TIMER };
+
+    struct Source {
+        Kind kind;
+        int fd = -1;          // what the backend watches, pidfds and timerfds belong to the loop
+        bool ownsFd = false;
+        pid_t pid = -1;
+        int signal = 0;
+        Callback callback;
+        SignalCallback signalCallback;
+        std::chrono::milliseconds interval{0};
+        bool repeat = false;
+        std::chrono::steady_clock::time_point deadline; // timers without timerfd
+    };
+
+    std::map<int, Source> sources;
+    int nextId = 1;
+    sigset_t signals;
+    int backendFd = -1;          // epoll fd (linux only)
+    int signalFd = -1;           // signalfd on linux, read end of the self-pipe elsewhere
+    bool checkChildrenNext = false;
+
+    int addSource(Source source);
+    void blockSignal(int sig);
+    void dispatch(int id);
+    void dispatchSignals();
+    void checkChildren();
+    void closeAll();
+};
+
+EventLoop& getEventLoop();
+
+} // namespace olsh::Utils
+
+#endif
+
+#endif //EVENT_LOOP_H
@@ -0,0 +1,37 @@
+#ifndef FD_STREAM_H
+#define FD_STREAM_H
+
+#include <streambuf>
+#include <vector>
+
+namespace olsh::Utils {
+
+// streambuf that reads/writes a raw file descriptor directly (no stdio buffer in between)
+class FdStreamBuf : public std::streambuf {
+private:
+    int fd;
+    bool ownsFd;
+    std::vector<char> inBuffer;
+    std::vector<char> outBuffer;
+
+    bool flushOut();
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+public:
+    // with closeOnDestroy the fd is closed together with the buffer
+    explicit FdStreamBuf(int fd, bool closeOnDestroy = false, size_t bufferSize = 64 * 1024);
+    ~FdStreamBuf() override;
+
+    FdStreamBuf(const FdStreamBuf&) = delete;
+    FdStreamBuf& operator=(const FdStreamBuf&) = delete;
+
+    int getFd() const { return fd; }
+};
+
+} // namespace olsh::Utils
+
+#endif //FD_STREAM_H
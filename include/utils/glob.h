@@ -0,0 +1,52 @@
+#ifndef GLOB_H
+#define GLOB_H
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace olsh::Utils {
+
+// a shell pattern: * ? [abc] [!a-z] and \x or quotes for literal text. parsed once into
+// steps, matching walks those and backtracks only to the last * it went past. a pattern
+// without wildcards is just its text and the searches below turn into plain finds
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string_view pattern);
+
+    // all of s
+    bool matches(std::string_view s) const;
+    // length of the shortest or longest prefix of s that matches, npos if none does
+    size_t prefix(std::string_view s, bool longest) const;
+    // where the shortest or longest matching suffix of s starts, npos if none does
+    size_t suffix(std::string_view s, bool longest) const;
+    // the first non-empty match at or after from, the longest one starting there
+    bool find(std::string_view s, size_t from, size_t& at, size_t& length) const;
+
+    bool literal() const { return !wild; }
+
+private:
+    enum class Kind : uint8_t { LITERAL, ANY, STAR, SET };
+    struct Step {
+        Kind kind;
+        uint32_t index = 0; // LITERAL: offset in text, SET: which of sets
+        uint32_t size = 0;  // LITERAL: length
+    };
+
+    std::vector<Step> steps;
+    std::string text;                   // the literal runs, back to back
+    std::vector<std::bitset<256>> sets; // [...] classes
+    size_t least = 0;                   // chars any match needs
+    bool wild = false;                  // anything but literals
+    bool star = false;                  // matches of more than one length
+
+    // cheap checks of a candidate before matching it: it has to start with the first
+    // literal and end with the last one when the pattern does
+    bool plausible(std::string_view s) const;
+};
+
+} // namespace olsh::Utils
+
+#endif //GLOB_H
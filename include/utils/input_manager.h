@@ -13,6 +13,12 @@ class InputManager {
 private:
     static std::unique_ptr<InputManager> instance;
     static olsh::Shell* shell_instance;
+
+#ifndef _WIN32
+    enum class InputWait { READY, INTERRUPTED, TIMED_OUT };
+    // runs the event loop until the terminal has input, ctrl+c or $TMOUT runs out
+    InputWait waitForInput();
+#endif
     
 public:
     InputManager();
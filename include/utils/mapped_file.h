@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace olsh::Utils {
+
+// a whole file mapped read-only, read straight out of the page cache instead of being copied
+// into a buffer first. windows, and anything mmap refuses, gets read into a string instead
+class MappedFile {
+private:
+    const char* mapped = nullptr;
+    size_t length = 0;
+    std::string fallback;
+
+    void unmap();
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if it couldn't be opened, an empty file maps fine (to nothing)
+    bool open(const std::string& path);
+
+    std::string_view data() const {
+        return mapped ? std::string_view(mapped, length) : std::string_view(fallback);
+    }
+};
+
+} // namespace olsh::Utils
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,171 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace olsh::Utils {
+
+// where a script spends its time, per source line and per function (olshell --profile, or
+// set -o profile). the VM reads the clock once per instruction, each reading closes the slice
+// of whatever ran since the last one (exclusive time) and the previous instruction of the
+// same chunk (inclusive time, function calls and all). forks, substitutions and expansion
+// get a reading before and after. with it off all of it is one branch on active()
+class ScriptProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Ticks = uint64_t;
+
+    // a reading of the clock. the cycle counter where there is one, it costs half of what
+    // steady_clock does and report() works out how long a tick was from the run itself
+    static Ticks now() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (Ticks)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    enum class Category : uint8_t { FORK, SUBSTITUTION, EXPANSION, COUNT };
+
+    struct LineStats {
+        uint64_t count = 0;
+        Ticks inclusive = 0;
+        Ticks exclusive = 0;
+        Ticks spent[(size_t)Category::COUNT]{};
+    };
+
+    struct FunctionStats {
+        uint64_t calls = 0;
+        Ticks inclusive = 0;
+        Ticks exclusive = 0;
+        uint32_t running = 0; // calls of it on the stack, a recursive one counts once
+    };
+
+    // what a running chunk keeps between its instructions. the inclusive time of a line in a
+    // recursive function counts the calls inside it again, like most profilers do
+    struct Cursor {
+        std::vector<LineStats>* lines = nullptr; // of the chunk's file, indexed by line
+        uint32_t line = 0;                       // of the instruction running now, 0 before the first
+        Ticks started = 0;                       // of that instruction
+        // what was running when the chunk started, it's running again when the chunk is done
+        std::vector<LineStats>* callerLines = nullptr;
+        uint32_t callerLine = 0;
+    };
+
+    // forks, substitutions and expansion. the time goes to the line running right now
+    class Span {
+    public:
+        Span(ScriptProfiler& p, Category c) : profiler(p), category(c), on(p.active()) {
+            if (on) {
+                profiler.open[(size_t)category]++;
+                started = now();
+            }
+        }
+        ~Span() {
+            if (on) profiler.spend(category, now() - started);
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        ScriptProfiler& profiler;
+        Category category;
+        bool on;
+        Ticks started = 0;
+    };
+
+    bool active() const { return on; }
+    // starting again keeps what was collected, stopping keeps it for report()
+    void start();
+    void stop();
+    bool hasData() const { return !files.empty(); }
+
+    // where report() goes: empty for a table on stderr, a path for JSON in that file
+    void setOutput(std::string path) { output = std::move(path); }
+
+    // the VM calls these for every chunk it runs and every instruction in it. enter() only
+    // remembers where the chunk was called from, the first step() starts the clock on it
+    void enter(Cursor& cursor, const std::string& file);
+    void step(Cursor& cursor, uint32_t line) {
+        Ticks at = now();
+        slice(at);
+        auto& lines = *cursor.lines;
+        // a cursor from before the last start() has been idle while the profiler wasn't looking
+        if (cursor.line && cursor.started >= started) lines[cursor.line].inclusive += at - cursor.started;
+        if (line >= lines.size()) lines.resize(line + 1);
+        lines[line].count++;
+        cursor.line = line;
+        cursor.started = at;
+        currentLines = cursor.lines;
+        currentLine = line;
+    }
+    void leave(Cursor& cursor);
+
+    // around a script function call, the time between them is its inclusive time
+    void enterFunction(const std::string& name);
+    void leaveFunction();
+
+    // the outermost script reports what was collected once it's done, whichever
+    // interpreter runs it
+    void enterScript() { scripts++; }
+    void leaveScript();
+
+    // writes everything collected so far and starts over
+    void report();
+
+private:
+    struct Call {
+        FunctionStats* function;
+        Ticks started;
+    };
+
+    bool on = false;
+    std::string output;
+    uint32_t scripts = 0;
+    std::unordered_map<std::string, std::vector<LineStats>> files;
+    std::unordered_map<std::string, FunctionStats> functions;
+    std::vector<Call> calls;
+    Ticks spentTotal[(size_t)Category::COUNT]{};
+    uint32_t open[(size_t)Category::COUNT]{}; // spans running, only the outermost one adds to the total
+    // the runs before the current one, in ticks and in real time to tell how long a tick is
+    Ticks elapsed = 0;
+    Clock::duration elapsedTime{};
+    Ticks started = 0; // of the current run
+    Clock::time_point startedTime;
+
+    // whatever gets the next slice of exclusive time
+    std::vector<LineStats>* currentLines = nullptr;
+    uint32_t currentLine = 0;
+    Ticks last = 0;
+
+    FunctionStats* topLevel = nullptr; // the script itself, outside any function
+
+    // whatever ran since the last reading gets the time as its own
+    void slice(Ticks at) {
+        Ticks time = at - last;
+        last = at;
+        if (currentLines) (*currentLines)[currentLine].exclusive += time;
+        (calls.empty() ? topLevel : calls.back().function)->exclusive += time;
+    }
+    void spend(Category category, Ticks time);
+    // msPerTick turns ticks into milliseconds
+    void printTable(std::ostream& out, Ticks total, double msPerTick) const;
+    void writeJson(std::ostream& out, Ticks total, double msPerTick) const;
+};
+
+ScriptProfiler& getProfiler();
+
+} // namespace olsh::Utils
+
+#endif //PROFILER_H
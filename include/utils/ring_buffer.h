@@ -0,0 +1,78 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace olsh::Utils {
+
+// bounded single-producer/single-consumer byte queue between two threads of the shell.
+// the data path is just two counters, no locks. a side that can't move blocks on the
+// other side's event counter (futex via atomic wait) instead of spinning
+class RingBuffer {
+private:
+    std::vector<char> buffer;
+    size_t mask;
+
+    // bytes written/read so far, each only moved by its own side
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+
+    // bumped on every commit and close so a sleeping peer wakes up
+    alignas(64) std::atomic<uint32_t> produced{0};
+    alignas(64) std::atomic<uint32_t> consumed{0};
+
+    std::atomic<bool> writerClosed{false};
+    std::atomic<bool> readerClosed{false};
+
+    static_assert(std::atomic<size_t>::is_always_lock_free);
+
+public:
+    // capacity gets rounded up to a power of two
+    explicit RingBuffer(size_t capacity = 64 * 1024);
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // blocks while full. returns less than size once the reader is gone (like EPIPE)
+    size_t write(const char* data, size_t size);
+    // blocks while empty. returns 0 once the writer is gone and everything was read
+    size_t read(char* data, size_t size);
+
+    void closeWrite();
+    void closeRead();
+};
+
+// one end of a RingBuffer as a streambuf, the end is closed when it goes away
+class RingStreamBuf : public std::streambuf {
+public:
+    enum class End { READ, WRITE };
+
+private:
+    std::shared_ptr<RingBuffer> ring;
+    End end;
+    std::vector<char> local; // batches small writes/reads so the counters move once per chunk
+
+    bool flushOut();
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+public:
+    RingStreamBuf(std::shared_ptr<RingBuffer> ring, End end, size_t bufferSize = 16 * 1024);
+    ~RingStreamBuf() override;
+
+    RingStreamBuf(const RingStreamBuf&) = delete;
+    RingStreamBuf& operator=(const RingStreamBuf&) = delete;
+};
+
+} // namespace olsh::Utils
+
+#endif //RING_BUFFER_H
@@ -1,10 +1,18 @@
 #ifndef SCRIPT_H
 #define SCRIPT_H
 
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <sstream>
+#include "script_program.h"
+#include "script_compiler.h"
+#include "script_cache.h"
+#include "assoc_array.h"
+#include "glob.h"
+#include "fd_stream.h"
+#include "streams.h"
 
 namespace olsh {
     class Shell;
@@ -13,36 +21,136 @@ namespace olsh {
 namespace olsh::Utils {
 
 struct FunctionDef {
-    std::vector<std::string> body; // lines
+    std::shared_ptr<const ScriptProgram> program; // kept alive for as long as the function is defined
+    uint32_t chunk = 0;
 };
 
 class ScriptInterpreter {
 private:
+    static constexpr int MAX_DEPTH = 1000; // function calls, a runaway recursion stops here
+    static constexpr size_t MAX_ELEMENTS = 1 << 24; // arrays are contiguous, a[1000000000] = x is refused
+    static constexpr size_t MAX_PATTERNS = 256;     // compiled ${v#pattern}s kept around
+
+    // numbers stay numbers until something needs them as text. arrays are never exported,
+    // used as a plain $NAME they're their element 0
+    struct Variable {
+        enum class Type : uint8_t { UNSET, STRING, INTEGER, ARRAY, ASSOC };
+        Type type = Type::UNSET;
+        bool exported = false; // also in the environment, for the commands the script runs
+        long long number = 0;
+        std::string text;
+        std::vector<std::string> items; // ARRAY, by index. a gap left by a[9] = x is empty strings
+        AssocArray map;                 // ASSOC
+    };
+
+    // a function call. local saves what its names meant before, returning puts that back
+    struct Frame {
+        std::vector<std::pair<uint32_t, Variable>> saved;
+    };
+
     olsh::Shell* shell;
-    std::unordered_map<std::string, std::string> variables; // global vars
+    std::vector<Variable> variables; // global vars, indexed by symbol
     std::unordered_map<std::string, FunctionDef> functions;
+    int depth = 0; // chunks running right now, the script itself and every call on top of it
+
+    // what read reads, a buffer per fd kept from one read to the next. a while read loop
+    // costs a read(2) per 64K of input instead of one per byte
+    struct Input {
+        FdStreamBuf buffer;
+        std::istream stream;
+        Input(int fd, bool owned) : buffer(fd, owned), stream(&buffer) {}
+    };
+    std::unordered_map<int, std::unique_ptr<Input>> inputs;
+    // files of the done < FILE loops running right now, innermost last. they're stdin for
+    // read and the builtins in the loop
+    std::vector<std::pair<int, std::unique_ptr<StreamScope>>> redirected;
+    std::istream* scriptInput = nullptr; // the script itself when it comes from stdin, read shares it
+
+    class ArithScope; // what $((...)) sees: the variables, the args and $?
+
+    // variables, the ones that were never set fall back to the environment
+    const Variable* findVariable(uint32_t symbol) const;
+    void appendVariable(std::string& out, std::string_view name) const;
+    long long numericVariable(uint32_t symbol) const;
+    Variable& slot(uint32_t symbol);
+    void setVariable(uint32_t symbol, std::string value);
+    void setVariable(uint32_t symbol, long long value);
+    void exportVariable(uint32_t symbol);
+    // local, export and declare lines: [-a|-A] NAME = value, NAME=value or just NAMEs
+    int declare(const std::string& text, ScriptOp op, Frame* frame);
+    // NAME, NAME[SUB] or either with a + on the end to append. a value in ( ) is a list of
+    // elements, [KEY]=value ones included
+    int assign(std::string_view target, std::string value, const char* what);
+    int assignList(uint32_t symbol, std::string_view list, bool append, const char* what);
+    int assignElement(uint32_t symbol, std::string_view sub, std::string value, bool append, const char* what);
+    // makes symbol an ARRAY if it isn't one, with what it was as element 0 if keep
+    Variable& toArray(uint32_t symbol, bool keep);
+    // index into symbol's elements, arithmetic and negative from the end. false if it's
+    // not a number or before the first one
+    bool arrayIndex(uint32_t symbol, std::string_view sub, size_t& index);
+    // a[i + 1], ${s:n:2}: a number or arithmetic, with nothing left to expand in it by now
+    bool arithmeticValue(std::string_view text, long long& value);
+    // ${NAME[SUB]}, SUB @ or * for all of them
+    void appendElement(std::string& out, uint32_t symbol, std::string_view sub);
+    // what for X in "${NAME[@]}" walks, the keys for "${!NAME[@]}"
+    std::vector<std::string> arrayValues(uint32_t symbol, bool keys) const;
+    void leave(Frame& frame);
 
     // helpers
-    std::string expandLine(const std::string& line,
-                           int lastExitCode,
-                           const std::vector<std::string>& args);
-    std::string substituteBackticks(const std::string& line,
-                                    int lastExitCode,
-                                    const std::vector<std::string>& args);
-    std::string expandVariables(const std::string& line,
-                                int lastExitCode,
-                                const std::vector<std::string>& args);
-    std::string expandArithmetic(const std::string& line);
-    long long evalArithmetic(const std::string& expr);
+    std::string expansion; // what expandLine hands out, reused so a line doesn't allocate
+    // the text itself when there's nothing to expand, otherwise expansion. only good until
+    // the next expandLine
+    const std::string& expandLine(const ScriptText& text,
+                                  int lastExitCode,
+                                  const std::vector<std::string>& args);
+    void expandInto(std::string& out,
+                    const ScriptText& text,
+                    size_t from,
+                    size_t to,
+                    int lastExitCode,
+                    const std::vector<std::string>& args);
+    // the inside of a ${...}: a variable, an element or one of them with an operator,
+    // ${v%pattern}, ${v:-word}, ${v:1:2} ...
+    std::unordered_map<std::string, GlobPattern> patterns;
+    const GlobPattern& glob(const std::string& pattern);
+    void expandBraced(std::string& out,
+                      const ScriptText& text,
+                      size_t from,
+                      size_t to,
+                      int lastExitCode,
+                      const std::vector<std::string>& args);
+    // stdout of a $(...) or `...`, which never forks for a builtin or a function
+    std::string captureCommand(const std::string& cmd);
+    long long evalArithmetic(const ArithExpr& expr,
+                             int lastExitCode,
+                             const std::vector<std::string>& args);
     bool evalCondition(const std::string& cond, int lastExitCode,
                        const std::vector<std::string>& args);
 
-    int executeBlock(const std::vector<std::string>& lines,
-                     std::vector<std::string> args,
-                     int depth = 0);
-    int executeLines(std::istringstream& stream,
-                     std::vector<std::string> args,
-                     int depth = 0);
+    // read [-r] [-d DELIM] [-u FD] [NAME...], 1 at the end of the input
+    int read(const std::string& text);
+    std::istream* input(int fd); // -1 for stdin, nullptr if fd isn't open
+    bool openInput(const std::string& file);
+    void closeInput();
+
+    // a script function with the words after its name, on a frame of its own
+    int callFunction(const std::string& name, FunctionDef function, const std::vector<std::string>& args);
+    // set -x, an instruction with what it came to after expansion
+    void trace(const ScriptProgram& program, const ScriptInstruction& ins, std::string_view text);
+    void trace(const ScriptProgram& program, const ScriptInstruction& ins, std::string_view word, std::string_view text);
+
+    // the VM, runs one chunk of a compiled script. status is what $? is when it starts
+    int execute(const std::shared_ptr<const ScriptProgram>& program,
+                uint32_t chunk,
+                const std::vector<std::string>& args,
+                Frame* frame,
+                int status = 0);
+    int runLine(const std::string& line);
+    // compiled collects every statement's program along the way, for the script cache
+    int run(ScriptStream& stream,
+            const std::string& name,
+            const std::vector<std::string>& args,
+            ScriptCache::Statements* compiled = nullptr);
 
 public:
     ScriptInterpreter(olsh::Shell* shellInstance);
@@ -54,6 +162,9 @@ public:
     int executeScriptContent(const std::string& content);
     int executeScriptContent(const std::string& content,
                              const std::vector<std::string>& args);
+    // a script that's read while it runs, from a pipe for example
+    int executeStream(std::istream& input, const std::string& name,
+                      const std::vector<std::string>& args);
 };
 
 } // namespace olsh::Utils
@@ -0,0 +1,55 @@
+#ifndef SCRIPT_CACHE_H
+#define SCRIPT_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "script_program.h"
+
+namespace olsh::Utils {
+
+// compiled scripts on disk under ~/.olshell/scripts, one file per script. running an
+// unchanged script again loads what the compiler made last time and skips reading and
+// compiling it. an entry only counts for the same path, size and mtime and for the same
+// VERSION of the interpreter, anything else is a miss and gets overwritten
+class ScriptCache {
+public:
+    // bump whenever ScriptOp, ScriptProgram, ArithExpr or what the compiler emits changes
+    static constexpr uint32_t VERSION = 5;
+    // bigger scripts are streamed and not kept, neither in memory nor in here
+    static constexpr uint64_t MAX_SCRIPT_SIZE = 4 * 1024 * 1024;
+
+    struct Key {
+        std::string path; // absolute
+        uint64_t size = 0;
+        int64_t mtime = 0; // nanoseconds
+    };
+
+    // the statements of a script the way ScriptStream compiled them, in order
+    using Statements = std::vector<std::shared_ptr<const ScriptProgram>>;
+
+    ScriptCache();
+
+    // off without a home directory or with OLSH_SCRIPT_CACHE=0
+    bool enabled() const { return !directory.empty(); }
+
+    // false if the file can't be looked at
+    static bool keyFor(const std::string& path, Key& key);
+
+    // name is what the loaded programs are called, the same as when the script is compiled
+    bool load(const Key& key, const std::string& name, Statements& statements) const;
+    // best effort, a cache that can't be written is just a cache that always misses
+    void store(const Key& key, const Statements& statements) const;
+
+private:
+    std::string directory;
+
+    std::string entryPath(const Key& key) const;
+};
+
+ScriptCache& getScriptCache();
+
+} // namespace olsh::Utils
+
+#endif //SCRIPT_CACHE_H
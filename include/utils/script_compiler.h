@@ -0,0 +1,48 @@
+#ifndef SCRIPT_COMPILER_H
+#define SCRIPT_COMPILER_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "script_program.h"
+
+namespace olsh::Utils {
+
+struct ScriptSyntaxError {
+    uint32_t line = 0;
+    std::string message;
+};
+
+// turns script text into a ScriptProgram. on a syntax error (a block without its fi/done/},
+// a stray keyword) it returns false and fills in error, nothing of the script should run then
+bool compileScript(std::string_view source, ScriptProgram& program, ScriptSyntaxError& error);
+
+// compiles a script one top-level statement at a time so it can run while the rest is still
+// being read (a pipe, a generated script too big to hold). only the lines of the statement
+// being compiled are kept, memory goes with how deep the blocks nest and not with the script
+class ScriptStream {
+public:
+    explicit ScriptStream(std::istream& in); // read as far as each statement needs, never ahead
+    explicit ScriptStream(std::string_view source);
+    ~ScriptStream();
+
+    ScriptStream(const ScriptStream&) = delete;
+    ScriptStream& operator=(const ScriptStream&) = delete;
+
+    // the next statement as chunk 0 of program (which is cleared first), functions it defines
+    // get chunks after it. false at the end of the script, or with error filled in if the
+    // statement is broken
+    bool next(ScriptProgram& program, ScriptSyntaxError& error);
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+// finds and compiles the $((...)) in raw and notes whether there's anything to expand at all
+bool compileText(std::string raw, ScriptText& out, std::string& error);
+
+} // namespace olsh::Utils
+
+#endif //SCRIPT_COMPILER_H
@@ -0,0 +1,70 @@
+#ifndef SCRIPT_PROGRAM_H
+#define SCRIPT_PROGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "arithmetic.h"
+
+namespace olsh::Utils {
+
+// what a .olsh script is compiled to. control flow is flattened into jumps once, the VM in
+// ScriptInterpreter only walks the instructions and never looks at the keywords again.
+// text operands are still expanded at run time, only the structure (and arithmetic) is
+// resolved up front
+enum class ScriptOp : uint8_t {
+    RUN,               // a: text. expanded, then a function call or a line for the shell
+    SET,               // a: text after "set ", expanded and split at the =
+    LOCAL,             // a: text after "local ", same as SET but only until the function returns
+    EXPORT,            // a: text after "export ", same as SET and put in the environment
+    ARITH,             // a: expression of a (( ... )) line, $? is 0 when it isn't 0
+    JUMP,              // b: target
+    JUMP_UNLESS,       // a: condition text, b: target when it doesn't hold
+    JUMP_UNLESS_ARITH, // a: expression of a (( ... )) condition, b: target when it's 0
+    FOR_BEGIN,         // a: list text, expanded and split into the values of the loop
+    FOR_NEXT,          // a: symbol of the variable, b: target once the values are used up
+    FUNCTION,          // a: text with the name, b: chunk with the body
+    STATUS,            // a: the value $? gets (an if where no branch ran leaves 0)
+    READ,              // a: text after "read", the options and names. $? is 1 at the end of the input
+    JUMP_UNLESS_OK,    // b: target when $? isn't 0 (a while read ... condition)
+    INPUT_BEGIN,       // a: file of a done < FILE loop, what read reads until INPUT_END. b: past the loop when it can't be opened
+    INPUT_END,
+    FOR_ARRAY,         // a: symbol of the array a for ... in "${NAME[@]}" walks as it is, b: 1 for its keys, "${!NAME[@]}"
+    DECLARE,           // a: text after "declare", NAMEs or NAME = value and -a or -A for arrays
+};
+
+struct ScriptInstruction {
+    ScriptOp op;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t line = 0; // in the source, for messages
+};
+
+// a $((...)) inside a text, [begin, end) is all of it from the $ to the last )
+struct ScriptArith {
+    size_t begin;
+    size_t end;
+    ArithExpr expr;
+};
+
+struct ScriptText {
+    std::string raw;
+    std::vector<ScriptArith> arith; // in order of begin
+    bool plain = false;             // no $ or ` in raw, it expands to itself
+};
+
+struct ScriptChunk {
+    std::vector<ScriptInstruction> code;
+};
+
+struct ScriptProgram {
+    std::string name;               // file the script came from, for messages
+    std::vector<ScriptText> texts;  // every operand string, instructions index into it
+    std::vector<ArithExpr> exprs;   // (( ... )) lines and conditions
+    std::vector<std::string> exprSources; // what each of exprs looked like, for set -x
+    std::vector<ScriptChunk> chunks; // 0 is the script itself, the rest are function bodies
+};
+
+} // namespace olsh::Utils
+
+#endif //SCRIPT_PROGRAM_H
@@ -0,0 +1,40 @@
+#ifndef STREAMS_H
+#define STREAMS_H
+
+#include <istream>
+#include <ostream>
+
+namespace olsh::Utils {
+
+// builtins read and write through these instead of std::cin/std::cout/std::cerr.
+// normally they're exactly those, but a builtin with redirections or one running as a
+// pipeline stage on its own thread gets different ones for the calling thread only
+std::istream& in();
+std::ostream& out();
+std::ostream& err();
+
+// the fd behind in()/out() so data can be moved without going through the stream, -1 if
+// there's none (ring buffers, string streams) or in() still has something buffered.
+// out() gets flushed first so anything written to the fd comes after what's already there
+int inFd();
+int outFd();
+
+// points the calling thread's in()/out()/err() somewhere else until it goes away.
+// nullptr keeps what's there now
+class StreamScope {
+private:
+    std::istream* savedIn;
+    std::ostream* savedOut;
+    std::ostream* savedErr;
+
+public:
+    StreamScope(std::istream* in, std::ostream* out, std::ostream* err);
+    ~StreamScope();
+
+    StreamScope(const StreamScope&) = delete;
+    StreamScope& operator=(const StreamScope&) = delete;
+};
+
+} // namespace olsh::Utils
+
+#endif //STREAMS_H
@@ -0,0 +1,33 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace olsh::Utils {
+
+// variable names interned to small numbers. scripts are compiled against these, so a
+// variable is a slot index at run time instead of a string to hash
+class SymbolTable {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t intern(std::string_view name);
+    // NONE for names nothing was ever interned under, doesn't add them
+    uint32_t find(std::string_view name) const;
+    const std::string& name(uint32_t symbol) const { return names[symbol]; }
+    size_t size() const { return names.size(); }
+
+private:
+    std::deque<std::string> names; // a deque so the views in ids stay valid
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+SymbolTable& getSymbols();
+
+} // namespace olsh::Utils
+
+#endif //SYMBOLS_H
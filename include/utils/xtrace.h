@@ -0,0 +1,56 @@
+#ifndef XTRACE_H
+#define XTRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "fd_stream.h"
+
+namespace olsh::Utils {
+
+// set -x. every command is written out after expansion, one line each:
+//
+//   ++ +0.000412s lib.olsh:12: echo hello
+//
+// a + per level of nesting (the script, every function call and substitution on top of it),
+// the time since the line before and where it came from. the lines go through a buffer to
+// fd 2, OLSH_XTRACEFD or appended to OLSH_XTRACEFILE, whichever is set when tracing starts.
+// the buffer is flushed when tracing stops, before the shell forks and after every line
+// when it's going to a terminal. callers check active() first, that's all it costs when off
+class Tracer {
+public:
+    bool active() const { return on; }
+    void start();
+    void stop();
+
+    // a command the shell runs. without a file it's one that didn't come from a script
+    void command(int depth, std::string_view file, uint32_t line, std::string_view text);
+    void command(std::string_view text) { command(1, {}, 0, text); }
+
+    // the interpreter traced the line it hands to the shell already, with its source line.
+    // the shell takes that back with claim(), which is false if the line was traced
+    void traced() { skip = true; }
+    bool claim() {
+        bool mine = !skip;
+        skip = false;
+        return mine;
+    }
+
+    void flush();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool on = false;
+    bool skip = false;
+    bool terminal = false;
+    std::unique_ptr<FdStreamBuf> out;
+    Clock::time_point last;
+};
+
+Tracer& getTracer();
+
+} // namespace olsh::Utils
+
+#endif //XTRACE_H
@@ -0,0 +1,26 @@
+#ifndef ZERO_COPY_H
+#define ZERO_COPY_H
+
+#include <cstddef>
+
+namespace olsh::Utils {
+
+// copies everything from inFd to outFd until EOF and returns the byte count, or -1 with errno set.
+// on linux the data never goes through the shell: copy_file_range between files, sendfile from a
+// file, splice when a pipe is on either side. anything those can't do (or OLSH_ZERO_COPY=0) falls
+// back to a plain read/write loop
+long long copyFd(int inFd, int outFd);
+
+// writes all of it, retrying short writes and EINTR
+bool writeAll(int fd, const char* data, size_t size);
+
+bool zeroCopyEnabled();
+
+#ifdef __linux__
+// bigger pipes mean fewer, larger splice/tee calls
+void growPipe(int fd);
+#endif
+
+} // namespace olsh::Utils
+
+#endif //ZERO_COPY_H
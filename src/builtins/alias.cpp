@@ -1,4 +1,5 @@
 #include "../../include/builtins/alias.h"
+#include "../../include/utils/streams.h"
 #include "../../include/utils/fs.h"
 #include <utils/colors.h>
 #include <filesystem>
@@ -73,7 +74,7 @@ void Alias::saveAliases() {
 
     std::ofstream file(aliasFile);
     if (!file.is_open()) {
-        std::cerr << YELLOW << "Warning: Could not save aliases to " << aliasFile << RESET << std::endl;
+        Utils::err() << YELLOW << "Warning: Could not save aliases to " << aliasFile << RESET << std::endl;
         return;
     }
 
@@ -96,8 +97,8 @@ int Alias::execute(const std::vector<std::string>& args) {
             if (arg.rfind("--", 0) == 0) {
                 if (arg == "--delete") { deleteMode = true; }
                 else {
-                    std::cerr << RED << "alias: unrecognized option '" << arg << "'\n" << RESET;
-                    std::cerr << "Usage: alias [-d|--delete] [--] [name[=value] | name value]" << std::endl;
+                    Utils::err() << RED << "alias: unrecognized option '" << arg << "'\n" << RESET;
+                    Utils::err() << "Usage: alias [-d|--delete] [--] [name[=value] | name value]" << std::endl;
                     return 1;
                 }
                 continue;
@@ -107,8 +108,8 @@ int Alias::execute(const std::vector<std::string>& args) {
                 switch (arg[j]) {
                     case 'd': deleteMode = true; break;
                     default:
-                        std::cerr << RED << "alias: invalid option -- '" << arg[j] << "'\n" << RESET;
-                        std::cerr << "Usage: alias [-d|--delete] [--] [name[=value] | name value]" << std::endl;
+                        Utils::err() << RED << "alias: invalid option -- '" << arg[j] << "'\n" << RESET;
+                        Utils::err() << "Usage: alias [-d|--delete] [--] [name[=value] | name value]" << std::endl;
                         return 1;
                 }
             }
@@ -120,8 +121,8 @@ int Alias::execute(const std::vector<std::string>& args) {
     // delete
     if (deleteMode) {
         if (positional.size() != 1) {
-            std::cerr << RED << "alias: -d/--delete requires exactly one alias name\n" << RESET;
-            std::cerr << "Usage: alias -d <name>" << std::endl;
+            Utils::err() << RED << "alias: -d/--delete requires exactly one alias name\n" << RESET;
+            Utils::err() << "Usage: alias -d <name>" << std::endl;
             return 1;
         }
         const std::string& nameToDelete = positional[0];
@@ -130,10 +131,10 @@ int Alias::execute(const std::vector<std::string>& args) {
             aliases.erase(it);
             saveAliases();
             loadAliases();
-            std::cout << "Alias '" << nameToDelete << "' deleted." << std::endl;
+            Utils::out() << "Alias '" << nameToDelete << "' deleted." << std::endl;
             return 0;
         } else {
-            std::cerr << RED << "alias: " << nameToDelete << ": not found\n" << RESET;
+            Utils::err() << RED << "alias: " << nameToDelete << ": not found\n" << RESET;
             return 1;
         }
     }
@@ -141,10 +142,10 @@ int Alias::execute(const std::vector<std::string>& args) {
     // list
     if (positional.empty()) {
         if (aliases.empty()) {
-            std::cout << RED << "alias: no aliases defined." << RESET << std::endl;
+            Utils::out() << RED << "alias: no aliases defined." << RESET << std::endl;
         } else {
             for (const auto& pair : aliases) {
-                std::cout << GREEN << "alias " << pair.first << "='" << pair.second << "'\n" << RESET;
+                Utils::out() << GREEN << "alias " << pair.first << "='" << pair.second << "'\n" << RESET;
             }
         }
         return 0;
@@ -158,10 +159,10 @@ int Alias::execute(const std::vector<std::string>& args) {
             // show alias
             auto it = aliases.find(name);
             if (it != aliases.end()) {
-                std::cout << "alias " << it->first << "='" << it->second << "'\n";
+                Utils::out() << "alias " << it->first << "='" << it->second << "'\n";
                 return 0;
             } else {
-                std::cout << "alias: " << name << ": not found\n";
+                Utils::out() << "alias: " << name << ": not found\n";
                 return 1;
             }
         } else {
@@ -169,12 +170,12 @@ int Alias::execute(const std::vector<std::string>& args) {
             std::string value = name.substr(eq + 1);
             name = name.substr(0, eq);
             if (name.empty() || value.empty()) {
-                std::cerr << RED << "alias: invalid format. Use name=value or name value\n" << RESET;
+                Utils::err() << RED << "alias: invalid format. Use name=value or name value\n" << RESET;
                 return 1;
             }
             aliases[name] = value;
             saveAliases();
-            std::cout << "Alias '" << name << "' set to '" << value << "'\n";
+            Utils::out() << "Alias '" << name << "' set to '" << value << "'\n";
             return 0;
         }
     }
@@ -196,33 +197,43 @@ int Alias::execute(const std::vector<std::string>& args) {
             value = oss.str();
         }
     } else {
-        // name then value tokens
+        // name then value tokens, with or without a = in between (name = value, name =value)
         std::ostringstream oss;
         for (size_t i = 1; i < positional.size(); ++i) {
-            if (i > 1) oss << ' ';
-            oss << positional[i];
+            std::string part = positional[i];
+            if (i == 1 && !part.empty() && part[0] == '=') part.erase(0, 1);
+            if (part.empty()) continue;
+            if (oss.tellp() > 0) oss << ' ';
+            oss << part;
         }
         value = oss.str();
     }
 
     if (name.empty()) {
-        std::cerr << RED << "alias: invalid alias name\n" << RESET;
+        Utils::err() << RED << "alias: invalid alias name\n" << RESET;
         return 1;
     }
 
     if (value.empty()) {
-        std::cerr << RED << "alias: no value specified for alias '" << name << "'\n" << RESET;
+        Utils::err() << RED << "alias: no value specified for alias '" << name << "'\n" << RESET;
         return 1;
     }
 
     aliases[name] = value;
     saveAliases();
-    std::cout << "Alias '" << name << "' set to '" << value << "'\n";
+    Utils::out() << "Alias '" << name << "' set to '" << value << "'\n";
     return 0;
 }
 
 std::string Alias::expandAlias(const std::string& command) {
-    loadAliases(); // without this new aliases will not be found until restart
+    // without this new aliases will not be found until restart. a stat is enough to
+    // tell, reading the file on every command (every line of a script) isn't
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(aliasFile, ec);
+    if (ec || modified != loadedTime) {
+        loadAliases();
+        loadedTime = ec ? std::filesystem::file_time_type{} : modified;
+    }
     auto it = aliases.find(command);
     if (it != aliases.end()) {
         return it->second;
@@ -0,0 +1,49 @@
+#include "../../include/builtins/bg.h"
+#include "../../include/utils/streams.h"
+#include "../../include/executor/job_table.h"
+#include <utils/colors.h>
+#include <iostream>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+namespace olsh::Builtins {
+
+int Bg::execute(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    Utils::err() << RED << "bg: job control is not supported on windows" << RESET << std::endl;
+    return 1;
+#else
+    JobTable& jobs = getJobTable();
+    jobs.reap();
+
+    std::vector<std::string> specs = args.empty() ? std::vector<std::string>{"%%"} : args;
+    int result = 0;
+    for (const auto& spec : specs) {
+        std::string error;
+        Job* job = jobs.resolve(spec, error);
+        if (!job) {
+            Utils::err() << RED << "bg: " << spec << ": " << error << RESET << std::endl;
+            result = 1;
+            continue;
+        }
+        if (job->state == Job::State::DONE) {
+            Utils::err() << RED << "bg: " << spec << ": job has terminated" << RESET << std::endl;
+            result = 1;
+            continue;
+        }
+        if (job->state == Job::State::RUNNING) {
+            Utils::err() << "bg: job " << job->id << " already in background" << std::endl;
+            continue;
+        }
+
+        kill(-job->pgid, SIGCONT);
+        job->state = Job::State::RUNNING;
+        Utils::out() << "[" << job->id << "] " << job->command << " &" << std::endl;
+    }
+    return result;
+#endif
+}
+
+} // namespace olsh::Builtins
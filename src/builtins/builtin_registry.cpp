@@ -13,6 +13,15 @@
 #include "../../include/builtins/cp.h"
 #include "../../include/builtins/touch.h"
 #include "../../include/builtins/mv.h"
+#include "../../include/builtins/wait.h"
+#include "../../include/builtins/hash.h"
+#include "../../include/builtins/jobs.h"
+#include "../../include/builtins/fg.h"
+#include "../../include/builtins/bg.h"
+#include "../../include/builtins/kill.h"
+#include "../../include/builtins/tee.h"
+#include "../../include/builtins/time.h"
+#include "../../include/builtins/set.h"
 
 namespace olsh {
 
@@ -35,6 +44,15 @@ void BuiltinRegistry::registerCommands() {
     Builtins::Cp cpCommand;
     Builtins::Touch touchCommand;
     Builtins::Mv mvCommand;
+    Builtins::Wait waitCommand;
+    Builtins::Hash hashCommand;
+    Builtins::Jobs jobsCommand;
+    Builtins::Fg fgCommand;
+    Builtins::Bg bgCommand;
+    Builtins::Kill killCommand;
+    Builtins::Tee teeCommand;
+    Builtins::Time timeCommand;
+    Builtins::Set setCommand;
 
 
     commands["cd"] = [cdCommand](const std::vector<std::string>& args) mutable { return cdCommand.execute(args); };
@@ -51,12 +69,29 @@ void BuiltinRegistry::registerCommands() {
     commands["cp"] = [cpCommand](const std::vector<std::string>& args) mutable { return cpCommand.execute(args); };
     commands["touch"] = [touchCommand](const std::vector<std::string>& args) mutable { return touchCommand.execute(args); };
     commands["mv"] = [mvCommand](const std::vector<std::string>& args) mutable { return mvCommand.execute(args); };
+    commands["wait"] = [waitCommand](const std::vector<std::string>& args) mutable { return waitCommand.execute(args); };
+    commands["hash"] = [hashCommand](const std::vector<std::string>& args) mutable { return hashCommand.execute(args); };
+    commands["jobs"] = [jobsCommand](const std::vector<std::string>& args) mutable { return jobsCommand.execute(args); };
+    commands["fg"] = [fgCommand](const std::vector<std::string>& args) mutable { return fgCommand.execute(args); };
+    commands["bg"] = [bgCommand](const std::vector<std::string>& args) mutable { return bgCommand.execute(args); };
+    commands["kill"] = [killCommand](const std::vector<std::string>& args) mutable { return killCommand.execute(args); };
+    commands["tee"] = [teeCommand](const std::vector<std::string>& args) mutable { return teeCommand.execute(args); };
+    commands["time"] = [timeCommand](const std::vector<std::string>& args) mutable { return timeCommand.execute(args); };
+    commands["set"] = [setCommand](const std::vector<std::string>& args) mutable { return setCommand.execute(args); };
+
+    // the rest change shell state (cwd, aliases, config, jobs, the hash table) and keep
+    // running in a forked copy when they're part of a pipeline
+    threadSafe = {"ls", "pwd", "echo", "rm", "cat", "mkdir", "cp", "touch", "mv", "tee"};
 }
 
 bool BuiltinRegistry::isBuiltin(const std::string& command) const {
     return commands.find(command) != commands.end();
 }
 
+bool BuiltinRegistry::canRunInThread(const std::string& command) const {
+    return threadSafe.count(command) > 0;
+}
+
 int BuiltinRegistry::execute(const std::string& command, const std::vector<std::string>& args) const {
     auto it = commands.find(command);
     if (it != commands.end()) {
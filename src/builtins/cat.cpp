@@ -1,33 +1,98 @@
 #include "../../include/builtins/cat.h"
+#include "../../include/utils/streams.h"
+#include "../../include/utils/zero_copy.h"
 #include <utils/colors.h>
 #include <iostream>
-#include <fstream>
 #include <vector>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 namespace olsh::Builtins {
 
+namespace {
+    int openFile(const std::string& filename) {
+#ifdef _WIN32
+        return _open(filename.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        return open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    }
+
+    void closeFile(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    // for outputs without an fd (ring buffers between builtins, captured output)
+    bool copyToStream(int fd, std::ostream& out) {
+        std::vector<char> buffer(128 * 1024);
+        for (;;) {
+#ifdef _WIN32
+            int n = _read(fd, buffer.data(), static_cast<unsigned int>(buffer.size()));
+#else
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+#endif
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            if (n == 0) return true;
+            if (!out.write(buffer.data(), n)) {
+                errno = EPIPE;
+                return false;
+            }
+        }
+    }
+}
+
 int Cat::execute(const std::vector<std::string>& args) {
     if (args.empty()) {
+        // both ends are plain fds (a pipeline stage between two externals), let the kernel move it
+        int inFd = Utils::inFd();
+        int outFd = inFd != -1 ? Utils::outFd() : -1;
+        if (outFd != -1) {
+            return Utils::copyFd(inFd, outFd) < 0 ? 1 : 0;
+        }
+
         // read from stdin if no args yk
         std::string line;
-        while (std::getline(std::cin, line)) {
-            std::cout << line << std::endl;
+        while (std::getline(Utils::in(), line)) {
+            Utils::out() << line << '\n';
+            // flush only when the next read may block, a terminal still gets every line right away
+            if (Utils::in().rdbuf()->in_avail() <= 0) Utils::out().flush();
         }
         return 0;
     }
 
     for (const auto& filename : args) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << RED << "cat: " << filename << ": No such file or directory" << RESET << std::endl;
+        int fd = openFile(filename);
+        if (fd == -1) {
+            Utils::err() << RED << "cat: " << filename << ": " << std::strerror(errno) << RESET << std::endl;
             return 1;
         }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            std::cout << line << std::endl;
+        // straight from the page cache when the output is an fd (terminal, pipe, redirected file)
+        int outFd = Utils::outFd();
+        bool ok = outFd != -1 ? Utils::copyFd(fd, outFd) >= 0 : copyToStream(fd, Utils::out());
+        int error = errno;
+        closeFile(fd);
+
+        if (!ok) {
+            // a reader that quit early isn't worth a message
+            if (error != EPIPE) {
+                Utils::err() << RED << "cat: " << filename << ": " << std::strerror(error) << RESET << std::endl;
+            }
+            return 1;
         }
-        file.close();
     }
 
     return 0;
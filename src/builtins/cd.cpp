@@ -1,4 +1,5 @@
 #include "../../include/builtins/cd.h"
+#include "../../include/utils/streams.h"
 #include "../../include/utils/fs.h"
 #include <utils/colors.h>
 #include <iostream>
@@ -20,7 +21,7 @@ int Cd::execute(const std::vector<std::string>& args) {
         std::filesystem::current_path(path);
         return 0;
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << RED << "cd: " << e.what() << RESET << std::endl;
+        Utils::err() << RED << "cd: " << e.what() << RESET << std::endl;
         return 1;
     }
 }
@@ -1,4 +1,5 @@
 #include "../../include/builtins/clear.h"
+#include "../../include/utils/streams.h"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -14,8 +15,8 @@ int Clear::execute(const std::vector<std::string>& args) {
             if (a == "-x" || a == "--scrollback") clearScrollback = true;
             else if (a == "--") break; 
             else {
-                std::cerr << "clear: unknown option '" << a << "'\n";
-                std::cerr << "Usage: clear [-x|--scrollback]" << std::endl;
+                Utils::err() << "clear: unknown option '" << a << "'\n";
+                Utils::err() << "Usage: clear [-x|--scrollback]" << std::endl;
                 return 1;
             }
         }
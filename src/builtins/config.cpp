@@ -1,4 +1,5 @@
 #include "builtins/config.h"
+#include "utils/streams.h"
 #include "../include/shell.h"
 #include <utils/colors.h>
 #include <iostream>
@@ -15,7 +16,7 @@ void Config::setShellInstance(Shell* shell) {
 
 int Config::execute(const std::vector<std::string>& args) {
     if (!s_shell) {
-        std::cerr << RED << "config: Shell instance not set" << RESET << "\n";
+        Utils::err() << RED << "config: Shell instance not set" << RESET << "\n";
         return 1;
     }
 
@@ -45,8 +46,8 @@ int Config::execute(const std::vector<std::string>& args) {
                         case 'g': getFlag = true; break;
                         case 'S': setFlag = true; break;
                         default:
-                            std::cerr << RED << "config: invalid option: -" << arg[i] << RESET << "\n";
-                            std::cerr << "Usage: config [-h|--help] [-s|--show] [-g|--get] [-S|--set] [key] [value]\n";
+                            Utils::err() << RED << "config: invalid option: -" << arg[i] << RESET << "\n";
+                            Utils::err() << "Usage: config [-h|--help] [-s|--show] [-g|--get] [-S|--set] [key] [value]\n";
                             return 1;
                     }
                 }
@@ -74,7 +75,7 @@ int Config::execute(const std::vector<std::string>& args) {
     
     if (getFlag) {
         if (positionalArgs.empty()) {
-            std::cerr << RED << "config: --get requires a key" << RESET << "\n";
+            Utils::err() << RED << "config: --get requires a key" << RESET << "\n";
             return 1;
         }
         return getConfig(positionalArgs[0]);
@@ -82,7 +83,7 @@ int Config::execute(const std::vector<std::string>& args) {
     
     if (setFlag) {
         if (positionalArgs.size() < 2) {
-            std::cerr << RED << "config: --set requires key and value" << RESET << "\n";
+            Utils::err() << RED << "config: --set requires key and value" << RESET << "\n";
             return 1;
         }
         // join remaining args as value (in case value has spaces)
@@ -109,50 +110,50 @@ int Config::execute(const std::vector<std::string>& args) {
 }
 
 void Config::showHelp() {
-    std::cout << BOLD_CYAN << "Config Command Usage:" << RESET << "\n";
-    std::cout << "  config                        - Show current configuration\n";
-    std::cout << "  config " << BOLD_GREEN << "-s" << RESET << "|" << BOLD_GREEN << "--show" << RESET << "             - Show current configuration\n";
-    std::cout << "  config " << BOLD_GREEN << "-g" << RESET << "|" << BOLD_GREEN << "--get" << RESET << " " << BOLD_YELLOW << "<key>" << RESET << "        - Get configuration value\n";
-    std::cout << "  config " << BOLD_GREEN << "-S" << RESET << "|" << BOLD_GREEN << "--set" << RESET << " " << BOLD_YELLOW << "<key> <value>" << RESET << " - Set configuration value\n";
-    std::cout << "  config " << BOLD_GREEN << "-h" << RESET << "|" << BOLD_GREEN << "--help" << RESET << "            - Show this help\n\n";
+    Utils::out() << BOLD_CYAN << "Config Command Usage:" << RESET << "\n";
+    Utils::out() << "  config                        - Show current configuration\n";
+    Utils::out() << "  config " << BOLD_GREEN << "-s" << RESET << "|" << BOLD_GREEN << "--show" << RESET << "             - Show current configuration\n";
+    Utils::out() << "  config " << BOLD_GREEN << "-g" << RESET << "|" << BOLD_GREEN << "--get" << RESET << " " << BOLD_YELLOW << "<key>" << RESET << "        - Get configuration value\n";
+    Utils::out() << "  config " << BOLD_GREEN << "-S" << RESET << "|" << BOLD_GREEN << "--set" << RESET << " " << BOLD_YELLOW << "<key> <value>" << RESET << " - Set configuration value\n";
+    Utils::out() << "  config " << BOLD_GREEN << "-h" << RESET << "|" << BOLD_GREEN << "--help" << RESET << "            - Show this help\n\n";
     
-    std::cout << BOLD_CYAN << "Available Configuration Keys:" << RESET << "\n";
-    std::cout << "  " << BOLD_YELLOW << "prompt" << RESET << "           - Shell prompt template\n";
-    std::cout << "  " << BOLD_YELLOW << "welcome_message" << RESET << "  - Message shown on shell startup\n";
-    std::cout << "  " << BOLD_YELLOW << "shell_name" << RESET << "       - Name of the shell\n";
-    std::cout << "  " << BOLD_YELLOW << "version" << RESET << "          - Shell version\n\n";
+    Utils::out() << BOLD_CYAN << "Available Configuration Keys:" << RESET << "\n";
+    Utils::out() << "  " << BOLD_YELLOW << "prompt" << RESET << "           - Shell prompt template\n";
+    Utils::out() << "  " << BOLD_YELLOW << "welcome_message" << RESET << "  - Message shown on shell startup\n";
+    Utils::out() << "  " << BOLD_YELLOW << "shell_name" << RESET << "       - Name of the shell\n";
+    Utils::out() << "  " << BOLD_YELLOW << "version" << RESET << "          - Shell version\n\n";
     
-    std::cout << BOLD_CYAN << "Prompt Template Variables:" << RESET << "\n";
-    std::cout << "  " << BOLD_MAGENTA << "{user}" << RESET << "     - Current username\n";
-    std::cout << "  " << BOLD_MAGENTA << "{hostname}" << RESET << " - Computer hostname\n";
-    std::cout << "  " << BOLD_MAGENTA << "{cwd}" << RESET << "      - Current working directory\n";
-    std::cout << "  " << BOLD_MAGENTA << "\\n" << RESET << "         - New line\n";
-    std::cout << "  " << BOLD_MAGENTA << "\\t" << RESET << "         - Tab character\n\n";
+    Utils::out() << BOLD_CYAN << "Prompt Template Variables:" << RESET << "\n";
+    Utils::out() << "  " << BOLD_MAGENTA << "{user}" << RESET << "     - Current username\n";
+    Utils::out() << "  " << BOLD_MAGENTA << "{hostname}" << RESET << " - Computer hostname\n";
+    Utils::out() << "  " << BOLD_MAGENTA << "{cwd}" << RESET << "      - Current working directory\n";
+    Utils::out() << "  " << BOLD_MAGENTA << "\\n" << RESET << "         - New line\n";
+    Utils::out() << "  " << BOLD_MAGENTA << "\\t" << RESET << "         - Tab character\n\n";
     
-    std::cout << BOLD_CYAN << "Examples:" << RESET << "\n";
-    std::cout << "  config --set prompt \"$ \"\n";
-    std::cout << "  config --set prompt \"{user}@{hostname}:{cwd}$ \"\n";
-    std::cout << "  config --get prompt\n";
-    std::cout << "  config --set welcome_message \"Welcome to OlShell!\"\n";
+    Utils::out() << BOLD_CYAN << "Examples:" << RESET << "\n";
+    Utils::out() << "  config --set prompt \"$ \"\n";
+    Utils::out() << "  config --set prompt \"{user}@{hostname}:{cwd}$ \"\n";
+    Utils::out() << "  config --get prompt\n";
+    Utils::out() << "  config --set welcome_message \"Welcome to OlShell!\"\n";
 }
 
 void Config::showCurrentConfig() {
-    std::cout << BOLD_CYAN << "Current OlShell Configuration:" << RESET << "\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    Utils::out() << BOLD_CYAN << "Current OlShell Configuration:" << RESET << "\n";
+    Utils::out() << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
     
     auto* config = s_shell->getConfigManager();
     
-    std::cout << std::left;
-    std::cout << std::setw(20) << (std::string(BOLD_YELLOW) + "Setting" + RESET) << (std::string(BOLD_YELLOW) + "Value" + RESET) << "\n";
-    std::cout << "────────────────────────────────────────────────────────────────────────────────\n";
+    Utils::out() << std::left;
+    Utils::out() << std::setw(20) << (std::string(BOLD_YELLOW) + "Setting" + RESET) << (std::string(BOLD_YELLOW) + "Value" + RESET) << "\n";
+    Utils::out() << "────────────────────────────────────────────────────────────────────────────────\n";
     
-    std::cout << std::setw(20) << "prompt" << config->getPrompt() << "\n";
-    std::cout << std::setw(20) << "welcome_message" << config->getSetting("welcome_message", "Not set") << "\n";
-    std::cout << std::setw(20) << "shell_name" << config->getSetting("shell_name", "OlShell") << "\n";
-    std::cout << std::setw(20) << "version" << config->getSetting("version", "2.0") << "\n";
+    Utils::out() << std::setw(20) << "prompt" << config->getPrompt() << "\n";
+    Utils::out() << std::setw(20) << "welcome_message" << config->getSetting("welcome_message", "Not set") << "\n";
+    Utils::out() << std::setw(20) << "shell_name" << config->getSetting("shell_name", "OlShell") << "\n";
+    Utils::out() << std::setw(20) << "version" << config->getSetting("version", "2.0") << "\n";
     
-    std::cout << "\n" << BOLD_CYAN << "Configuration file location:" << RESET << " ~/.olshell/config.yaml\n";
-    std::cout << "Use '" << BOLD_GREEN << "config --help" << RESET << "' for more information.\n";
+    Utils::out() << "\n" << BOLD_CYAN << "Configuration file location:" << RESET << " ~/.olshell/config.yaml\n";
+    Utils::out() << "Use '" << BOLD_GREEN << "config --help" << RESET << "' for more information.\n";
 }
 
 int Config::setConfig(const std::string& key, const std::string& value) {
@@ -160,13 +161,13 @@ int Config::setConfig(const std::string& key, const std::string& value) {
     config->setSetting(key, value);
     
     if (config->saveConfig()) {
-        std::cout << BOLD_GREEN << "✓" << RESET << " Set " << BOLD_YELLOW << key << RESET << " = " << BOLD_CYAN << value << RESET << "\n";
+        Utils::out() << BOLD_GREEN << "✓" << RESET << " Set " << BOLD_YELLOW << key << RESET << " = " << BOLD_CYAN << value << RESET << "\n";
         if (key == "prompt" || key == "welcome_message") {
-            std::cout << BOLD_BLUE << "ℹ" << RESET << " Changes will take effect immediately for new prompts.\n";
+            Utils::out() << BOLD_BLUE << "ℹ" << RESET << " Changes will take effect immediately for new prompts.\n";
         }
         return 0;
     } else {
-        std::cerr << RED << "✗ Failed to save configuration." << RESET << "\n";
+        Utils::err() << RED << "✗ Failed to save configuration." << RESET << "\n";
         return 1;
     }
 }
@@ -176,9 +177,9 @@ int Config::getConfig(const std::string& key) {
     std::string value = config->getSetting(key, "");
     
     if (value.empty()) {
-        std::cout << BOLD_YELLOW << key << RESET << ": " << BOLD_RED << "(not set)" << RESET << "\n";
+        Utils::out() << BOLD_YELLOW << key << RESET << ": " << BOLD_RED << "(not set)" << RESET << "\n";
     } else {
-        std::cout << BOLD_YELLOW << key << RESET << ": " << BOLD_CYAN << value << RESET << "\n";
+        Utils::out() << BOLD_YELLOW << key << RESET << ": " << BOLD_CYAN << value << RESET << "\n";
     }
     
     return 0;
@@ -1,4 +1,5 @@
 #include "../../include/builtins/cp.h"
+#include "../../include/utils/streams.h"
 #include <utils/colors.h>
 #include <filesystem>
 #include <iostream>
@@ -7,8 +8,8 @@ namespace olsh::Builtins {
 
 int Cp::execute(const std::vector<std::string> &args) {
     if (args.size() < 3) {
-        std::cerr << RED << "cp: missing file operand\n" << RESET;
-        std::cerr << "Usage: cp <source> <destination>\n";
+        Utils::err() << RED << "cp: missing file operand\n" << RESET;
+        Utils::err() << "Usage: cp <source> <destination>\n";
         return 1;
     }
 
@@ -24,7 +25,7 @@ int Cp::execute(const std::vector<std::string> &args) {
             std::filesystem::copy_options::overwrite_existing |
             std::filesystem::copy_options::recursive);
     } catch (const std::filesystem::filesystem_error &e) {
-        std::cerr << RED << "cp: " << e.what() << "\n" << RESET;
+        Utils::err() << RED << "cp: " << e.what() << "\n" << RESET;
         return 1;
     }
 
@@ -1,4 +1,5 @@
 #include "../../include/builtins/echo.h"
+#include "../../include/utils/streams.h"
 #include <iostream>
 
 namespace olsh::Builtins {
@@ -15,11 +16,11 @@ int Echo::execute(const std::vector<std::string>& args) {
 
     // print the args
     for (size_t i = start; i < args.size(); ++i) {
-        if (i > start) std::cout << " ";
-        std::cout << args[i];
+        if (i > start) Utils::out() << " ";
+        Utils::out() << args[i];
     }
 
-    if (newline) std::cout << std::endl;
+    if (newline) Utils::out() << std::endl;
 
     return 0;
 }
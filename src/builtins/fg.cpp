@@ -0,0 +1,48 @@
+#include "../../include/builtins/fg.h"
+#include "../../include/utils/streams.h"
+#include "../../include/executor/job_table.h"
+#include "../../include/executor/process.h"
+#include <utils/colors.h>
+#include <iostream>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+namespace olsh::Builtins {
+
+int Fg::execute(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    Utils::err() << RED << "fg: job control is not supported on windows" << RESET << std::endl;
+    return 1;
+#else
+    JobTable& jobs = getJobTable();
+    jobs.reap();
+
+    std::string spec = args.empty() ? "%%" : args[0];
+    std::string error;
+    Job* job = jobs.resolve(spec, error);
+    if (!job) {
+        Utils::err() << RED << "fg: " << spec << ": " << error << RESET << std::endl;
+        return 1;
+    }
+    if (job->state == Job::State::DONE) {
+        Utils::err() << RED << "fg: " << spec << ": job has terminated" << RESET << std::endl;
+        jobs.remove(job->id);
+        return 1;
+    }
+
+    Utils::out() << job->command << std::endl;
+
+    // hand over the terminal before it gets to run again
+    job->foreground = true;
+    jobs.giveTerminal(job->pgid);
+    if (job->state == Job::State::STOPPED) {
+        kill(-job->pgid, SIGCONT);
+        job->state = Job::State::RUNNING;
+    }
+    return Process::waitForeground(*job);
+#endif
+}
+
+} // namespace olsh::Builtins
@@ -0,0 +1,73 @@
+#include "../../include/builtins/hash.h"
+#include "../../include/utils/streams.h"
+#include "../../include/builtins/builtin_registry.h"
+#include "../../include/executor/command_cache.h"
+#include "../../include/parser/parse_cache.h"
+#include <utils/colors.h>
+#include <iostream>
+
+namespace olsh::Builtins {
+
+int Hash::execute(const std::vector<std::string>& args) {
+    CommandCache& cache = getCommandCache();
+
+    // no args lists what's remembered
+    if (args.empty()) {
+        auto entries = cache.getEntries();
+        if (entries.empty()) {
+            Utils::out() << "hash: hash table empty" << std::endl;
+            return 0;
+        }
+        Utils::out() << "hits\tcommand" << std::endl;
+        for (const auto& [name, entry] : entries) {
+            Utils::out() << "   " << entry.hits << "\t" << entry.path << std::endl;
+        }
+        return 0;
+    }
+
+    if (args[0] == "-r") {
+        cache.clear();
+        getParseCache().clear();
+        return 0;
+    }
+
+    // how well the shell's caches are doing
+    if (args[0] == "-s") {
+        size_t pathHits = 0;
+        for (const auto& [name, entry] : cache.getEntries()) pathHits += entry.hits;
+        ParseCache::Stats parsed = getParseCache().getStats();
+        Utils::out() << "commands\t" << cache.getEntries().size() << " remembered, " << pathHits << " hits" << std::endl;
+        Utils::out() << "parsed\t\t" << parsed.hits << " hits, " << parsed.misses << " misses, "
+                     << parsed.size << "/" << parsed.capacity << " lines cached" << std::endl;
+        return 0;
+    }
+
+    if (args[0] == "-p") {
+        if (args.size() != 3) {
+            Utils::err() << RED << "hash: usage: hash -p path name" << RESET << std::endl;
+            return 1;
+        }
+        cache.add(args[2], args[1]);
+        return 0;
+    }
+
+    if (args[0] == "-d") {
+        for (size_t i = 1; i < args.size(); ++i) {
+            cache.forget(args[i]);
+        }
+        return 0;
+    }
+
+    int result = 0;
+    for (const auto& name : args) {
+        // builtins never go through PATH, same as bash
+        if (getBuiltinRegistry().isBuiltin(name)) continue;
+        if (cache.lookup(name).empty()) {
+            Utils::err() << RED << "hash: " << name << ": not found" << RESET << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+} // namespace olsh::Builtins
@@ -1,4 +1,5 @@
 #include "../../include/builtins/history.h"
+#include "../../include/utils/streams.h"
 #include "../../include/utils/readline.h"
 #include <utils/colors.h>
 #include <iostream>
@@ -89,7 +90,7 @@ int History::execute(const std::vector<std::string>& args) {
     if (args.empty()) {
         // all history
         for (size_t i = 0; i < historyList.size(); i++) {
-            std::cout << std::setw(5) << (i + 1) << "  " << historyList[i] << std::endl;
+            Utils::out() << std::setw(5) << (i + 1) << "  " << historyList[i] << std::endl;
         }
         return 0;
     }
@@ -99,8 +100,8 @@ int History::execute(const std::vector<std::string>& args) {
         historyList.clear();
         saveHistory();
         readlineHistoryReset(); // Reset the readline history navigation index
-        std::cout << GREEN << "History cleared." << RESET << std::endl;
-        std::cout << historyList.size() << " commands in history." << std::endl;
+        Utils::out() << GREEN << "History cleared." << RESET << std::endl;
+        Utils::out() << historyList.size() << " commands in history." << std::endl;
         return 0;
     }
 
@@ -110,14 +111,14 @@ int History::execute(const std::vector<std::string>& args) {
             // show last n commands
             size_t start = historyList.size() > static_cast<size_t>(n) ? historyList.size() - n : 0;
             for (size_t i = start; i < historyList.size(); i++) {
-                std::cout << std::setw(5) << (i + 1) << "  " << historyList[i] << std::endl;
+                Utils::out() << std::setw(5) << (i + 1) << "  " << historyList[i] << std::endl;
             }
         } else {
-            std::cerr << RED << "history: invalid number: " << args[0] << RESET << std::endl;
+            Utils::err() << RED << "history: invalid number: " << args[0] << RESET << std::endl;
             return 1;
         }
     } catch (const std::exception&) {
-        std::cerr << RED << "history: invalid argument: " << args[0] << RESET << std::endl;
+        Utils::err() << RED << "history: invalid argument: " << args[0] << RESET << std::endl;
         return 1;
     }
 
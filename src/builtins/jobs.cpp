@@ -0,0 +1,47 @@
+#include "../../include/builtins/jobs.h"
+#include "../../include/utils/streams.h"
+#include "../../include/executor/job_table.h"
+#include <utils/colors.h>
+#include <iostream>
+
+namespace olsh::Builtins {
+
+int Jobs::execute(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    Utils::err() << RED << "jobs: job control is not supported on windows" << RESET << std::endl;
+    return 1;
+#else
+    bool showPgid = false;
+    bool pgidOnly = false;
+    for (const auto& arg : args) {
+        if (arg == "-l") {
+            showPgid = true;
+        } else if (arg == "-p") {
+            pgidOnly = true;
+        } else {
+            Utils::err() << RED << "jobs: invalid option: " << arg << RESET << std::endl;
+            Utils::err() << "Usage: jobs [-l] [-p]" << std::endl;
+            return 1;
+        }
+    }
+
+    JobTable& jobs = getJobTable();
+    jobs.reap();
+
+    for (Job* job : jobs.list()) {
+        if (pgidOnly) {
+            Utils::out() << job->pgid << std::endl;
+        } else {
+            jobs.print(*job, Utils::out(), showPgid);
+        }
+    }
+
+    // finished jobs are only reported once
+    for (Job* job : jobs.list()) {
+        if (job->state == Job::State::DONE) jobs.remove(job->id);
+    }
+    return 0;
+#endif
+}
+
+} // namespace olsh::Builtins
@@ -0,0 +1,166 @@
+#include "../../include/builtins/kill.h"
+#include "../../include/utils/streams.h"
+#include "../../include/executor/job_table.h"
+#include <utils/colors.h>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+namespace olsh::Builtins {
+
+#ifndef _WIN32
+namespace {
+    struct SignalName {
+        const char* name;
+        int number;
+    };
+
+    const SignalName SIGNALS[] = {
+        {"HUP", SIGHUP}, {"INT", SIGINT}, {"QUIT", SIGQUIT}, {"ILL", SIGILL},
+        {"TRAP", SIGTRAP}, {"ABRT", SIGABRT}, {"BUS", SIGBUS}, {"FPE", SIGFPE},
+        {"KILL", SIGKILL}, {"USR1", SIGUSR1}, {"SEGV", SIGSEGV}, {"USR2", SIGUSR2},
+        {"PIPE", SIGPIPE}, {"ALRM", SIGALRM}, {"TERM", SIGTERM}, {"CHLD", SIGCHLD},
+        {"CONT", SIGCONT}, {"STOP", SIGSTOP}, {"TSTP", SIGTSTP}, {"TTIN", SIGTTIN},
+        {"TTOU", SIGTTOU}, {"URG", SIGURG}, {"XCPU", SIGXCPU}, {"XFSZ", SIGXFSZ},
+        {"VTALRM", SIGVTALRM}, {"PROF", SIGPROF}, {"WINCH", SIGWINCH}, {"SYS", SIGSYS},
+    };
+
+    // the whole string or nothing, out of range counts as nothing
+    template <typename T>
+    bool parseNumber(const std::string& s, T& out) {
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+        return ec == std::errc() && end == s.data() + s.size();
+    }
+
+    // TERM, SIGTERM, term or 15. -1 if it's none of those
+    int parseSignal(std::string spec) {
+        if (!spec.empty() && std::all_of(spec.begin(), spec.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            int number = -1;
+            return parseNumber(spec, number) && number < NSIG ? number : -1;
+        }
+
+        std::transform(spec.begin(), spec.end(), spec.begin(), [](unsigned char c) { return std::toupper(c); });
+        if (spec.rfind("SIG", 0) == 0) spec = spec.substr(3);
+        for (const auto& sig : SIGNALS) {
+            if (spec == sig.name) return sig.number;
+        }
+        return -1;
+    }
+
+    const char* signalName(int number) {
+        for (const auto& sig : SIGNALS) {
+            if (sig.number == number) return sig.name;
+        }
+        return nullptr;
+    }
+}
+#endif
+
+int Kill::execute(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    Utils::err() << RED << "kill: not supported on windows" << RESET << std::endl;
+    return 1;
+#else
+    if (args.empty()) {
+        Utils::err() << "Usage: kill [-s sigspec | -n signum | -sigspec] pid | %job ..." << std::endl;
+        Utils::err() << "       kill -l [status]" << std::endl;
+        return 1;
+    }
+
+    // kill -l lists the names, kill -l 143 names the signal behind an exit status
+    if (args[0] == "-l") {
+        if (args.size() == 1) {
+            for (const auto& sig : SIGNALS) {
+                Utils::out() << sig.number << ") SIG" << sig.name << std::endl;
+            }
+            return 0;
+        }
+        int result = 0;
+        for (size_t i = 1; i < args.size(); ++i) {
+            int number = parseSignal(args[i]);
+            int status = 0;
+            if (number < 0 && parseNumber(args[i], status)) {
+                number = status - 128; // exit status of a killed command
+            }
+            const char* name = number > 0 ? signalName(number) : nullptr;
+            if (!name) {
+                Utils::err() << RED << "kill: " << args[i] << ": invalid signal specification" << RESET << std::endl;
+                result = 1;
+                continue;
+            }
+            Utils::out() << name << std::endl;
+        }
+        return result;
+    }
+
+    int sig = SIGTERM;
+    size_t first = 0;
+    if (args[0] == "-s" || args[0] == "-n") {
+        if (args.size() < 2) {
+            Utils::err() << RED << "kill: " << args[0] << ": option requires an argument" << RESET << std::endl;
+            return 1;
+        }
+        sig = parseSignal(args[1]);
+        if (sig < 0) {
+            Utils::err() << RED << "kill: " << args[1] << ": invalid signal specification" << RESET << std::endl;
+            return 1;
+        }
+        first = 2;
+    } else if (args[0].size() > 1 && args[0][0] == '-') {
+        sig = parseSignal(args[0].substr(1));
+        if (sig < 0) {
+            Utils::err() << RED << "kill: " << args[0].substr(1) << ": invalid signal specification" << RESET << std::endl;
+            return 1;
+        }
+        first = 1;
+    }
+
+    JobTable& jobs = getJobTable();
+    int result = 0;
+    for (size_t i = first; i < args.size(); ++i) {
+        const std::string& target = args[i];
+
+        if (target[0] == '%') {
+            std::string error;
+            Job* job = jobs.resolve(target, error);
+            if (!job) {
+                Utils::err() << RED << "kill: " << target << ": " << error << RESET << std::endl;
+                result = 1;
+                continue;
+            }
+            if (kill(-job->pgid, sig) == -1) {
+                Utils::err() << RED << "kill: " << target << ": " << std::strerror(errno) << RESET << std::endl;
+                result = 1;
+                continue;
+            }
+            // a stopped job can't act on TERM/HUP until it runs again
+            if (job->state == Job::State::STOPPED && (sig == SIGTERM || sig == SIGHUP)) {
+                kill(-job->pgid, SIGCONT);
+            }
+            continue;
+        }
+
+        // straight into pid_t, 4294967295 must not wrap around to -1 (everything)
+        pid_t pid = 0;
+        if (!parseNumber(target, pid)) {
+            Utils::err() << RED << "kill: " << target << ": arguments must be process or job IDs" << RESET << std::endl;
+            result = 1;
+            continue;
+        }
+        if (kill(pid, sig) == -1) {
+            Utils::err() << RED << "kill: (" << pid << ") - " << std::strerror(errno) << RESET << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+#endif
+}
+
+} // namespace olsh::Builtins
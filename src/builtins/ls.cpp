@@ -1,4 +1,5 @@
 #include "../../include/builtins/ls.h"
+#include "../../include/utils/streams.h"
 #include <utils/colors.h>
 #include <iostream>
 #include <filesystem>
@@ -36,8 +37,8 @@ int Ls::execute(const std::vector<std::string>& args) {
                     case 'a': showHidden = true; break;
                     case 'l': longFormat = true; break;
                     default:
-                        std::cerr << RED << "ls: invalid option: -" << arg[i] << RESET << "\n";
-                        std::cerr << "Usage: ls [-a] [-l] <path>\n";
+                        Utils::err() << RED << "ls: invalid option: -" << arg[i] << RESET << "\n";
+                        Utils::err() << "Usage: ls [-a] [-l] <path>\n";
                         return 1;
                 }
             }
@@ -215,15 +216,15 @@ int Ls::execute(const std::vector<std::string>& args) {
                 auto totalW = [&](const std::vector<size_t>& ws){ return 1 + (int)ws.size() + (int)std::accumulate(ws.begin(), ws.end(), size_t{0}) + 2*(int)ws.size(); };
                 while (totalW(widths) > tw && widths[3] > 8) widths[3]--;
 
-                std::cout << border(widths) << "\n";
+                Utils::out() << border(widths) << "\n";
                 std::ostringstream hdr;
                 hdr << '|' << ' ' << padRight(std::string(BOLD_CYAN)+hPerm+RESET, widths[0])
                     << ' ' << '|' << ' ' << padRight(std::string(BOLD_CYAN)+hSize+RESET, widths[1])
                     << ' ' << '|' << ' ' << padRight(std::string(BOLD_CYAN)+hTime+RESET, widths[2])
                     << ' ' << '|' << ' ' << padRight(std::string(BOLD_CYAN)+hName+RESET, widths[3])
                     << ' ' << '|';
-                std::cout << hdr.str() << "\n";
-                std::cout << border(widths) << "\n";
+                Utils::out() << hdr.str() << "\n";
+                Utils::out() << border(widths) << "\n";
 
                 for (const auto& r : rows) {
                     std::string n = r.colored; if (dispWidth(n) > widths[3]) n = ellipsize(n, widths[3]);
@@ -233,18 +234,18 @@ int Ls::execute(const std::vector<std::string>& args) {
                        << ' ' << '|' << ' ' << padRight(r.timeStr, widths[2])
                        << ' ' << '|' << ' ' << padRight(n, widths[3])
                        << ' ' << '|';
-                    std::cout << ln.str() << "\n";
+                    Utils::out() << ln.str() << "\n";
                 }
-                std::cout << border(widths) << std::endl;
+                Utils::out() << border(widths) << std::endl;
             } else {
-                if (rows.empty()) { std::cout << "(empty)\n"; return 0; }
+                if (rows.empty()) { Utils::out() << "(empty)\n"; return 0; }
                 int tw = termWidth();
                 size_t maxName = 0; for (const auto& r : rows) maxName = std::max(maxName, dispWidth(r.colored));
                 size_t colW = std::min<size_t>(std::max<size_t>(maxName, 1), 40);
                 std::vector<size_t> widths; // determine columns that fit
                 int ncols = std::max(1, (tw - 1) / (int(colW) + 3)); // crude fit
                 widths.assign(ncols, colW);
-                std::cout << border(widths) << "\n";
+                Utils::out() << border(widths) << "\n";
                 int nrows = (int(rows.size()) + ncols - 1) / ncols;
                 for (int r = 0; r < nrows; ++r) {
                     std::ostringstream ln; ln << '|';
@@ -255,16 +256,16 @@ int Ls::execute(const std::vector<std::string>& args) {
                         else { cell = std::string(widths[c], ' '); }
                         ln << ' ' << cell << ' ' << '|';
                     }
-                    std::cout << ln.str() << "\n";
-                    std::cout << border(widths) << "\n";
+                    Utils::out() << ln.str() << "\n";
+                    Utils::out() << border(widths) << "\n";
                 }
             }
         } else {
-            std::cout << path << std::endl;
+            Utils::out() << path << std::endl;
         }
         return 0;
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << RED << "ls: " << e.what() << RESET << std::endl;
+        Utils::err() << RED << "ls: " << e.what() << RESET << std::endl;
         return 1;
     }
 }
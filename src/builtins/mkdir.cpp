@@ -1,4 +1,5 @@
 #include "../../include/builtins/mkdir.h"
+#include "../../include/utils/streams.h"
 #include "../../include/utils/fs.h"
 #include <utils/colors.h>
 #include <iostream>
@@ -8,7 +9,7 @@ namespace olsh::Builtins {
 
 int Mkdir::execute(const std::vector<std::string>& args) {
     if (args.empty()) {
-        std::cerr << RED << "mkdir: missing operand" << RESET << std::endl;
+        Utils::err() << RED << "mkdir: missing operand" << RESET << std::endl;
         return 1;
     }
 
@@ -16,12 +17,12 @@ int Mkdir::execute(const std::vector<std::string>& args) {
         std::string path = olsh::Utils::Fs::expandPath(dir);
         try {
             if (!std::filesystem::create_directories(path)) {
-                std::cerr << RED << "mkdir: cannot create directory '" << dir
+                Utils::err() << RED << "mkdir: cannot create directory '" << dir
                           << "': Directory already exists" << RESET << std::endl;
                 return 1;
             }
         } catch (const std::filesystem::filesystem_error& e) {
-            std::cerr << RED << "mkdir: cannot create directory '" << dir
+            Utils::err() << RED << "mkdir: cannot create directory '" << dir
                       << "': " << e.what() << RESET << std::endl;
             return 1;
         }
@@ -1,4 +1,5 @@
 #include "../../include/builtins/mv.h"
+#include "../../include/utils/streams.h"
 
 #include <filesystem>
 #include <iostream>
@@ -10,8 +11,8 @@ namespace olsh::Builtins {
 
 int Mv::execute(const std::vector<std::string>& args) {
     if (args.empty()) {
-        std::cerr << RED << "mv: missing operand\n" << RESET;
-        std::cerr << "Usage: mv [-finuv] <source> <destination>\n";
+        Utils::err() << RED << "mv: missing operand\n" << RESET;
+        Utils::err() << "Usage: mv [-finuv] <source> <destination>\n";
         return 1;
     }
 
@@ -35,8 +36,8 @@ int Mv::execute(const std::vector<std::string>& args) {
                     case 'v': verbose = true; break;
                     case 'u': update = true; break;
                     default:
-                        std::cerr << RED << "mv: invalid option: -" << arg[i] << RESET << "\n";
-                        std::cerr << "Usage: mv [-finuv] <source> <destination>\n";
+                        Utils::err() << RED << "mv: invalid option: -" << arg[i] << RESET << "\n";
+                        Utils::err() << "Usage: mv [-finuv] <source> <destination>\n";
                         return 1;
                 }
             }
@@ -47,34 +48,34 @@ int Mv::execute(const std::vector<std::string>& args) {
             } else if (dest.empty()) {
                 dest = arg;
             } else {
-                std::cerr << RED << "mv: too many operands\n" << RESET;
-                std::cerr << "Usage: mv [-finuv] <source> <destination>\n";
+                Utils::err() << RED << "mv: too many operands\n" << RESET;
+                Utils::err() << "Usage: mv [-finuv] <source> <destination>\n";
                 return 1;
             }
         }
     }
 
     if (src.empty() || dest.empty()) {
-        std::cerr << RED << "mv: missing file operand\n" << RESET;
-        std::cerr << "Usage: mv [-finuv] <source> <destination>\n";
+        Utils::err() << RED << "mv: missing file operand\n" << RESET;
+        Utils::err() << "Usage: mv [-finuv] <source> <destination>\n";
         return 1;
     }
 
     if (noClobber && std::filesystem::exists(dest)) {
         if (verbose) {
-            std::cout << "Not overwriting '" << dest << "' (no-clobber).\n";
+            Utils::out() << "Not overwriting '" << dest << "' (no-clobber).\n";
         }
         return 0;
     }
 
     try {
         if (!force && interactive && std::filesystem::exists(dest)) {
-            std::cout << "mv: overwrite '" << dest << "'? (y/n) ";
+            Utils::out() << "mv: overwrite '" << dest << "'? (y/n) ";
             char response{};
-            std::cin >> response;
+            Utils::in() >> response;
             if (response != 'y' && response != 'Y') {
                 if (verbose) {
-                    std::cout << "Not overwriting '" << dest << "'.\n";
+                    Utils::out() << "Not overwriting '" << dest << "'.\n";
                 }
                 return 0;
             }
@@ -85,7 +86,7 @@ int Mv::execute(const std::vector<std::string>& args) {
             auto destTime = std::filesystem::last_write_time(dest);
             if (srcTime <= destTime) {
                 if (verbose) {
-                    std::cout << "Not moving '" << src
+                    Utils::out() << "Not moving '" << src
                               << "' to '" << dest
                               << "' because destination is newer.\n";
                 }
@@ -102,26 +103,26 @@ int Mv::execute(const std::vector<std::string>& args) {
                     std::filesystem::copy_options::recursive,
                     ec);
                 if (ec) {
-                    std::cerr << RED << "mv: error copying file: " << ec.message() << RESET << "\n";
+                    Utils::err() << RED << "mv: error copying file: " << ec.message() << RESET << "\n";
                     return 1;
                 }
                 std::filesystem::remove_all(src, ec);
                 if (ec) {
-                    std::cerr << RED << "mv: error removing source: " << ec.message() << RESET << "\n";
+                    Utils::err() << RED << "mv: error removing source: " << ec.message() << RESET << "\n";
                     return 1;
                 }
             } else {
-                std::cerr << RED << "mv: error moving file: " << ec.message() << RESET << "\n";
+                Utils::err() << RED << "mv: error moving file: " << ec.message() << RESET << "\n";
                 return 1;
             }
         }
 
         if (verbose) {
-            std::cout << "Moved '" << src << "' to '" << dest << "'.\n";
+            Utils::out() << "Moved '" << src << "' to '" << dest << "'.\n";
         }
 
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << RED << "mv: error: " << e.what() << RESET << "\n";
+        Utils::err() << RED << "mv: error: " << e.what() << RESET << "\n";
         return 1;
     }
 
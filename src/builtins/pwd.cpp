@@ -1,4 +1,5 @@
 #include "../../include/builtins/pwd.h"
+#include "../../include/utils/streams.h"
 #include <utils/colors.h>
 #include <iostream>
 #include <filesystem>
@@ -7,10 +8,10 @@ namespace olsh::Builtins {
 
 int Pwd::execute(const std::vector<std::string>& args) {
     try {
-        std::cout << std::filesystem::current_path().string() << std::endl;
+        Utils::out() << std::filesystem::current_path().string() << std::endl;
         return 0;
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << RED << "pwd: " << e.what() << RESET << std::endl;
+        Utils::err() << RED << "pwd: " << e.what() << RESET << std::endl;
         return 1;
     }
 }
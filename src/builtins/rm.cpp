@@ -1,4 +1,5 @@
 #include "../../include/builtins/rm.h"
+#include "../../include/utils/streams.h"
 #include <utils/colors.h>
 #include <iostream>
 #include <filesystem>
@@ -7,8 +8,8 @@ namespace olsh::Builtins {
 
 int Rm::execute(const std::vector<std::string>& args) {
     if (args.empty()) {
-        std::cerr << RED << "rm: missing operand\n" << RESET;
-        std::cerr << "Usage: rm [-rf] [--] <file/directory>...\n";
+        Utils::err() << RED << "rm: missing operand\n" << RESET;
+        Utils::err() << "Usage: rm [-rf] [--] <file/directory>...\n";
         return 1;
     }
 
@@ -25,8 +26,8 @@ int Rm::execute(const std::vector<std::string>& args) {
                 if (arg == "--force") force = true;
                 else if (arg == "--recursive") recursive = true;
                 else {
-                    std::cerr << RED << "rm: unrecognized option '" << arg << "'\n" << RESET;
-                    std::cerr << "Usage: rm [-rf] [--] <file/directory>...\n";
+                    Utils::err() << RED << "rm: unrecognized option '" << arg << "'\n" << RESET;
+                    Utils::err() << "Usage: rm [-rf] [--] <file/directory>...\n";
                     return 1;
                 }
                 continue;
@@ -37,8 +38,8 @@ int Rm::execute(const std::vector<std::string>& args) {
                     case 'r': case 'R': recursive = true; break;
                     case 'f': force = true; break;
                     default:
-                        std::cerr << RED << "rm: invalid option -- '" << arg[j] << "'\n" << RESET;
-                        std::cerr << "Usage: rm [-rf] [--] <file/directory>...\n";
+                        Utils::err() << RED << "rm: invalid option -- '" << arg[j] << "'\n" << RESET;
+                        Utils::err() << "Usage: rm [-rf] [--] <file/directory>...\n";
                         return 1;
                 }
             }
@@ -49,8 +50,8 @@ int Rm::execute(const std::vector<std::string>& args) {
     }
 
     if (targets.empty()) {
-        std::cerr << RED << "rm: missing operand\n" << RESET;
-        std::cerr << "Usage: rm [-rf] [--] <file/directory>...\n";
+        Utils::err() << RED << "rm: missing operand\n" << RESET;
+        Utils::err() << "Usage: rm [-rf] [--] <file/directory>...\n";
         return 1;
     }
 
@@ -60,7 +61,7 @@ int Rm::execute(const std::vector<std::string>& args) {
             const std::filesystem::path p(target);
             if (!std::filesystem::exists(p)) {
                 if (!force) {
-                    std::cerr << RED << "rm: cannot remove '" << target << "': No such file or directory\n" << RESET;
+                    Utils::err() << RED << "rm: cannot remove '" << target << "': No such file or directory\n" << RESET;
                     result = 1;
                 }
                 continue; // skip missing files if -f
@@ -70,7 +71,7 @@ int Rm::execute(const std::vector<std::string>& args) {
                 if (recursive) {
                     std::filesystem::remove_all(p);
                 } else if (!force) {
-                    std::cerr << RED << "rm: cannot remove '" << target
+                    Utils::err() << RED << "rm: cannot remove '" << target
                               << "': Is a directory (use -r for recursive removal)\n"
                               << RESET;
                     result = 1;
@@ -80,7 +81,7 @@ int Rm::execute(const std::vector<std::string>& args) {
             }
         } catch (const std::filesystem::filesystem_error& e) {
             if (!force) {
-                std::cerr << RED << "rm: cannot remove '" << target << "': " << e.what() << RESET << std::endl;
+                Utils::err() << RED << "rm: cannot remove '" << target << "': " << e.what() << RESET << std::endl;
                 result = 1;
             }
             // if force, ignore exceptions
@@ -0,0 +1,87 @@
+#include "../../include/builtins/set.h"
+#include "../../include/utils/streams.h"
+#include "../../include/utils/profiler.h"
+#include "../../include/utils/xtrace.h"
+#include <utils/colors.h>
+#include <iostream>
+
+namespace olsh::Builtins {
+
+namespace {
+    struct Option {
+        const char* name;
+        char letter; // set -x for set -o xtrace, 0 if it only has the long name
+        bool (*get)();
+        void (*set)(bool);
+    };
+
+    const Option OPTIONS[] = {
+        {"profile", 0,
+         [] { return Utils::getProfiler().active(); },
+         [](bool on) { on ? Utils::getProfiler().start() : Utils::getProfiler().stop(); }},
+        {"xtrace", 'x',
+         [] { return Utils::getTracer().active(); },
+         [](bool on) { on ? Utils::getTracer().start() : Utils::getTracer().stop(); }},
+    };
+
+    const Option* find(const std::string& name) {
+        for (const auto& option : OPTIONS) {
+            if (name == option.name) return &option;
+        }
+        return nullptr;
+    }
+
+    const Option* find(char letter) {
+        for (const auto& option : OPTIONS) {
+            if (letter == option.letter) return &option;
+        }
+        return nullptr;
+    }
+}
+
+// set -o NAME / +o NAME and set -x / +x, - turns an option on and + off. without a name
+// (or with nothing at all) it shows what's on
+int Set::execute(const std::vector<std::string>& args) {
+    if (args.empty() || (args.size() == 1 && (args[0] == "-o" || args[0] == "+o"))) {
+        for (const auto& option : OPTIONS) {
+            Utils::out() << option.name << '\t' << (option.get() ? "on" : "off") << std::endl;
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg.size() < 2 || (arg[0] != '-' && arg[0] != '+')) {
+            Utils::err() << RED << "set: bad option: " << arg << RESET << std::endl;
+            return 1;
+        }
+        bool on = arg[0] == '-';
+
+        if (arg == "-o" || arg == "+o") {
+            if (++i == args.size()) {
+                Utils::err() << RED << "set: " << arg << ": option name expected" << RESET << std::endl;
+                return 1;
+            }
+            const Option* option = find(args[i]);
+            if (!option) {
+                Utils::err() << RED << "set: unknown option: " << args[i] << RESET << std::endl;
+                return 1;
+            }
+            option->set(on);
+            continue;
+        }
+
+        // letters, -x or several at once
+        for (size_t j = 1; j < arg.size(); ++j) {
+            const Option* option = find(arg[j]);
+            if (!option) {
+                Utils::err() << RED << "set: bad option: " << arg[0] << arg[j] << RESET << std::endl;
+                return 1;
+            }
+            option->set(on);
+        }
+    }
+    return 0;
+}
+
+} // namespace olsh::Builtins
@@ -0,0 +1,169 @@
+#include "../../include/builtins/tee.h"
+#include "../../include/utils/streams.h"
+#include "../../include/utils/zero_copy.h"
+#include <utils/colors.h>
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace olsh::Builtins {
+
+namespace {
+    int openOutput(const std::string& path, bool append) {
+#ifdef _WIN32
+        int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC);
+        return _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+        return open(path.c_str(), flags, 0644);
+#endif
+    }
+
+    void closeOutput(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+#ifdef __linux__
+    bool isPipe(int fd) {
+        struct stat st{};
+        return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    }
+
+    // pipe in, pipe out and one file: tee(2) puts the next bytes into the output pipe without
+    // reading them, then exactly those bytes are spliced into the file. none of it is copied
+    // through the shell. returns -1 if the kernel refused right away (nothing was consumed yet)
+    int spliceTee(int inFd, int outFd, int fileFd, const std::string& path) {
+        Utils::growPipe(inFd);
+        Utils::growPipe(outFd);
+        bool started = false;
+        for (;;) {
+            ssize_t n = tee(inFd, outFd, 1 << 30, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n == 0) return 0;
+            if (n < 0) {
+                if (!started) return -1;
+                if (errno != EPIPE) Utils::err() << RED << "tee: " << std::strerror(errno) << RESET << std::endl;
+                return 1;
+            }
+            started = true;
+
+            size_t left = static_cast<size_t>(n);
+            while (left > 0) {
+                ssize_t m = splice(inFd, nullptr, fileFd, nullptr, left, SPLICE_F_MOVE);
+                if (m < 0 && errno == EINTR) continue;
+                if (m > 0) {
+                    left -= static_cast<size_t>(m);
+                    continue;
+                }
+
+                // the file doesn't take splice (O_APPEND on older kernels...), the bytes still have
+                // to come out of the pipe so it's a plain read/write for this round
+                char buffer[64 * 1024];
+                ssize_t r = read(inFd, buffer, std::min(left, sizeof(buffer)));
+                if (r <= 0 || !Utils::writeAll(fileFd, buffer, static_cast<size_t>(r))) {
+                    Utils::err() << RED << "tee: " << path << ": " << std::strerror(errno) << RESET << std::endl;
+                    return 1;
+                }
+                left -= static_cast<size_t>(r);
+            }
+        }
+    }
+#endif
+
+    // whatever is there right now, at least one byte. 0 at EOF
+    std::streamsize readSome(std::istream& in, char* data, std::streamsize size) {
+        std::streambuf* buffer = in.rdbuf();
+        if (std::char_traits<char>::eq_int_type(buffer->sgetc(), std::char_traits<char>::eof())) return 0;
+        std::streamsize available = std::clamp<std::streamsize>(buffer->in_avail(), 1, size);
+        return buffer->sgetn(data, available);
+    }
+}
+
+int Tee::execute(const std::vector<std::string>& args) {
+    bool append = false;
+    std::vector<std::string> paths;
+    bool options = true;
+
+    for (const auto& arg : args) {
+        if (options && arg == "--") {
+            options = false;
+        } else if (options && (arg == "-a" || arg == "--append")) {
+            append = true;
+        } else if (options && arg.size() > 1 && arg[0] == '-') {
+            Utils::err() << RED << "tee: invalid option: " << arg << RESET << std::endl;
+            Utils::err() << "Usage: tee [-a] [file...]" << std::endl;
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    int status = 0;
+    std::vector<std::pair<int, std::string>> files;
+    for (const auto& path : paths) {
+        int fd = openOutput(path, append);
+        if (fd == -1) {
+            // like gnu tee, the other files still get written
+            Utils::err() << RED << "tee: " << path << ": " << std::strerror(errno) << RESET << std::endl;
+            status = 1;
+            continue;
+        }
+        files.emplace_back(fd, path);
+    }
+
+#ifdef __linux__
+    int inFd = Utils::zeroCopyEnabled() && files.size() <= 1 ? Utils::inFd() : -1;
+    int outFd = inFd != -1 ? Utils::outFd() : -1;
+    if (outFd != -1 && files.empty()) {
+        // nothing to duplicate, it's just cat
+        status |= Utils::copyFd(inFd, outFd) < 0 ? 1 : 0;
+        return status;
+    }
+    if (outFd != -1 && isPipe(inFd) && isPipe(outFd)) {
+        int rc = spliceTee(inFd, outFd, files[0].first, files[0].second);
+        if (rc != -1) {
+            closeOutput(files[0].first);
+            return status | rc;
+        }
+    }
+#endif
+
+    char buffer[64 * 1024];
+    std::streamsize n;
+    while ((n = readSome(Utils::in(), buffer, sizeof(buffer))) > 0) {
+        Utils::out().write(buffer, n);
+        for (auto it = files.begin(); it != files.end();) {
+            if (Utils::writeAll(it->first, buffer, static_cast<size_t>(n))) {
+                ++it;
+                continue;
+            }
+            Utils::err() << RED << "tee: " << it->second << ": " << std::strerror(errno) << RESET << std::endl;
+            closeOutput(it->first);
+            it = files.erase(it);
+            status = 1;
+        }
+        // a terminal or a slow producer still sees every chunk right away
+        if (Utils::in().rdbuf()->in_avail() <= 0) Utils::out().flush();
+    }
+    Utils::out().flush();
+
+    for (const auto& file : files) closeOutput(file.first);
+    return status;
+}
+
+} // namespace olsh::Builtins
@@ -0,0 +1,154 @@
+#include "builtins/time.h"
+#include "utils/streams.h"
+#include "executor/resource_usage.h"
+#include "../include/shell.h"
+#include <utils/colors.h>
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace olsh::Builtins {
+
+Shell* Time::s_shell = nullptr;
+
+void Time::setShellInstance(Shell* shell) {
+    s_shell = shell;
+}
+
+namespace {
+    // 1m2.345s, like bash
+    std::string minutes(double seconds) {
+        char buffer[64];
+        int whole = static_cast<int>(seconds / 60);
+        std::snprintf(buffer, sizeof(buffer), "%dm%.3fs", whole, seconds - whole * 60.0);
+        return buffer;
+    }
+
+    std::string plain(double seconds) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.2f", seconds);
+        return buffer;
+    }
+
+#ifndef _WIN32
+    // the shell itself (builtins, threads) plus every child it reaped
+    ResourceUsage snapshot() {
+        struct rusage self{}, children{};
+        getrusage(RUSAGE_SELF, &self);
+        getrusage(RUSAGE_CHILDREN, &children);
+        ResourceUsage usage = ResourceUsage::fromRusage(self, 0);
+        usage.add(ResourceUsage::fromRusage(children, 0));
+        return usage;
+    }
+#endif
+}
+
+int Time::execute(const std::vector<std::string>& args) {
+    // only ends up here from a pipeline stage or a script, the quoting is already gone
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) line += ' ';
+        line += arg;
+    }
+    return run(line);
+}
+
+int Time::run(const std::string& line) {
+    if (!s_shell) {
+        Utils::err() << RED << "time: Shell instance not set" << RESET << "\n";
+        return 1;
+    }
+
+    bool posix = false;
+    bool verbose = false;
+    size_t pos = 0;
+    for (;;) {
+        size_t start = line.find_first_not_of(" \t", pos);
+        if (start == std::string::npos) {
+            pos = line.size();
+            break;
+        }
+        size_t end = line.find_first_of(" \t", start);
+        std::string word = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (word == "-p") {
+            posix = true;
+        } else if (word == "-v") {
+            verbose = true;
+        } else if (word == "--") {
+            pos = end == std::string::npos ? line.size() : end;
+            break;
+        } else if (word.size() > 1 && word[0] == '-') {
+            Utils::err() << RED << "time: invalid option: " << word << RESET << std::endl;
+            Utils::err() << "Usage: time [-p] [-v] command [args...]" << std::endl;
+            return 1;
+        } else {
+            pos = start;
+            break;
+        }
+        pos = end == std::string::npos ? line.size() : end;
+    }
+
+    std::string command = line.substr(pos);
+    if (command.find_first_not_of(" \t") == std::string::npos) {
+        Utils::err() << "Usage: time [-p] [-v] command [args...]" << std::endl;
+        return 1;
+    }
+
+    unsigned long generation = getLastUsageGeneration();
+    auto started = std::chrono::steady_clock::now();
+#ifndef _WIN32
+    ResourceUsage before = snapshot();
+#endif
+
+    int result = s_shell->processCommand(command);
+
+    std::chrono::duration<double> real = std::chrono::steady_clock::now() - started;
+    ResourceUsage used; // only the wall clock on windows
+#ifndef _WIN32
+    ResourceUsage after = snapshot();
+    used.user = after.user - before.user;
+    used.sys = after.sys - before.sys;
+    used.voluntarySwitches = after.voluntarySwitches - before.voluntarySwitches;
+    used.involuntarySwitches = after.involuntarySwitches - before.involuntarySwitches;
+    used.minorFaults = after.minorFaults - before.minorFaults;
+    used.majorFaults = after.majorFaults - before.majorFaults;
+#endif
+    used.real = real.count();
+
+    // what the command itself peaked at, the shell's own rss isn't interesting
+    bool ran = getLastUsageGeneration() != generation;
+    if (ran) used.maxRss = totalUsage(getLastUsage()).maxRss;
+
+    std::ostream& out = Utils::err();
+    if (posix) {
+        out << "real " << plain(used.real) << "\n"
+            << "user " << plain(used.user) << "\n"
+            << "sys " << plain(used.sys) << "\n";
+    } else {
+        out << "\n"
+            << "real\t" << minutes(used.real) << "\n"
+            << "user\t" << minutes(used.user) << "\n"
+            << "sys\t" << minutes(used.sys) << "\n";
+    }
+
+    if (verbose) {
+        out << "maxrss\t" << used.maxRss << " kB\n"
+            << "ctxsw\t" << used.voluntarySwitches << " voluntary, " << used.involuntarySwitches << " involuntary\n"
+            << "faults\t" << used.minorFaults << " minor, " << used.majorFaults << " major\n";
+        // one line per pipeline stage when the last thing that ran was ours
+        const auto& stages = getLastUsage();
+        for (size_t i = 0; ran && stages.size() > 1 && i < stages.size(); ++i) {
+            out << "stage " << i + 1;
+            if (!stages[i].command.empty()) out << " (" << stages[i].command << ")";
+            out << ": " << stages[i].format() << "\n";
+        }
+    }
+    out.flush();
+    return result;
+}
+
+} // namespace olsh::Builtins
@@ -1,4 +1,5 @@
 #include "../../include/builtins/touch.h"
+#include "../../include/utils/streams.h"
 #include <utils/colors.h>
 #include <filesystem>
 #include <iostream>
@@ -9,8 +10,8 @@ namespace olsh::Builtins {
 
 int Touch::execute(const std::vector<std::string> &args) {
     if (args.empty()) {
-        std::cerr << RED << "touch: missing file operand\n" << RESET;
-        std::cerr << "Usage: touch [options] <file>...\n";
+        Utils::err() << RED << "touch: missing file operand\n" << RESET;
+        Utils::err() << "Usage: touch [options] <file>...\n";
         return 1;
     }
 
@@ -33,12 +34,12 @@ int Touch::execute(const std::vector<std::string> &args) {
             noCreate = true;
         } else if (arg == "-r") {
             if (i + 1 >= args.size()) {
-                std::cerr << RED << "touch: option requires an argument -- 'r'\n" << RESET;
+                Utils::err() << RED << "touch: option requires an argument -- 'r'\n" << RESET;
                 return 1;
             }
             std::filesystem::path refPath = args[++i];
             if (!std::filesystem::exists(refPath)) {
-                std::cerr << RED << "touch: cannot stat '" << refPath << "': No such file\n" << RESET;
+                Utils::err() << RED << "touch: cannot stat '" << refPath << "': No such file\n" << RESET;
                 return 1;
             }
             refTime = std::filesystem::last_write_time(refPath);
@@ -49,7 +50,7 @@ int Touch::execute(const std::vector<std::string> &args) {
     }
 
     if (files.empty()) {
-        std::cerr << RED << "touch: missing file operand\n" << RESET;
+        Utils::err() << RED << "touch: missing file operand\n" << RESET;
         return 1;
     }
 
@@ -63,7 +64,7 @@ int Touch::execute(const std::vector<std::string> &args) {
                 // create file
                 std::ofstream ofs(p);
                 if (!ofs) {
-                    std::cerr << RED << "touch: cannot create file '" << p << "'\n" << RESET;
+                    Utils::err() << RED << "touch: cannot create file '" << p << "'\n" << RESET;
                     return 1;
                 }
             }
@@ -81,7 +82,7 @@ int Touch::execute(const std::vector<std::string> &args) {
             }
         }
     } catch (const std::filesystem::filesystem_error &e) {
-        std::cerr << RED << "touch: " << e.what() << "\n" << RESET;
+        Utils::err() << RED << "touch: " << e.what() << "\n" << RESET;
         return 1;
     }
 
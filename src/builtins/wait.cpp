@@ -0,0 +1,53 @@
+#include "../../include/builtins/wait.h"
+#include "../../include/utils/streams.h"
+#include "../../include/executor/job_table.h"
+#include <utils/colors.h>
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+
+namespace olsh::Builtins {
+
+int Wait::execute(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    // background jobs run in the foreground on windows, nothing to wait for
+    return 0;
+#else
+    JobTable& jobs = getJobTable();
+
+    // no args means wait for every running job, stopped ones would never finish
+    if (args.empty()) {
+        for (Job* job : jobs.list()) {
+            if (job->state == Job::State::RUNNING) jobs.wait(*job);
+            if (job->state == Job::State::DONE) jobs.remove(job->id);
+        }
+        return 0;
+    }
+
+    int result = 0;
+    for (const auto& arg : args) {
+        std::string error;
+        Job* job = jobs.resolve(arg, error);
+        if (!job) {
+            Utils::err() << RED << "wait: " << arg << ": " << error << RESET << std::endl;
+            result = 127;
+            continue;
+        }
+
+        result = jobs.wait(*job);
+        if (job->state != Job::State::DONE) continue;
+
+        // a pid gets its own status, a job spec the one of its last process
+        if (arg[0] != '%') {
+            pid_t pid = 0;
+            std::from_chars(arg.data(), arg.data() + arg.size(), pid); // resolve() already found it
+            auto it = std::find(job->pids.begin(), job->pids.end(), pid);
+            result = JobTable::decodeStatus(job->statuses[it - job->pids.begin()]);
+        }
+        jobs.remove(job->id);
+    }
+    return result;
+#endif
+}
+
+} // namespace olsh::Builtins
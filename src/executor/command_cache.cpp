@@ -0,0 +1,163 @@
+#include "../../include/executor/command_cache.h"
+#include "../../include/utils/windows_compat.h"
+#include <algorithm>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace olsh {
+
+namespace {
+#ifdef _WIN32
+    constexpr char PATH_LIST_SEPARATOR = ';';
+#else
+    constexpr char PATH_LIST_SEPARATOR = ':';
+#endif
+
+    bool isExecutable(const std::string& path) {
+#ifdef _WIN32
+        std::error_code ec;
+        return std::filesystem::is_regular_file(path, ec);
+#else
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(path.c_str(), X_OK) == 0;
+#endif
+    }
+}
+
+std::string CommandCache::lookup(const std::string& command) {
+    if (command.empty()) return "";
+    if (command.find('/') != std::string::npos || command.find(PATH_SEPARATOR) != std::string::npos) {
+        return command;
+    }
+
+    // hash -p entries are trusted as they are
+    auto it = found.find(command);
+    if (it != found.end() && it->second.dirIndex == std::string::npos) {
+        it->second.hits++;
+        return it->second.path;
+    }
+
+    validate();
+
+    it = found.find(command);
+    if (it != found.end()) {
+        it->second.hits++;
+        return it->second.path;
+    }
+    if (missing.count(command)) {
+        return "";
+    }
+
+    size_t dirIndex = std::string::npos;
+    std::string path = search(command, dirIndex);
+    if (path.empty()) {
+        if (cacheMisses) {
+            if (missing.size() >= MAX_MISSES) missing.clear();
+            missing.insert(command);
+        }
+        return "";
+    }
+
+    // results from relative PATH entries change with the cwd, don't keep those
+    if (Utils::WindowsCompat::isAbsolutePath(dirs[dirIndex])) {
+        found[command] = Entry{path, dirIndex, 1};
+    }
+    return path;
+}
+
+void CommandCache::add(const std::string& command, const std::string& path) {
+    missing.erase(command);
+    found[command] = Entry{path, std::string::npos, 0};
+}
+
+void CommandCache::forget(const std::string& command) {
+    found.erase(command);
+    missing.erase(command);
+}
+
+void CommandCache::clear() {
+    found.clear();
+    missing.clear();
+}
+
+std::vector<std::pair<std::string, CommandCache::Entry>> CommandCache::getEntries() const {
+    std::vector<std::pair<std::string, Entry>> entries(found.begin(), found.end());
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return entries;
+}
+
+void CommandCache::validate() {
+    const char* env = std::getenv("PATH");
+    std::string value = env ? env : "";
+    if (value != pathValue || dirs.empty()) {
+        loadPath(value);
+        return;
+    }
+
+    // a new file in a directory changes its mtime. that can shadow anything found in a later
+    // directory or satisfy a miss, and removals can only affect commands found in that directory
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(dirs[i], ec);
+        if (ec) time = {};
+        if (time == dirTimes[i]) continue;
+
+        dirTimes[i] = time;
+        missing.clear();
+        std::erase_if(found, [i](const auto& item) {
+            return item.second.dirIndex != std::string::npos && item.second.dirIndex >= i;
+        });
+    }
+}
+
+void CommandCache::loadPath(const std::string& value) {
+    pathValue = value;
+    dirs.clear();
+    dirTimes.clear();
+    cacheMisses = true;
+
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(PATH_LIST_SEPARATOR, start);
+        if (end == std::string::npos) end = value.size();
+
+        std::string dir = value.substr(start, end - start);
+        if (dir.empty()) dir = "."; // empty entry means the current directory
+        if (!Utils::WindowsCompat::isAbsolutePath(dir)) cacheMisses = false;
+
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(dir, ec);
+        dirs.push_back(dir);
+        dirTimes.push_back(ec ? std::filesystem::file_time_type{} : time);
+
+        start = end + 1;
+    }
+
+    // everything found through the old PATH is stale, pinned entries stay
+    missing.clear();
+    std::erase_if(found, [](const auto& item) { return item.second.dirIndex != std::string::npos; });
+}
+
+std::string CommandCache::search(const std::string& command, size_t& dirIndex) const {
+    std::string name = command + Utils::WindowsCompat::getExecutableExtension();
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        std::string candidate = dirs[i] + PATH_SEPARATOR_STR + name;
+        if (isExecutable(candidate)) {
+            dirIndex = i;
+            return candidate;
+        }
+    }
+    return "";
+}
+
+CommandCache& getCommandCache() {
+    static CommandCache instance;
+    return instance;
+}
+
+} // namespace olsh
@@ -1,40 +1,171 @@
 #include "../../include/executor/executor.h"
 #include "../../include/executor/process.h"
+#include "../../include/executor/job_table.h"
 #include "../../include/parser/ast.h"
 #include "../../include/parser/parser.h"
 #include "../../include/builtins/builtin_registry.h"
+#include "../../include/utils/fd_stream.h"
+#include "../../include/utils/ring_buffer.h"
+#include "../../include/utils/streams.h"
+#include "../../include/utils/event_loop.h"
+#include "../../include/utils/profiler.h"
+#include "../../include/utils/xtrace.h"
 #include <utils/colors.h>
 #include <iostream>
-#ifdef _WIN32
-#include <io.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#else
+#ifndef _WIN32
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/stat.h>
+#include <signal.h>
+#include <sys/resource.h>
 #endif
+#include <chrono>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 namespace olsh {
 
+#ifndef _WIN32
+namespace {
+    // command line of a node as shown by jobs
+    std::string describe(const Parser::ASTNode& node) {
+        std::string text;
+        switch (node.getType()) {
+            case Parser::CommandType::BUILTIN:
+            case Parser::CommandType::EXTERNAL: {
+                const auto& cmd = static_cast<const Parser::Command&>(node);
+                text = cmd.name;
+                for (const auto& arg : cmd.args) {
+                    text += ' ';
+                    text += arg;
+                }
+                for (const auto& action : cmd.redirects) {
+                    switch (action.type) {
+                        case FdAction::Type::READ:
+                            text += " " + (action.fd == 0 ? "" : std::to_string(action.fd)) + "< " + action.path;
+                            break;
+                        case FdAction::Type::WRITE:
+                            text += " " + (action.fd == 1 ? "" : std::to_string(action.fd)) + "> " + action.path;
+                            break;
+                        case FdAction::Type::APPEND:
+                            text += " " + (action.fd == 1 ? "" : std::to_string(action.fd)) + ">> " + action.path;
+                            break;
+                        case FdAction::Type::DUP:
+                            text += " " + std::to_string(action.fd) + ">&" + std::to_string(action.sourceFd);
+                            break;
+                    }
+                }
+                break;
+            }
+            case Parser::CommandType::PIPELINE:
+                for (const auto& cmd : static_cast<const Parser::Pipeline&>(node).commands) {
+                    if (!text.empty()) text += " | ";
+                    text += describe(*cmd);
+                }
+                break;
+            case Parser::CommandType::SEQUENCE:
+                for (const auto& item : static_cast<const Parser::Sequence&>(node).nodes) {
+                    if (!text.empty()) text += "; ";
+                    text += describe(*item);
+                }
+                break;
+            case Parser::CommandType::BACKGROUND:
+                text = describe(*static_cast<const Parser::Background&>(node).node) + " &";
+                break;
+        }
+        return text;
+    }
+
+    // builtins that would read the terminal. as a thread they can't be in the job's
+    // process group, so they'd lose the terminal to the external stages
+    bool readsTerminal(const Parser::Command& cmd) {
+        for (const auto& action : cmd.redirects) {
+            if (action.fd == 0) return false;
+        }
+        return (cmd.name == "cat" && cmd.args.empty()) || cmd.name == "tee" || cmd.name == "mv";
+    }
+
+    // for when out() isn't an fd at all (a script's $(...) collecting into memory). the child
+    // writes into a pipe and the shell's loop copies whatever arrives into out() while the
+    // shell waits for the job, so a child with a lot to say never blocks on a full pipe
+    class OutputPump {
+    private:
+        std::ostream& target;
+        int fds[2] = {-1, -1};
+        int watch = -1;
+
+        void drain() {
+            char buffer[64 * 1024];
+            ssize_t n;
+            while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+                target.write(buffer, n);
+            }
+            // at EOF the pipe stays readable forever, the loop would spin on it
+            if (n == 0 && watch != -1) {
+                Utils::getEventLoop().remove(watch);
+                watch = -1;
+            }
+        }
+
+    public:
+        explicit OutputPump(std::ostream& sink) : target(sink) {
+            if (pipe(fds) == -1) {
+                std::perror("pipe");
+                fds[0] = fds[1] = -1;
+                return;
+            }
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[0], F_SETFL, O_NONBLOCK);
+            watch = Utils::getEventLoop().watchFd(fds[0], [this] { drain(); });
+        }
+
+        ~OutputPump() {
+            started();
+            if (fds[0] == -1) return;
+            drain(); // whatever came in after the last wakeup
+            if (watch != -1) Utils::getEventLoop().remove(watch);
+            close(fds[0]);
+            target.flush();
+        }
+
+        OutputPump(const OutputPump&) = delete;
+        OutputPump& operator=(const OutputPump&) = delete;
+
+        // the end the children write to, -1 if there's no pipe
+        int writeFd() const { return fds[1]; }
+
+        // the children have their copies now. the shell's has to go or there's never an EOF
+        void started() {
+            if (fds[1] != -1) close(fds[1]);
+            fds[1] = -1;
+        }
+    };
+}
+#endif
+
 Executor::Executor() {}
 
-int Executor::execute(std::unique_ptr<Parser::ASTNode> node) {
-    if (!node) {
+int Executor::execute(const Parser::Tree& tree) {
+    if (!tree) {
         std::cerr << RED << "Error: Invalid command\n" << RESET;
         return 1;
     }
 
-    switch (node->getType()) {
+    return executeNode(*tree);
+}
+
+int Executor::executeNode(const Parser::ASTNode& node) {
+    switch (node.getType()) {
         case Parser::CommandType::BUILTIN:
         case Parser::CommandType::EXTERNAL:
-            return executeCommand(*static_cast<Parser::Command*>(node.get()));
+            return executeCommand(static_cast<const Parser::Command&>(node));
         case Parser::CommandType::PIPELINE:
-            return executePipeline(*static_cast<Parser::Pipeline*>(node.get()));
-        case Parser::CommandType::REDIRECTION:
-            return executeRedirection(*static_cast<Parser::Redirection*>(node.get()));
+            return executePipeline(static_cast<const Parser::Pipeline&>(node));
+        case Parser::CommandType::SEQUENCE:
+            return executeSequence(static_cast<const Parser::Sequence&>(node));
+        case Parser::CommandType::BACKGROUND:
+            return executeBackground(static_cast<const Parser::Background&>(node));
         default:
             std::cerr << RED << "Error: Unknown command type\n" << RESET;
             return 1;
@@ -44,21 +175,103 @@ int Executor::execute(std::unique_ptr<Parser::ASTNode> node) {
 int Executor::executeCommand(const Parser::Command& cmd) {
     // builtins
     if (cmd.getType() == Parser::CommandType::BUILTIN) {
-        return getBuiltinRegistry().execute(cmd.name, cmd.args);
+        return executeBuiltin(cmd);
     }
 
     // externals
     return executeExternal(cmd);
 }
 
+int Executor::executeBuiltin(const Parser::Command& cmd) {
+    return executeBuiltin(std::string(cmd.name), cmd.argVector(), cmd.redirects);
+}
+
+int Executor::executeBuiltin(const std::string& name, const std::vector<std::string>& args,
+                             const RedirectPlan& redirects) {
+    if (redirects.empty()) {
+        return getBuiltinRegistry().execute(name, args);
+    }
+
+    // builtins run inside the shell, so instead of dup2'ing over the shell's own fds
+    // they get streams over the plan's target fds for the duration of the call
+    std::streambuf* targets[3] = {Utils::in().rdbuf(), Utils::out().rdbuf(), Utils::err().rdbuf()};
+    std::vector<std::unique_ptr<Utils::FdStreamBuf>> buffers;
+
+    for (const auto& action : redirects) {
+        if (action.fd < 0 || action.fd > 2) continue; // builtins only use stdin/stdout/stderr
+
+        if (action.type == FdAction::Type::DUP) {
+            if (action.sourceFd < 0 || action.sourceFd > 2) {
+                Utils::err() << RED << "redirection: bad file descriptor: " << action.sourceFd << RESET << std::endl;
+                return 1;
+            }
+            targets[action.fd] = targets[action.sourceFd];
+            continue;
+        }
+
+        int fd = action.openTarget();
+        if (fd == -1) {
+            Utils::err() << RED << "redirection: failed to open file: " << action.path << RESET << std::endl;
+            return 1;
+        }
+        buffers.push_back(std::make_unique<Utils::FdStreamBuf>(fd, true));
+        targets[action.fd] = buffers.back().get();
+    }
+
+    // whatever is still buffered belongs to the old target
+    Utils::out().flush();
+    Utils::err().flush();
+
+    std::istream input(targets[0]);
+    std::ostream output(targets[1]);
+    std::ostream errors(targets[2]);
+
+    int result = 1;
+    {
+        Utils::StreamScope scope(&input, &output, &errors);
+        try {
+            result = getBuiltinRegistry().execute(name, args);
+        } catch (const std::exception& e) {
+            errors << RED << name << ": " << e.what() << RESET << std::endl;
+        }
+        output.flush();
+        errors.flush();
+    }
+
+    // closed when the buffers go away
+    return result;
+}
+
 int Executor::executeExternal(const Parser::Command& cmd) {
+    Utils::ScriptProfiler::Span span(Utils::getProfiler(), Utils::ScriptProfiler::Category::FORK);
+    // what's still in the trace buffer would come out of the child too
+    Utils::Tracer& tracer = Utils::getTracer();
+    if (tracer.active()) tracer.flush();
     Process process;
-    return process.execute(cmd.name, cmd.args);
+#ifndef _WIN32
+    // out() is somewhere else than fd 1 while it's being captured, the child writes there too
+    int target = Utils::outFd();
+    if (target != STDOUT_FILENO) {
+        std::unique_ptr<OutputPump> pump;
+        if (target == -1) {
+            pump = std::make_unique<OutputPump>(Utils::out());
+            target = pump->writeFd();
+        }
+        pid_t pid = process.start(std::string(cmd.name), cmd.argVector(), 0, -1, target, cmd.redirects);
+        if (pump) pump->started();
+        if (pid < 0) return 127;
+        return process.waitAll({pid}, pid, describe(cmd));
+    }
+#endif
+    return process.execute(std::string(cmd.name), cmd.argVector(), cmd.redirects);
 }
 
 int Executor::executePipeline(const Parser::Pipeline& pipeline) {
-    // for now executed sequentally
-    // TODO: make this better (idk how pls help)
+    Utils::ScriptProfiler::Span span(Utils::getProfiler(), Utils::ScriptProfiler::Category::FORK);
+    Utils::Tracer& tracer = Utils::getTracer();
+    if (tracer.active()) tracer.flush();
+#ifdef _WIN32
+    // TODO: real pipes on windows (CreatePipe + inherited handles)
     int result = 0;
     try { // for some reason it crashes without the try
         for (const auto& cmd : pipeline.commands) {
@@ -69,71 +282,258 @@ int Executor::executePipeline(const Parser::Pipeline& pipeline) {
         result = 1;
     }
     return result;
+#else
+    Process process;
+    std::vector<pid_t> pids;
+    pid_t pgid = 0;
+    std::vector<StageThread> threads;
+
+    // a last stage that's a process can't write into out() when that isn't an fd, it gets a pump
+    int lastOutFd = Utils::outFd();
+    std::unique_ptr<OutputPump> pump;
+    if (lastOutFd == -1 && !runsOnThread(pipeline, pipeline.commands.size() - 1)) {
+        pump = std::make_unique<OutputPump>(Utils::out());
+        lastOutFd = pump->writeFd();
+    }
+    bool lastStarted = launchPipeline(pipeline, -1, pids, pgid, &threads,
+                                      lastOutFd == STDOUT_FILENO ? -1 : lastOutFd);
+    if (pump) pump->started();
+
+    int result = pids.empty() ? 0 : process.waitAll(pids, pgid, describe(pipeline));
+
+    // ctrl+z can't stop a thread. the job lives on without the shell waiting for them,
+    // they finish whenever the stopped stages let them
+    bool stopped = false;
+    for (Job* job : getJobTable().list()) {
+        if (job->pgid == pgid && job->state == Job::State::STOPPED) stopped = true;
+    }
+    for (auto& stage : threads) {
+        if (stopped) {
+            stage.thread.detach();
+            continue;
+        }
+        stage.thread.join();
+        if (stage.stage + 1 == pipeline.commands.size()) result = *stage.result;
+    }
+
+    if (!stopped && !threads.empty()) {
+        // waitAll() already published the processes, put the thread stages in between them.
+        // names only line up when every process stage actually started
+        std::vector<ResourceUsage> processes = pids.empty() ? std::vector<ResourceUsage>() : getLastUsage();
+        bool named = processes.size() + threads.size() == pipeline.commands.size();
+        std::vector<ResourceUsage> stages;
+        size_t next = 0;
+        for (size_t i = 0, t = 0; i < pipeline.commands.size(); ++i) {
+            if (t < threads.size() && threads[t].stage == i) {
+                stages.push_back(*threads[t++].usage);
+            } else if (next < processes.size()) {
+                stages.push_back(processes[next++]);
+            } else {
+                continue;
+            }
+            stages.back().command = named ? describe(*pipeline.commands[i]) : std::string();
+        }
+        setLastUsage(std::move(stages));
+    }
+    return lastStarted ? result : 1;
+#endif
 }
 
-int Executor::executeRedirection(const Parser::Redirection& redirection) {
-    int target = redirection.input ? 0 : 1; // stdin or stdout
-    int file_fd = -1;
-#ifdef _WIN32
-    if (redirection.input) {
-        file_fd = _open(redirection.filename.c_str(), _O_RDONLY);
-    } else {
-        int flags = redirection.append ? (_O_WRONLY | _O_CREAT | _O_APPEND)
-                                       : (_O_WRONLY | _O_CREAT | _O_TRUNC);
-        file_fd = _open(redirection.filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#ifndef _WIN32
+bool Executor::runsOnThread(const Parser::Pipeline& pipeline, size_t stage) const {
+    const auto& cmd = *pipeline.commands[stage];
+    if (cmd.getType() != Parser::CommandType::BUILTIN) return false;
+    if (!getBuiltinRegistry().canRunInThread(std::string(cmd.name))) return false;
+
+    // the terminal goes to the external stages' group, a first stage reading it stays a process
+    if (stage == 0 && getJobTable().isInteractive() && readsTerminal(cmd)) {
+        for (const auto& other : pipeline.commands) {
+            if (other->getType() == Parser::CommandType::EXTERNAL) return false;
+        }
     }
+    return true;
+}
+
+bool Executor::launchPipeline(const Parser::Pipeline& pipeline, int firstInFd,
+                              std::vector<pid_t>& pids, pid_t& pgid,
+                              std::vector<StageThread>* threads, int lastOutFd) {
+    // every stage is started up front and runs at the same time. externals get real pipes,
+    // builtins run on threads of the shell (no fork) and talk to each other through
+    // in-memory ring buffers, so a pipe only exists where a process is on one side
+    Process process;
+    int inFd = firstInFd;
+    std::shared_ptr<Utils::RingBuffer> inRing;
+    bool lastStarted = false;
+
+    for (size_t i = 0; i < pipeline.commands.size(); ++i) {
+        const auto& cmd = *pipeline.commands[i];
+        bool last = i + 1 == pipeline.commands.size();
+        bool threaded = threads && runsOnThread(pipeline, i);
+
+        int fds[2] = {-1, -1};
+        std::shared_ptr<Utils::RingBuffer> outRing;
+        if (last && !threaded && lastOutFd != -1) {
+            // a copy of its own, it gets closed like a pipe end once the stage started
+            fds[1] = fcntl(lastOutFd, F_DUPFD_CLOEXEC, 3);
+        } else if (!last) {
+            if (threaded && runsOnThread(pipeline, i + 1)) {
+                outRing = std::make_shared<Utils::RingBuffer>();
+            } else if (pipe(fds) == -1) {
+                std::perror("pipe");
+                break;
+            } else {
+                fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+                fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+            }
+        }
+
+        if (threaded) {
+            // the thread owns its ends and closes them when the builtin returns,
+            // that's the reader's EOF
+            auto result = std::make_shared<int>(1);
+            auto usage = std::make_shared<ResourceUsage>();
+            // ends without a ring or pipe are whatever this thread reads and writes right now
+            std::istream* parentIn = &Utils::in();
+            std::ostream* parentOut = &Utils::out();
+            std::ostream* parentErr = &Utils::err();
+            // the thread gets its own copy of the command, a stopped job's threads can outlive the tree
+            std::thread thread([this, name = std::string(cmd.name), args = cmd.argVector(),
+                                redirects = cmd.redirects, inRing, inFd, outRing,
+                                outFd = fds[1], result, usage, parentIn, parentOut, parentErr]() {
+                // a reader that went away shows up as a failed write instead of killing the shell
+                sigset_t pipeSignal;
+                sigemptyset(&pipeSignal);
+                sigaddset(&pipeSignal, SIGPIPE);
+                pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+
+                std::unique_ptr<std::streambuf> inBuf;
+                std::unique_ptr<std::streambuf> outBuf;
+                if (inRing) {
+                    inBuf = std::make_unique<Utils::RingStreamBuf>(inRing, Utils::RingStreamBuf::End::READ);
+                } else if (inFd != -1) {
+                    inBuf = std::make_unique<Utils::FdStreamBuf>(inFd, true);
+                }
+                if (outRing) {
+                    outBuf = std::make_unique<Utils::RingStreamBuf>(outRing, Utils::RingStreamBuf::End::WRITE);
+                } else if (outFd != -1) {
+                    outBuf = std::make_unique<Utils::FdStreamBuf>(outFd, true);
+                }
+
+                std::istream input(inBuf.get());
+                std::ostream output(outBuf.get());
+                Utils::StreamScope scope(inBuf ? &input : parentIn, outBuf ? &output : parentOut, parentErr);
+
+                auto started = std::chrono::steady_clock::now();
+#ifdef RUSAGE_THREAD
+                struct rusage before{};
+                getrusage(RUSAGE_THREAD, &before);
+#endif
+                try {
+                    *result = executeBuiltin(name, args, redirects);
+                } catch (const std::exception& e) {
+                    Utils::err() << RED << name << ": " << e.what() << RESET << std::endl;
+                }
+                Utils::out().flush();
+
+                std::chrono::duration<double> real = std::chrono::steady_clock::now() - started;
+#ifdef RUSAGE_THREAD
+                struct rusage after{};
+                getrusage(RUSAGE_THREAD, &after);
+                *usage = ResourceUsage::between(before, after, real.count());
 #else
-    if (redirection.input) {
-        file_fd = open(redirection.filename.c_str(), O_RDONLY);
-    } else {
-        int flags = redirection.append ? (O_WRONLY | O_CREAT | O_APPEND)
-                                       : (O_WRONLY | O_CREAT | O_TRUNC);
-        file_fd = open(redirection.filename.c_str(), flags, 0644);
+                usage->real = real.count(); // no per-thread counters here (macOS)
+#endif
+            });
+            threads->push_back({std::move(thread), i, result, usage});
+
+            inFd = fds[0];
+            inRing = outRing;
+            lastStarted = last;
+            continue;
+        }
+
+        pid_t pid;
+        if (cmd.getType() == Parser::CommandType::BUILTIN) {
+            pid = process.startFunction([this, &cmd]() {
+                // the child's stdio was set up for the stage, not whatever the parent's thread
+                // had in()/out() pointed at
+                Utils::StreamScope scope(&std::cin, &std::cout, nullptr);
+                return executeBuiltin(cmd);
+            }, pgid, inFd, fds[1], fds[0]);
+        } else {
+            pid = process.start(std::string(cmd.name), cmd.argVector(), pgid, inFd, fds[1], cmd.redirects);
+        }
+
+        // the children own these now
+        if (inFd != -1 && inFd != firstInFd) close(inFd);
+        if (fds[1] != -1) close(fds[1]);
+        inFd = fds[0];
+        inRing = nullptr;
+
+        if (pid > 0) {
+            if (pgid == 0) pgid = pid;
+            pids.push_back(pid);
+            lastStarted = last;
+        }
     }
+    if (inFd != -1 && inFd != firstInFd) close(inFd);
+    if (inRing) inRing->closeRead(); // nobody started to read it, don't leave the writer blocked
+
+    return lastStarted;
+}
 #endif
-    if (file_fd == -1) {
-        std::cerr << RED << "redirection: failed to open file: " << redirection.filename << RESET << std::endl;
-        return 1;
+
+int Executor::executeSequence(const Parser::Sequence& sequence) {
+    int result = 0;
+    for (const auto& node : sequence.nodes) {
+        result = executeNode(*node);
     }
+    return result;
+}
 
-    int saved = -1;
+int Executor::executeBackground(const Parser::Background& background) {
 #ifdef _WIN32
-    saved = _dup(target);
-    _dup2(file_fd, target);
-    _close(file_fd);
+    // TODO: detached processes on windows, runs in the foreground for now
+    return executeNode(*background.node);
 #else
-    saved = dup(target);
-    dup2(file_fd, target);
-    close(file_fd);
-#endif
+    // background jobs don't get the shell's input, it would steal the next commands
+    int nullFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
 
-    int result = 0;
-    switch (redirection.command->getType()) {
-        case Parser::CommandType::BUILTIN:
-        case Parser::CommandType::EXTERNAL:
-            result = executeCommand(*static_cast<Parser::Command*>(redirection.command.get()));
+    Process process;
+    std::vector<pid_t> pids;
+    pid_t pgid = 0;
+    const Parser::ASTNode& node = *background.node;
+
+    switch (node.getType()) {
+        case Parser::CommandType::EXTERNAL: {
+            const auto& cmd = static_cast<const Parser::Command&>(node);
+            pid_t pid = process.start(std::string(cmd.name), cmd.argVector(), 0, nullFd, -1, cmd.redirects);
+            if (pid > 0) pids.push_back(pid);
             break;
+        }
         case Parser::CommandType::PIPELINE:
-            result = executePipeline(*static_cast<Parser::Pipeline*>(redirection.command.get()));
+            launchPipeline(static_cast<const Parser::Pipeline&>(node), nullFd, pids, pgid);
             break;
-        case Parser::CommandType::REDIRECTION:
-            result = executeRedirection(*static_cast<Parser::Redirection*>(redirection.command.get()));
-            break;
-        default:
-            std::cerr << RED << "redirection: unknown node" << RESET << std::endl;
-            result = 1;
+        default: {
+            // builtins, redirections etc. run in a forked copy of the shell
+            pid_t pid = process.startFunction([this, &node]() {
+                return executeNode(node);
+            }, 0, nullFd, -1);
+            if (pid > 0) pids.push_back(pid);
             break;
+        }
     }
 
-#ifdef _WIN32
-    _dup2(saved, target);
-    _close(saved);
-#else
-    dup2(saved, target);
-    close(saved);
-#endif
+    if (nullFd != -1) close(nullFd);
 
-    return result;
+    if (pids.empty()) return 1;
+
+    Job& job = getJobTable().add(pgid == 0 ? pids.front() : pgid, pids, describe(node), false);
+    if (getJobTable().isInteractive()) {
+        std::cerr << "[" << job.id << "] " << pids.back() << std::endl;
+    }
+    return 0;
+#endif
 }
 
 } // namespace olsh
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "../../include/executor/job_table.h"
+#include "../../include/utils/event_loop.h"
+
+#ifndef _WIN32
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <unistd.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/wait.h>
+
+namespace olsh {
+
+namespace {
+    struct termios s_shellModes;
+    bool s_haveShellModes = false;
+
+    bool isNumber(const std::string& s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    // digits that don't fit the type are no pid/job anyone has
+    template <typename T>
+    bool parseNumber(const std::string& s, T& out) {
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+        return ec == std::errc() && end == s.data() + s.size();
+    }
+}
+
+JobTable::JobTable() {
+    Utils::getEventLoop().watchSignal(SIGCHLD, [this](const Utils::SignalEvent& event) {
+        // exits come through the pidfds. SIGCHLDs that arrive together merge into one,
+        // so anything but a plain exit means every job has to be looked at
+        bool exitOnly = event.code == CLD_EXITED || event.code == CLD_KILLED || event.code == CLD_DUMPED;
+        checkStops(!exitOnly);
+    });
+
+    // only take over the terminal when we're the foreground process group of one
+    interactive = isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+    if (interactive) {
+        // the shell has to survive handing the terminal back and forth and ctrl+z at the prompt
+        signal(SIGTTOU, SIG_IGN);
+        signal(SIGTTIN, SIG_IGN);
+        signal(SIGTSTP, SIG_IGN);
+    }
+}
+
+Job& JobTable::add(pid_t pgid, const std::vector<pid_t>& pids, const std::string& command, bool foreground) {
+    // nobody asked for these, don't let them pile up in non-interactive shells
+    size_t done = std::count_if(jobs.begin(), jobs.end(), [](const auto& item) {
+        return item.second.state == Job::State::DONE;
+    });
+    for (auto it = jobs.begin(); done >= MAX_DONE_JOBS && it != jobs.end();) {
+        if (it->second.state == Job::State::DONE) {
+            std::erase(recent, it->first);
+            it = jobs.erase(it);
+            --done;
+        } else {
+            ++it;
+        }
+    }
+
+    int id = jobs.empty() ? 1 : jobs.rbegin()->first + 1;
+
+    Job job;
+    job.id = id;
+    job.pgid = pgid;
+    job.pids = pids;
+    job.statuses.assign(pids.size(), -1);
+    job.command = command;
+    job.foreground = foreground;
+    job.usages.resize(pids.size());
+    job.started = std::chrono::steady_clock::now();
+
+    recent.push_back(id);
+    Job& added = jobs.emplace(id, std::move(job)).first->second;
+
+    Utils::EventLoop& loop = Utils::getEventLoop();
+    for (size_t i = 0; i < pids.size(); ++i) {
+        added.watches.push_back(loop.watchChild(pids[i], [this, id, i] { collect(id, i); }));
+    }
+    return added;
+}
+
+void JobTable::remove(int id) {
+    auto it = jobs.find(id);
+    if (it == jobs.end()) return;
+
+    for (int watch : it->second.watches) {
+        if (watch != -1) Utils::getEventLoop().remove(watch);
+    }
+    jobs.erase(it);
+    std::erase(recent, id);
+}
+
+Job* JobTable::find(int id) {
+    auto it = jobs.find(id);
+    if (it == jobs.end() || it->second.foreground) return nullptr;
+    return &it->second;
+}
+
+Job* JobTable::current() {
+    for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+        if (Job* job = find(*it)) return job;
+    }
+    return nullptr;
+}
+
+Job* JobTable::resolve(const std::string& spec, std::string& error) {
+    error.clear();
+
+    if (spec.empty() || spec[0] != '%') {
+        if (!isNumber(spec)) {
+            error = "not a pid or valid job spec";
+            return nullptr;
+        }
+        pid_t pid = 0;
+        if (!parseNumber(spec, pid)) {
+            error = "no such job";
+            return nullptr;
+        }
+        for (Job* job : list()) {
+            if (std::find(job->pids.begin(), job->pids.end(), pid) != job->pids.end()) return job;
+        }
+        error = "no such job";
+        return nullptr;
+    }
+
+    std::string rest = spec.substr(1);
+    if (rest.empty() || rest == "%" || rest == "+") {
+        if (Job* job = current()) return job;
+        error = "no current job";
+        return nullptr;
+    }
+    if (rest == "-") {
+        bool skipped = false;
+        for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+            Job* job = find(*it);
+            if (!job) continue;
+            if (skipped) return job;
+            skipped = true;
+        }
+        error = "no previous job";
+        return nullptr;
+    }
+    if (isNumber(rest)) {
+        int id = 0;
+        if (parseNumber(rest, id)) {
+            if (Job* job = find(id)) return job;
+        }
+        error = "no such job";
+        return nullptr;
+    }
+
+    // %name - the job whose command starts with name
+    Job* match = nullptr;
+    for (Job* job : list()) {
+        if (job->command.compare(0, rest.size(), rest) != 0) continue;
+        if (match) {
+            error = "ambiguous job spec";
+            return nullptr;
+        }
+        match = job;
+    }
+    if (!match) error = "no such job";
+    return match;
+}
+
+std::vector<Job*> JobTable::list() {
+    std::vector<Job*> result;
+    for (auto& [id, job] : jobs) {
+        if (!job.foreground) result.push_back(&job);
+    }
+    return result;
+}
+
+void JobTable::reap() {
+    Utils::getEventLoop().poll();
+}
+
+int JobTable::wait(Job& job) {
+    // the callbacks update the job, this only keeps the loop going until it changes
+    Utils::getEventLoop().runUntil([&job] { return job.state != Job::State::RUNNING; });
+    return job.status;
+}
+
+void JobTable::reportDone(std::ostream& out) {
+    if (!interactive) return;
+
+    for (Job* job : list()) {
+        if (job->state != Job::State::DONE) continue;
+        print(*job, out);
+        remove(job->id);
+    }
+}
+
+void JobTable::giveTerminal(pid_t pgid) {
+    if (!interactive) return;
+    s_haveShellModes = tcgetattr(STDIN_FILENO, &s_shellModes) == 0;
+    tcsetpgrp(STDIN_FILENO, pgid);
+}
+
+void JobTable::reclaimTerminal() {
+    if (!interactive) return;
+    tcsetpgrp(STDIN_FILENO, getpgrp());
+    // the job may have left the terminal in raw mode or whatever
+    if (s_haveShellModes) tcsetattr(STDIN_FILENO, TCSADRAIN, &s_shellModes);
+}
+
+void JobTable::print(const Job& job, std::ostream& out, bool withPgid) const {
+    char mark = ' ';
+    int seen = 0;
+    for (auto it = recent.rbegin(); it != recent.rend() && seen < 2; ++it) {
+        auto found = jobs.find(*it);
+        if (found == jobs.end() || found->second.foreground) continue;
+        if (*it == job.id) mark = seen == 0 ? '+' : '-';
+        ++seen;
+    }
+
+    std::string state;
+    switch (job.state) {
+        case Job::State::RUNNING:
+            state = "Running";
+            break;
+        case Job::State::STOPPED:
+            state = "Stopped";
+            break;
+        case Job::State::DONE: {
+            int raw = job.statuses.empty() ? 0 : job.statuses.back();
+            if (WIFSIGNALED(raw)) {
+                state = strsignal(WTERMSIG(raw));
+            } else if (job.status != 0) {
+                state = "Exit " + std::to_string(job.status);
+            } else {
+                state = "Done";
+            }
+            break;
+        }
+    }
+
+    out << "[" << job.id << "]" << mark << " ";
+    if (withPgid) out << job.pgid << " ";
+    out << " " << std::left << std::setw(24) << state << std::right << job.command;
+    if (job.state == Job::State::RUNNING) out << " &";
+    out << std::endl;
+}
+
+void JobTable::resetAfterFork() {
+    // the loop was reset already, so there are no watches left to remove
+    jobs.clear();
+    recent.clear();
+    interactive = false;
+}
+
+int JobTable::decodeStatus(int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+}
+
+void JobTable::collect(int id, size_t index) {
+    auto it = jobs.find(id);
+    if (it == jobs.end()) return;
+
+    Job& job = it->second;
+    job.watches[index] = -1; // child watches only fire once
+
+    int status = 0;
+    struct rusage usage{};
+    pid_t w;
+    do {
+        // wait4 hands back what the child used for free, no need for /usr/bin/time
+        w = wait4(job.pids[index], &status, WNOHANG, &usage);
+    } while (w == -1 && errno == EINTR);
+
+    if (w == 0) {
+        // not actually gone yet, keep watching
+        job.watches[index] = Utils::getEventLoop().watchChild(job.pids[index], [this, id, index] {
+            collect(id, index);
+        });
+        return;
+    }
+    if (w == -1) {
+        status = 1 << 8; // reaped elsewhere, reported as exit code 1
+    } else {
+        std::chrono::duration<double> real = std::chrono::steady_clock::now() - job.started;
+        job.usages[index] = ResourceUsage::fromRusage(usage, real.count());
+    }
+    job.usages[index].command = job.pids.size() == 1 ? job.command : std::string();
+    record(job, index, status);
+}
+
+void JobTable::checkStops(bool all) {
+    for (auto& [id, job] : jobs) {
+        if (job.state == Job::State::DONE || (!all && !job.foreground)) continue;
+
+        for (size_t i = 0; i < job.pids.size(); ++i) {
+            if (job.statuses[i] != -1) continue;
+
+            // only stops and continues, exits are left for collect()
+            siginfo_t info{};
+            if (waitid(P_PID, static_cast<id_t>(job.pids[i]), &info, WSTOPPED | WCONTINUED | WNOHANG) != 0 ||
+                info.si_pid != job.pids[i]) {
+                continue;
+            }
+
+            if (info.si_code == CLD_CONTINUED) {
+                job.state = Job::State::RUNNING;
+                continue;
+            }
+
+            int sig = info.si_status;
+            if (job.foreground && interactive && (sig == SIGTTIN || sig == SIGTTOU)) {
+                // it touched the terminal before giveTerminal() ran, it owns it now
+                kill(-job.pgid, SIGCONT);
+                continue;
+            }
+            // ctrl+z stops the whole group, every stage's notification gets consumed here
+            job.state = Job::State::STOPPED;
+            job.status = 128 + sig;
+            touch(job.id);
+        }
+    }
+}
+
+void JobTable::record(Job& job, size_t index, int status) {
+    job.statuses[index] = status;
+    bool finished = std::none_of(job.statuses.begin(), job.statuses.end(), [](int s) { return s == -1; });
+    if (finished) {
+        job.state = Job::State::DONE;
+        job.status = decodeStatus(job.statuses.back());
+    }
+}
+
+void JobTable::touch(int id) {
+    std::erase(recent, id);
+    recent.push_back(id);
+}
+
+JobTable& getJobTable() {
+    static JobTable instance;
+    return instance;
+}
+
+} // namespace olsh
+
+#endif
@@ -1,4 +1,8 @@
 #include "../../include/executor/process.h"
+#include "../../include/executor/command_cache.h"
+#include "../../include/executor/resource_usage.h"
+#include "../../include/utils/fd_stream.h"
+#include "../../include/utils/event_loop.h"
 #include <utils/colors.h>
 #include <iostream>
 #include <vector>
@@ -7,11 +11,17 @@
 
 #ifdef _WIN32
 #include <processthreadsapi.h>
+#include <io.h>
 #else
 #include <unistd.h>
+#include <spawn.h>
+#include <fcntl.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <errno.h>
+#include <cstdlib>
+
+extern char** environ;
 #endif
 
 namespace olsh {
@@ -26,10 +36,33 @@ pid_t  Process::s_childPid = -1;
 pid_t  Process::s_childPgid = -1;
 #endif
 
-int Process::execute(const std::string& command, const std::vector<std::string>& args) {
+int Process::execute(const std::string& command, const std::vector<std::string>& args,
+                     const RedirectPlan& plan) {
     std::string cmdLine = buildCommandLine(command, args);
 
 #ifdef _WIN32
+    // the child inherits the console std handles, so on windows the plan is applied
+    // to the shell's own fds around CreateProcess and undone right after
+    std::vector<std::pair<int, int>> savedFds; // fd, copy of the original
+    auto restoreFds = [&savedFds]() {
+        for (auto it = savedFds.rbegin(); it != savedFds.rend(); ++it) {
+            _dup2(it->second, it->first);
+            _close(it->second);
+        }
+        savedFds.clear();
+    };
+    for (const auto& action : plan) {
+        int source = action.type == FdAction::Type::DUP ? _dup(action.sourceFd) : action.openTarget();
+        if (source == -1) {
+            std::cerr << RED << "redirection: failed to open file: " << action.path << RESET << std::endl;
+            restoreFds();
+            return 1;
+        }
+        savedFds.emplace_back(action.fd, _dup(action.fd));
+        _dup2(source, action.fd);
+        _close(source);
+    }
+
     STARTUPINFOA si{}; si.cb = sizeof(si);
     PROCESS_INFORMATION pi{};
 
@@ -50,9 +83,11 @@ int Process::execute(const std::string& command, const std::vector<std::string>&
             /*lpCurrentDirectory*/ nullptr,
             &si,
             &pi)) {
+        restoreFds();
         std::cerr << RED << "Error: failed to start process: " << command << RESET << std::endl;
         return 1;
     }
+    restoreFds();
 
     s_running.store(true, std::memory_order_release);
     s_processHandle = pi.hProcess;
@@ -86,52 +121,275 @@ int Process::execute(const std::string& command, const std::vector<std::string>&
     s_running.store(false, std::memory_order_release);
     return exitCode;
 #else
+    pid_t pid = start(command, args, 0, -1, -1, plan);
+    if (pid < 0) {
+        return 127;
+    }
+
+    return waitAll({pid}, pid, cmdLine);
+#endif
+}
+
+#ifndef _WIN32
+void Process::setupChild(pid_t pgid, int inFd, int outFd) {
+    setpgid(0, pgid);
+    // the shell ignores/handles these for job control, the child gets them back
+    for (int sig : {SIGINT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD}) {
+        signal(sig, SIG_DFL);
+    }
+    // the shell blocks the signals its event loop reads through signalfd
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, nullptr);
+
+    if (inFd != -1 && inFd != STDIN_FILENO) {
+        dup2(inFd, STDIN_FILENO);
+        close(inFd);
+    }
+    if (outFd != -1 && outFd != STDOUT_FILENO) {
+        dup2(outFd, STDOUT_FILENO);
+        close(outFd);
+    }
+}
+
+bool Process::applyPlan(const RedirectPlan& plan) {
+    for (const auto& action : plan) {
+        if (action.type == FdAction::Type::DUP) {
+            if (dup2(action.sourceFd, action.fd) == -1) {
+                std::cerr << RED << "redirection: bad file descriptor: " << action.sourceFd << RESET << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        int fd = action.openTarget();
+        if (fd == -1) {
+            std::cerr << RED << "redirection: failed to open file: " << action.path << RESET << std::endl;
+            return false;
+        }
+        if (fd != action.fd) {
+            dup2(fd, action.fd);
+            close(fd);
+        }
+    }
+    return true;
+}
+
+bool Process::useFork() {
+    // OLSH_LAUNCH=fork forces the old fork + exec path (mostly for benchmarking)
+    static const bool forced = [] {
+        const char* mode = std::getenv("OLSH_LAUNCH");
+        return mode && std::strcmp(mode, "fork") == 0;
+    }();
+    return forced;
+}
+
+pid_t Process::start(const std::string& command, const std::vector<std::string>& args,
+                     pid_t pgid, int inFd, int outFd, const RedirectPlan& plan) {
+    // resolve through the cache so a known command doesn't walk PATH on every launch
+    // and a missing one is reported without starting anything
+    CommandCache& cache = getCommandCache();
+    std::string path = cache.lookup(command);
+    if (path.empty()) {
+        std::cerr << RED << "Error: command not found: " << command << RESET << std::endl;
+        return -1;
+    }
+
     std::vector<char*> argv;
     argv.reserve(args.size() + 2);
     argv.push_back(const_cast<char*>(command.c_str()));
     for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
     argv.push_back(nullptr);
 
+    if (!useFork()) {
+        pid_t pid = spawnChild(path, argv, pgid, inFd, outFd, plan);
+        if (pid == -2 && path != command) {
+            // the cached binary went away (hash -p target or a file removed without
+            // touching the dir), look it up again once
+            cache.forget(command);
+            path = cache.lookup(command);
+            pid = path.empty() ? -2 : spawnChild(path, argv, pgid, inFd, outFd, plan);
+        }
+        if (pid == -2) {
+            std::cerr << RED << "Error: command not found: " << command << RESET << std::endl;
+            return -1;
+        }
+        return pid;
+    }
+
     pid_t pid = fork();
     if (pid < 0) {
         std::cerr << RED << "Error: fork failed for " << command << RESET << std::endl;
-        return 1;
+        return -1;
     }
     if (pid == 0) {
-        // Child: create new process group and exec
-        setpgid(0, 0);
-        execvp(command.c_str(), argv.data());
-        // If exec returns, it's an error
+        setupChild(pgid, inFd, outFd);
+        if (!applyPlan(plan)) _exit(1);
+        execvp(path.c_str(), argv.data()); // still falls back to sh for scripts without a #!
         std::perror("execvp");
         _exit(127);
     }
 
-    s_childPid = pid;
-    s_childPgid = pid; // as set by setpgid in child
-    s_running.store(true, std::memory_order_release);
+    // set it from the parent too so the group exists before the next stage joins it
+    setpgid(pid, pgid == 0 ? pid : pgid);
+    return pid;
+}
 
-    int status = 0;
-    for (;;) {
-        pid_t w = waitpid(pid, &status, 0);
-        if (w == -1) {
-            if (errno == EINTR) continue; // interrupted by signal, retry
-            std::perror("waitpid");
-            status = 1;
-            break;
-        } else {
-            break;
+pid_t Process::spawnChild(const std::string& path, std::vector<char*>& argv,
+                          pid_t pgid, int inFd, int outFd, const RedirectPlan& plan) {
+    // posix_spawn doesn't copy the shell's page tables (vfork/CLONE_VM under the hood),
+    // so the launch cost stays flat no matter how big the shell gets.
+    // the process group and stdio setup that setupChild() does become spawn attributes/file actions
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (inFd != -1 && inFd != STDIN_FILENO) {
+        posix_spawn_file_actions_adddup2(&actions, inFd, STDIN_FILENO);
+    }
+    if (outFd != -1 && outFd != STDOUT_FILENO) {
+        posix_spawn_file_actions_adddup2(&actions, outFd, STDOUT_FILENO);
+    }
+    if (inFd > STDERR_FILENO) posix_spawn_file_actions_addclose(&actions, inFd);
+    if (outFd > STDERR_FILENO && outFd != inFd) posix_spawn_file_actions_addclose(&actions, outFd);
+
+    for (const auto& action : plan) {
+        switch (action.type) {
+            case FdAction::Type::READ:
+                posix_spawn_file_actions_addopen(&actions, action.fd, action.path.c_str(), O_RDONLY, 0);
+                break;
+            case FdAction::Type::WRITE:
+                posix_spawn_file_actions_addopen(&actions, action.fd, action.path.c_str(),
+                                                 O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                break;
+            case FdAction::Type::APPEND:
+                posix_spawn_file_actions_addopen(&actions, action.fd, action.path.c_str(),
+                                                 O_WRONLY | O_CREAT | O_APPEND, 0644);
+                break;
+            case FdAction::Type::DUP:
+                posix_spawn_file_actions_adddup2(&actions, action.sourceFd, action.fd);
+                break;
         }
     }
 
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(&attr, pgid);
+
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    for (int sig : {SIGINT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD}) {
+        sigaddset(&defaults, sig);
+    }
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    pid_t pid = -1;
+    int rc = posix_spawn(&pid, path.c_str(), &actions, &attr, argv.data(), environ);
+    if (rc == ENOEXEC) {
+        // an executable script without a #!, sh runs it like execvp would
+        std::vector<char*> shArgv{const_cast<char*>("/bin/sh"), const_cast<char*>(path.c_str())};
+        shArgv.insert(shArgv.end(), argv.begin() + 1, argv.end());
+        rc = posix_spawn(&pid, "/bin/sh", &actions, &attr, shArgv.data(), environ);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (rc != 0) {
+        // the spawn fails as a whole, find out if it was one of the redirections
+        for (const auto& action : plan) {
+            if (action.type == FdAction::Type::DUP) continue;
+            int fd = action.openTarget();
+            if (fd == -1) {
+                std::cerr << RED << "redirection: failed to open file: " << action.path << RESET << std::endl;
+                return -1;
+            }
+            close(fd);
+        }
+        if (rc == ENOENT) return -2; // start() decides whether the cache was stale
+        std::cerr << RED << "Error: failed to start process: " << argv[0]
+                  << " (" << std::strerror(rc) << ")" << RESET << std::endl;
+        return -1;
+    }
+    return pid;
+}
+
+pid_t Process::startFunction(const std::function<int()>& fn, pid_t pgid,
+                             int inFd, int outFd, int closeFd) {
+    // anything still buffered would be written twice (once by each process)
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << RED << "Error: fork failed" << RESET << std::endl;
+        return -1;
+    }
+    if (pid == 0) {
+        if (closeFd != -1) close(closeFd);
+        // the shell's loop and jobs belong to the parent
+        Utils::getEventLoop().resetAfterFork();
+        getJobTable().resetAfterFork();
+        setupChild(pgid, inFd, outFd);
+
+        // the inherited std::cin may hold read-ahead from the terminal, so read the fd directly
+        Utils::FdStreamBuf inBuf(STDIN_FILENO);
+        std::cin.rdbuf(&inBuf);
+        std::cin.clear();
+
+        int rc = 1;
+        try {
+            rc = fn();
+        } catch (const std::exception& e) {
+            std::cerr << RED << "Error: " << e.what() << RESET << std::endl;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(rc & 0xff);
+    }
+
+    setpgid(pid, pgid == 0 ? pid : pgid);
+    return pid;
+}
+
+int Process::waitAll(const std::vector<pid_t>& pids, pid_t pgid, const std::string& command) {
+    if (pids.empty()) return 1;
+
+    Job& job = getJobTable().add(pgid, pids, command, true);
+    return waitForeground(job);
+}
+
+int Process::waitForeground(Job& job) {
+    JobTable& jobs = getJobTable();
+
+    s_childPid = job.pids.back();
+    s_childPgid = job.pgid;
+    s_running.store(true, std::memory_order_release);
+    job.foreground = true;
+
+    jobs.giveTerminal(job.pgid);
+    int result = jobs.wait(job);
+    jobs.reclaimTerminal();
+
     s_running.store(false, std::memory_order_release);
     s_childPid = -1;
     s_childPgid = -1;
 
-    if (WIFEXITED(status)) return WEXITSTATUS(status);
-    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
-    return 1;
-#endif
+    if (job.state == Job::State::STOPPED) {
+        // ctrl+z, it lives on as a background job until fg/bg/kill
+        job.foreground = false;
+        std::cerr << std::endl;
+        jobs.print(job, std::cerr);
+    } else {
+        setLastUsage(job.usages);
+        jobs.remove(job.id);
+    }
+    return result;
 }
+#endif
 
 bool Process::interruptActive() {
     if (!s_running.load(std::memory_order_acquire)) return false;
@@ -0,0 +1,40 @@
+#include "../../include/executor/redirect.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace olsh {
+
+int FdAction::openTarget() const {
+#ifdef _WIN32
+    switch (type) {
+        case Type::READ:
+            return _open(path.c_str(), _O_RDONLY);
+        case Type::WRITE:
+            return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE);
+        case Type::APPEND:
+            return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND, _S_IREAD | _S_IWRITE);
+        default:
+            return -1;
+    }
+#else
+    switch (type) {
+        case Type::READ:
+            return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        case Type::WRITE:
+            return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        case Type::APPEND:
+            return open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        default:
+            return -1;
+    }
+#endif
+}
+
+} // namespace olsh
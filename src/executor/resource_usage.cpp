@@ -0,0 +1,101 @@
+#include "../../include/executor/resource_usage.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace olsh {
+
+namespace {
+    std::vector<ResourceUsage> s_lastUsage;
+    unsigned long s_generation = 0;
+
+#ifndef _WIN32
+    double seconds(const timeval& tv) {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    }
+#endif
+}
+
+#ifndef _WIN32
+ResourceUsage ResourceUsage::fromRusage(const struct rusage& usage, double real) {
+    ResourceUsage result;
+    result.real = real;
+    result.user = seconds(usage.ru_utime);
+    result.sys = seconds(usage.ru_stime);
+#ifdef __APPLE__
+    result.maxRss = usage.ru_maxrss / 1024; // bytes there, kB everywhere else
+#else
+    result.maxRss = usage.ru_maxrss;
+#endif
+    result.voluntarySwitches = usage.ru_nvcsw;
+    result.involuntarySwitches = usage.ru_nivcsw;
+    result.minorFaults = usage.ru_minflt;
+    result.majorFaults = usage.ru_majflt;
+    return result;
+}
+
+ResourceUsage ResourceUsage::between(const struct rusage& before, const struct rusage& after, double real) {
+    ResourceUsage a = fromRusage(after, real);
+    ResourceUsage b = fromRusage(before, 0);
+    a.user -= b.user;
+    a.sys -= b.sys;
+    a.voluntarySwitches -= b.voluntarySwitches;
+    a.involuntarySwitches -= b.involuntarySwitches;
+    a.minorFaults -= b.minorFaults;
+    a.majorFaults -= b.majorFaults;
+    return a;
+}
+#endif
+
+void ResourceUsage::add(const ResourceUsage& other) {
+    real = std::max(real, other.real);
+    user += other.user;
+    sys += other.sys;
+    maxRss = std::max(maxRss, other.maxRss);
+    voluntarySwitches += other.voluntarySwitches;
+    involuntarySwitches += other.involuntarySwitches;
+    minorFaults += other.minorFaults;
+    majorFaults += other.majorFaults;
+}
+
+std::string ResourceUsage::format() const {
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "real=%.3f user=%.3f sys=%.3f maxrss=%ld nvcsw=%ld nivcsw=%ld minflt=%ld majflt=%ld",
+                  real, user, sys, maxRss, voluntarySwitches, involuntarySwitches, minorFaults, majorFaults);
+    return buffer;
+}
+
+ResourceUsage totalUsage(const std::vector<ResourceUsage>& stages) {
+    ResourceUsage total;
+    for (const auto& stage : stages) total.add(stage);
+    return total;
+}
+
+void setLastUsage(std::vector<ResourceUsage> stages) {
+    s_lastUsage = std::move(stages);
+    ++s_generation;
+}
+
+bool appendLastUsage(std::string& out, std::string_view name) {
+    if (s_generation == 0) return false;
+    if (name == "OLSH_LAST_RUSAGE") {
+        out += totalUsage(s_lastUsage).format();
+        return true;
+    }
+    if (name != "OLSH_LAST_RUSAGE_STAGES") return false;
+    for (size_t i = 0; i < s_lastUsage.size(); ++i) {
+        if (i) out += " / ";
+        out += s_lastUsage[i].format();
+    }
+    return true;
+}
+
+const std::vector<ResourceUsage>& getLastUsage() {
+    return s_lastUsage;
+}
+
+unsigned long getLastUsageGeneration() {
+    return s_generation;
+}
+
+} // namespace olsh
@@ -1,5 +1,7 @@
 #include "../include/shell.h"
 #include "../include/utils/script.h"
+#include "../include/utils/profiler.h"
+#include <cstring>
 #include <iostream>
 
 #ifdef _WIN32
@@ -22,12 +24,26 @@ int main(int argc, char** argv) {
 
     // TODO: move the script loading logic into the shell class and maybe make it better
 
+    // olshell --profile[=FILE] script.olsh: where the script spends its time, as a table on
+    // stderr once it's done, or as JSON in FILE
+    int first = 1;
+    if (argc > 1 && std::strncmp(argv[1], "--profile", 9) == 0 && (argv[1][9] == '\0' || argv[1][9] == '=')) {
+        auto& profiler = olsh::Utils::getProfiler();
+        if (argv[1][9] == '=') profiler.setOutput(argv[1] + 10);
+        profiler.start();
+        first = 2;
+    }
+
     // script
-    if (argc > 1) {
+    if (argc > first) {
         std::vector<std::string> args;
-        for (int i = 2; i < argc; ++i) args.emplace_back(argv[i]);
+        for (int i = first + 1; i < argc; ++i) args.emplace_back(argv[i]);
         olsh::Utils::ScriptInterpreter si(&shell);
-        std::string file = argv[1];
+        std::string file = argv[first];
+        // olshell - runs a script coming in on stdin, a line at a time as it arrives
+        if (file == "-") {
+            return si.executeStream(std::cin, "stdin", args);
+        }
         if (si.isScriptFile(file)) {
             int rc = si.executeScript(file, args);
             return rc;
@@ -0,0 +1,79 @@
+#include "../../include/parser/arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace olsh::Parser {
+
+Arena::Arena(Arena&& other) noexcept
+    : blocks(std::exchange(other.blocks, nullptr)), cleanups(std::exchange(other.cleanups, nullptr)) {}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        release();
+        blocks = std::exchange(other.blocks, nullptr);
+        cleanups = std::exchange(other.cleanups, nullptr);
+    }
+    return *this;
+}
+
+Arena::~Arena() {
+    release();
+}
+
+void Arena::release() {
+    // newest first, so nothing is destroyed before something made after it
+    for (Cleanup* cleanup = cleanups; cleanup; cleanup = cleanup->next) {
+        cleanup->destroy(cleanup->object);
+    }
+    cleanups = nullptr;
+
+    while (blocks) {
+        Block* next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    if (blocks) {
+        auto base = reinterpret_cast<uintptr_t>(blocks + 1);
+        uintptr_t start = (base + blocks->used + align - 1) & ~(uintptr_t(align) - 1);
+        if (start + size <= base + blocks->size) {
+            blocks->used = start + size - base;
+            return reinterpret_cast<void*>(start);
+        }
+    }
+
+    // something big (a pasted 1 MB argument list) gets a block of its own behind the current
+    // one, the rest of the current block is still good for the small stuff
+    size_t capacity = std::max(BLOCK_SIZE, size + align);
+    auto* block = static_cast<Block*>(::operator new(sizeof(Block) + capacity));
+    if (blocks && size > BLOCK_SIZE / 4) {
+        *block = {blocks->next, capacity, 0};
+        blocks->next = block;
+    } else {
+        *block = {blocks, capacity, 0};
+        blocks = block;
+    }
+
+    auto base = reinterpret_cast<uintptr_t>(block + 1);
+    uintptr_t start = (base + align - 1) & ~(uintptr_t(align) - 1);
+    block->used = start + size - base;
+    return reinterpret_cast<void*>(start);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    char* data = static_cast<char*>(allocate(text.size() + 1, 1));
+    if (!text.empty()) std::memcpy(data, text.data(), text.size());
+    data[text.size()] = '\0';
+    return {data, text.size()};
+}
+
+size_t Arena::bytesUsed() const {
+    size_t used = 0;
+    for (Block* block = blocks; block; block = block->next) used += block->used;
+    return used;
+}
+
+} // namespace olsh::Parser
@@ -3,32 +3,19 @@
 
 namespace olsh::Parser {
 
-Command::Command(const std::string& cmdName, const std::vector<std::string>& arguments, bool skipBuiltin)
-    : name(cmdName), args(arguments), skipBuiltinLookup(skipBuiltin) {}
-
-CommandType Command::getType() const {
-    // builtin (skip if ^ is used)
-    if (!skipBuiltinLookup && getBuiltinRegistry().isBuiltin(name)) {
-        return CommandType::BUILTIN;
+namespace {
+    CommandType resolve(std::string_view name, bool skipBuiltin) {
+        // builtin (skip if ^ is used)
+        if (!skipBuiltin && getBuiltinRegistry().isBuiltin(std::string(name))) {
+            return CommandType::BUILTIN;
+        }
+
+        // external
+        return CommandType::EXTERNAL;
     }
-
-    // external
-    return CommandType::EXTERNAL;
 }
 
-Pipeline::Pipeline(std::vector<std::unique_ptr<Command>> cmds)
-    : commands(std::move(cmds)) {}
-
-CommandType Pipeline::getType() const {
-    return CommandType::PIPELINE;
-}
-
-Redirection::Redirection(std::unique_ptr<ASTNode> cmd, const std::string& file,
-                        bool isAppend, bool isInput)
-    : command(std::move(cmd)), filename(file), append(isAppend), input(isInput) {}
-
-CommandType Redirection::getType() const {
-    return CommandType::REDIRECTION;
-}
+Command::Command(std::string_view cmdName, std::span<const std::string_view> arguments, bool skipBuiltin)
+    : ASTNode(resolve(cmdName, skipBuiltin)), name(cmdName), args(arguments), skipBuiltinLookup(skipBuiltin) {}
 
-} // namespace olsh::Parser
\ No newline at end of file
+} // namespace olsh::Parser
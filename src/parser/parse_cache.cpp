@@ -0,0 +1,51 @@
+#include "../../include/parser/parse_cache.h"
+
+namespace olsh {
+
+std::shared_ptr<const Parser::Tree> ParseCache::find(std::string_view text) {
+    auto it = index.find(text);
+    if (it == index.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->tree;
+}
+
+std::shared_ptr<const Parser::Tree> ParseCache::insert(const std::string& text, Parser::Tree tree) {
+    auto shared = std::make_shared<const Parser::Tree>(std::move(tree));
+    if (text.size() > MAX_TEXT) return shared;
+
+    auto it = index.find(text);
+    if (it != index.end()) {
+        it->second->tree = shared;
+        entries.splice(entries.begin(), entries, it->second);
+        return shared;
+    }
+
+    if (entries.size() >= CAPACITY) {
+        index.erase(entries.back().text);
+        entries.pop_back();
+    }
+    entries.push_front({text, shared});
+    index.emplace(entries.front().text, entries.begin());
+    return shared;
+}
+
+void ParseCache::clear() {
+    index.clear();
+    entries.clear();
+}
+
+ParseCache::Stats ParseCache::getStats() const {
+    return {hits, misses, entries.size(), CAPACITY};
+}
+
+ParseCache& getParseCache() {
+    static ParseCache instance;
+    return instance;
+}
+
+} // namespace olsh
@@ -27,108 +27,177 @@ bool CommandParser::match(Parser::TokenType type) {
     return false;
 }
 
-std::unique_ptr<Parser::Command> CommandParser::parseCommand() {
+void CommandParser::syntaxError(const Parser::Token& token) {
+    std::string_view near = token.type == Parser::TokenType::END_OF_INPUT ? "newline" : token.value;
+    std::cerr << RED << "syntax error near unexpected token `" << near << "'\n" << RESET;
+    failed = true;
+}
+
+Parser::Command* CommandParser::parseCommand() {
     bool skipBuiltin = match(Parser::TokenType::CARET);
 
-    if (peek().type != Parser::TokenType::WORD) {
+    words.clear();
+    RedirectPlan redirects;
+
+    // words and redirections can be mixed freely (echo > file hi)
+    for (;;) {
+        if (peek().type == Parser::TokenType::WORD) {
+            words.push_back(arena->copy(peek().value));
+            advance();
+        } else if (!parseRedirect(redirects)) {
+            break;
+        }
+    }
+
+    if (words.empty()) {
         return nullptr;
     }
 
-    std::string name = peek().value;
-    advance();
+    std::span<const std::string_view> args = arena->copy(std::span<const std::string_view>(words).subspan(1));
+    auto* cmd = arena->make<Parser::Command>(words.front(), args, skipBuiltin);
+    cmd->redirects = std::move(redirects);
+    return cmd;
+}
 
-    std::vector<std::string> args;
-    while (peek().type == Parser::TokenType::WORD) {
-        args.push_back(peek().value);
+bool CommandParser::parseRedirect(RedirectPlan& plan) {
+    int fd = -1;
+    if (peek().type == Parser::TokenType::IO_NUMBER) {
+        fd = std::stoi(std::string(peek().value));
         advance();
     }
 
-    return std::make_unique<Parser::Command>(name, args, skipBuiltin);
-}
-
-std::unique_ptr<Parser::Pipeline> CommandParser::parsePipeline() {
-    std::vector<std::unique_ptr<Parser::Command>> commands;
+    Parser::TokenType op = peek().type;
+    if (op != Parser::TokenType::REDIRECT_OUT &&
+        op != Parser::TokenType::REDIRECT_APPEND &&
+        op != Parser::TokenType::REDIRECT_IN &&
+        op != Parser::TokenType::REDIRECT_DUP &&
+        op != Parser::TokenType::REDIRECT_ALL &&
+        op != Parser::TokenType::REDIRECT_ALL_APPEND) {
+        return false;
+    }
+    advance();
 
-    auto cmd = parseCommand();
-    if (!cmd) return nullptr;
+    if (peek().type != Parser::TokenType::WORD) {
+        std::cerr << RED << "Expected filename after redirection\n" << RESET;
+        return false;
+    }
 
-    commands.push_back(std::move(cmd));
+    std::string target(peek().value);
+    advance();
 
-    while (match(Parser::TokenType::PIPE)) {
-        cmd = parseCommand();
-        if (cmd) {
-            commands.push_back(std::move(cmd));
-        }
+    switch (op) {
+        case Parser::TokenType::REDIRECT_IN:
+            plan.emplace_back(fd == -1 ? 0 : fd, FdAction::Type::READ, target);
+            break;
+        case Parser::TokenType::REDIRECT_OUT:
+            plan.emplace_back(fd == -1 ? 1 : fd, FdAction::Type::WRITE, target);
+            break;
+        case Parser::TokenType::REDIRECT_APPEND:
+            plan.emplace_back(fd == -1 ? 1 : fd, FdAction::Type::APPEND, target);
+            break;
+        case Parser::TokenType::REDIRECT_DUP:
+            if (!target.empty() && target.find_first_not_of("0123456789") == std::string::npos) {
+                plan.emplace_back(fd == -1 ? 1 : fd, std::stoi(target));
+                break;
+            }
+            // >& file is the same as &> file
+            [[fallthrough]];
+        case Parser::TokenType::REDIRECT_ALL:
+            plan.emplace_back(1, FdAction::Type::WRITE, target);
+            plan.emplace_back(2, 1);
+            break;
+        case Parser::TokenType::REDIRECT_ALL_APPEND:
+            plan.emplace_back(1, FdAction::Type::APPEND, target);
+            plan.emplace_back(2, 1);
+            break;
+        default:
+            break;
     }
+    return true;
+}
 
-    while (match(Parser::TokenType::SEMICOLON)) {
-        cmd = parseCommand();
-        if (cmd) {
-            commands.push_back(std::move(cmd));
-        }
+Parser::ASTNode* CommandParser::parsePipeline() {
+    auto* cmd = parseCommand();
+    if (!cmd) return nullptr;
+
+    if (peek().type != Parser::TokenType::PIPE) {
+        // plain command, no pipeline node needed
+        return cmd;
     }
 
-    while (match(Parser::TokenType::AMPERSAND)) {
+    stages.clear();
+    stages.push_back(cmd);
+
+    while (match(Parser::TokenType::PIPE)) {
         cmd = parseCommand();
-        if (cmd) {
-            commands.push_back(std::move(cmd));
+        if (!cmd) {
+            // dropping it would run a || b as a | b
+            syntaxError(peek());
+            return nullptr;
         }
+        stages.push_back(cmd);
     }
 
-    if (commands.size() == 1) {
-        // return directly
-        return nullptr;
+    if (stages.size() == 1) {
+        return stages.front();
     }
 
-    return std::make_unique<Parser::Pipeline>(std::move(commands));
+    return arena->make<Parser::Pipeline>(arena->copy(std::span<Parser::Command* const>(stages)));
 }
 
-std::unique_ptr<Parser::ASTNode> CommandParser::parseRedirection(std::unique_ptr<Parser::ASTNode> node) {
-    while (peek().type == Parser::TokenType::REDIRECT_OUT ||
-           peek().type == Parser::TokenType::REDIRECT_APPEND ||
-           peek().type == Parser::TokenType::REDIRECT_IN) {
+Parser::ASTNode* CommandParser::parseList() {
+    items.clear();
+
+    while (peek().type != Parser::TokenType::END_OF_INPUT) {
+        auto* node = parsePipeline();
+        if (failed) return nullptr;
+
+        if (!node) {
+            // a separator with nothing in front of it (&&, & &, ;;) would quietly change when things run
+            if (peek().type == Parser::TokenType::AMPERSAND || peek().type == Parser::TokenType::SEMICOLON) {
+                syntaxError(peek());
+                return nullptr;
+            }
+            // nothing we can parse here
+            if (items.empty()) return nullptr;
+            break;
+        }
 
-        bool append = peek().type == Parser::TokenType::REDIRECT_APPEND;
-        bool input = peek().type == Parser::TokenType::REDIRECT_IN;
-        advance();
+        bool background = match(Parser::TokenType::AMPERSAND);
+        bool separated = background || match(Parser::TokenType::SEMICOLON);
 
-        if (peek().type != Parser::TokenType::WORD) {
-            std::cerr << RED << "Expected filename after redirection\n" << RESET;
-            return node;
+        if (background) {
+            node = arena->make<Parser::Background>(node);
         }
+        items.push_back(node);
 
-        std::string filename = peek().value;
-        advance();
-
-        node = std::make_unique<Parser::Redirection>(std::move(node), filename, append, input);
+        // anything left after a command that isn't a separator gets ignored
+        if (!separated) break;
     }
 
+    if (items.empty()) return nullptr;
+    if (items.size() == 1) return items.front();
 
-    return node;
+    return arena->make<Parser::Sequence>(arena->copy(std::span<Parser::ASTNode* const>(items)));
 }
 
-std::unique_ptr<Parser::ASTNode> CommandParser::parse(const std::string& input) {
-    if (input.empty()) return nullptr;
+Parser::Tree CommandParser::parse(const std::string& input) {
+    if (input.empty()) return {};
 
     Parser::Tokenizer tokenizer(input);
-    tokens = tokenizer.tokenize();
+    tokenizer.tokenize(tokens);
     current = 0;
+    failed = false;
 
-    // try to parse as pipeline
-    size_t saved_pos = current;
-    auto pipeline = parsePipeline();
-    if (pipeline) {
-        return parseRedirection(std::move(pipeline));
-    }
-
-    // no pipeline
-    current = saved_pos;
-    auto command = parseCommand();
-    if (command) {
-        return parseRedirection(std::move(command));
-    }
+    // every node and word of this line goes into one arena, the tree owns it afterwards
+    Parser::Arena nodes;
+    arena = &nodes;
+    Parser::ASTNode* root = parseList();
+    arena = nullptr;
+    tokens.clear(); // they point into input and the tokenizer
 
-    return nullptr;
+    if (!root || failed) return {};
+    return {std::move(nodes), root};
 }
 
 } // namespace olsh
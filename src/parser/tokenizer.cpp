@@ -1,119 +1,125 @@
 #include "../../include/parser/tokenizer.h"
-#include <cctype>
 
 namespace olsh::Parser {
 
-Tokenizer::Tokenizer(const std::string& input)
-    : input(input), position(0), length(input.length()) {}
+Tokenizer::Tokenizer(std::string_view input)
+    : input(input), position(0) {}
 
-char Tokenizer::currentChar() {
-    if (position >= length) return '\0';
-    return input[position];
+std::string_view Tokenizer::readWord() {
+    size_t start = position;
+    while (position < input.size() && !CharClass::is(input[position], CharClass::WORD_END)) {
+        position++;
+    }
+    return input.substr(start, position - start);
 }
 
-char Tokenizer::peek() {
-    if (position + 1 >= length) return '\0';
-    return input[position + 1];
-}
+std::string_view Tokenizer::readQuotedString(char quote) {
+    position++; // skip opening quote
+    size_t start = position;
 
-void Tokenizer::advance() {
-    if (position < length) position++;
-}
-
-void Tokenizer::skipWhitespace() {
-    while (position < length && std::isspace(currentChar())) {
-        advance();
+    // the common case is no escapes at all, then the token is just the inside of the quotes
+    size_t end = start;
+    while (end < input.size() && input[end] != quote) {
+        if (input[end] == '\\' && end + 1 < input.size() && input[end + 1] == quote) break;
+        end++;
     }
-}
-
-std::string Tokenizer::readWord() {
-    std::string word;
-    while (position < length && !std::isspace(currentChar()) &&
-           currentChar() != '|' && currentChar() != '>' &&
-           currentChar() != '<' && currentChar() != ';') {
-        word += currentChar();
-        advance();
+    if (end >= input.size() || input[end] == quote) {
+        position = end < input.size() ? end + 1 : end;
+        return input.substr(start, end - start);
     }
-    return word;
-}
 
-std::string Tokenizer::readQuotedString(char quote) {
-    std::string str;
-    advance(); // skip opening quote
-
-    while (position < length && currentChar() != quote) {
-        if (currentChar() == '\\' && peek() == quote) {
-            advance(); // skip \ .
-            str += currentChar();
-            advance();
-        } else {
-            str += currentChar();
-            advance();
+    // \" inside "..." (or \' inside '...'), the backslashes have to go
+    std::string& str = unescaped.emplace_front(input.substr(start, end - start));
+    position = end;
+    while (position < input.size() && input[position] != quote) {
+        if (input[position] == '\\' && position + 1 < input.size() && input[position + 1] == quote) {
+            position++; // skip \ .
         }
+        str += input[position];
+        position++;
     }
 
-    if (position < length) advance(); // skip closing quote
+    if (position < input.size()) position++; // skip closing quote
     return str;
 }
 
 std::vector<Token> Tokenizer::tokenize() {
     std::vector<Token> tokens;
+    tokenize(tokens);
+    return tokens;
+}
 
-    while (position < length) {
-        skipWhitespace();
+void Tokenizer::tokenize(std::vector<Token>& tokens) {
+    tokens.clear();
+    const size_t length = input.size();
+
+    auto emit = [&](TokenType type, size_t size) {
+        tokens.emplace_back(type, input.substr(position, size));
+        position += size;
+    };
+    auto next = [&]() { return position + 1 < length ? input[position + 1] : '\0'; };
 
+    while (position < length) {
+        while (position < length && CharClass::is(input[position], CharClass::SPACE)) position++;
         if (position >= length) break;
 
-        char ch = currentChar();
-
-        switch (ch) {
-            case '|':
-                tokens.emplace_back(TokenType::PIPE, "|");
-                advance();
-                break;
-            case '>':
-                if (peek() == '>') {
-                    tokens.emplace_back(TokenType::REDIRECT_APPEND, ">>");
-                    advance();
-                    advance();
-                } else {
-                    tokens.emplace_back(TokenType::REDIRECT_OUT, ">");
-                    advance();
-                }
-                break;
-            case '<':
-                tokens.emplace_back(TokenType::REDIRECT_IN, "<");
-                advance();
-                break;
-            case ';':
-                tokens.emplace_back(TokenType::SEMICOLON, ";");
-                advance();
-                break;
-            case '^':
-                tokens.emplace_back(TokenType::CARET, "^");
-                advance();
-                break;
-            case '"':
-            case '\'':
-                tokens.emplace_back(TokenType::WORD, readQuotedString(ch));
-                break;
-            case '&':
-                tokens.emplace_back(TokenType::AMPERSAND, "&");
-                advance();
-                break;
-            default:
-                if (std::isalnum(ch) || ch == '.' || ch == '/' || ch == '\\' ||
-                    ch == '-' || ch == '_' || ch == '~' || ch == '*' || ch == '?') {
-                    tokens.emplace_back(TokenType::WORD, readWord());
-                } else {
-                    advance(); // Skip unknown characters
-                }
-                break;
+        char ch = input[position];
+
+        if (CharClass::is(ch, CharClass::OPERATOR)) {
+            switch (ch) {
+                case '|':
+                    emit(TokenType::PIPE, 1);
+                    break;
+                case '>':
+                    if (next() == '>') {
+                        emit(TokenType::REDIRECT_APPEND, 2);
+                    } else if (next() == '&') {
+                        emit(TokenType::REDIRECT_DUP, 2);
+                    } else {
+                        emit(TokenType::REDIRECT_OUT, 1);
+                    }
+                    break;
+                case '<':
+                    emit(TokenType::REDIRECT_IN, 1);
+                    break;
+                case ';':
+                    emit(TokenType::SEMICOLON, 1);
+                    break;
+                case '^':
+                    emit(TokenType::CARET, 1);
+                    break;
+                case '&':
+                    if (next() == '>') {
+                        bool append = position + 2 < length && input[position + 2] == '>';
+                        emit(append ? TokenType::REDIRECT_ALL_APPEND : TokenType::REDIRECT_ALL, append ? 3 : 2);
+                    } else {
+                        emit(TokenType::AMPERSAND, 1);
+                    }
+                    break;
+            }
+            continue;
+        }
+
+        if (CharClass::is(ch, CharClass::QUOTE)) {
+            tokens.emplace_back(TokenType::WORD, readQuotedString(ch));
+            continue;
         }
+
+        if (CharClass::is(ch, CharClass::DIGIT)) {
+            // digits right before > or < are the fd to redirect (2>, 2>>, 2>&1)
+            size_t end = position;
+            while (end < length && CharClass::is(input[end], CharClass::DIGIT)) end++;
+            if (end - position <= 4 && end < length && (input[end] == '>' || input[end] == '<')) {
+                emit(TokenType::IO_NUMBER, end - position);
+                continue;
+            }
+        }
+
+        // anything else starts a word, bytes we don't know about (utf-8, $, =, ...) included
+        tokens.emplace_back(TokenType::WORD, readWord());
     }
 
-    tokens.emplace_back(TokenType::END_OF_INPUT, "");
-    return tokens;
+    tokens.emplace_back(TokenType::END_OF_INPUT, std::string_view());
 }
 
-} // namespace olsh::Parser
\ No newline at end of file
+} // namespace olsh::Parser
@@ -1,10 +1,16 @@
 #include "../include/shell.h"
 #include "../include/utils/fs.h"
 #include "../include/builtins/config.h"
+#include "../include/builtins/time.h"
+#include "../include/parser/parse_cache.h"
 #include "../include/utils/readline.h"
 #include "../include/executor/process.h"
+#include "../include/executor/job_table.h"
+#include "../include/utils/event_loop.h"
+#include "../include/utils/xtrace.h"
 #include <utils/colors.h>
 #include <iostream>
+#include <algorithm>
 #include <filesystem>
 #include <sstream>
 #include <vector>
@@ -56,7 +62,11 @@ void Shell::setupSignalHandlers() {
 #ifdef _WIN32
     SetConsoleCtrlHandler(signalHandler, TRUE);
 #else
-    signal(SIGINT, signalHandler);
+    // ctrl+c arrives through the event loop, so it's handled between events instead of at any point
+    Utils::getEventLoop().watchSignal(SIGINT, [](const Utils::SignalEvent& event) {
+        signalHandler(event.signal);
+    });
+    getJobTable(); // watches SIGCHLD and takes over the job control signals
 #endif
 }
 
@@ -95,6 +105,7 @@ Shell::Shell() : running(true) {
 
     // set shell instance for config builtin
     Builtins::Config::setShellInstance(this);
+    Builtins::Time::setShellInstance(this);
 
     // set history instance for readline
     readlineSetHistoryInstance(historyManager.get());
@@ -122,6 +133,12 @@ void Shell::run() {
     std::cout << welcomeMessage << "\n";
 
     while (running) {
+#ifndef _WIN32
+        // collect background jobs that finished in the meantime and tell about them
+        getJobTable().reap();
+        getJobTable().reportDone(std::cerr);
+#endif
+
         // check for pending interrupt before showing prompt
         if (s_interrupted.load(std::memory_order_acquire)) {
             s_interrupted.store(false, std::memory_order_release);
@@ -257,20 +274,38 @@ std::string Shell::expandPromptVariables(const std::string& promptTemplate) {
 }
 
 int Shell::processCommand(const std::string& input) {
+    // set -x, for a line that didn't come from a script (those were traced with their source line)
+    Utils::Tracer& tracer = Utils::getTracer();
+    bool tracing = tracer.active() && tracer.claim();
+
     // exit command (quick check before parsing)
     if (input == "exit") {
         exit();
         return 0;
     }
 
-    // check for script execution (extract first word for script check)
-    std::istringstream iss(input);
-    std::string firstWord;
-    if (!(iss >> firstWord)) {
+    // first word without building a stream, this runs for every line of a script
+    size_t start = input.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
         return 0; // empty input
     }
+    size_t end = std::min(input.find_first_of(" \t\r\n", start), input.size());
+    std::string firstWord = input.substr(start, end - start);
 
+    if (tracing) {
+        std::string aliased = aliasManager->expandAlias(firstWord);
+        tracer.command(aliased != firstWord ? aliased + input.substr(end) : input);
+    }
+
+    // time covers the whole line (pipelines too), so it can't wait for the parser to split it
+    if (firstWord == "time") {
+        Builtins::Time time;
+        return time.run(input.substr(end));
+    }
+
+    // check for script execution
     if (scriptInterpreter->isScriptFile(firstWord)) {
+        std::istringstream iss(input.substr(end));
         std::vector<std::string> args;
         std::string arg;
         while (iss >> arg) {
@@ -280,24 +315,26 @@ int Shell::processCommand(const std::string& input) {
     }
 
     // expand aliases
-    std::string expandedInput = input;
     std::string aliasExpansion = aliasManager->expandAlias(firstWord);
-    if (aliasExpansion != firstWord) {
-        std::string rest = input.substr(firstWord.length());
-        expandedInput = aliasExpansion + rest;
-    }
-
-    // let the proper parser handle everything
-    auto command = parser->parse(expandedInput);
+    std::string expandedInput = aliasExpansion != firstWord ? aliasExpansion + input.substr(end) : input;
 
-    // validate command
+    // a line that ran before (a loop body, the same command again) reuses its tree
+    ParseCache& cache = getParseCache();
+    std::shared_ptr<const Parser::Tree> command = cache.find(expandedInput);
     if (!command) {
-        std::cerr << "Failed to parse command: " << expandedInput << std::endl;
-        return -1;
+        // let the proper parser handle everything
+        Parser::Tree parsed = parser->parse(expandedInput);
+
+        // validate command
+        if (!parsed) {
+            std::cerr << "Failed to parse command: " << expandedInput << std::endl;
+            return -1;
+        }
+        command = cache.insert(expandedInput, std::move(parsed));
     }
 
     // execute command
-    return executor->execute(std::move(command));
+    return executor->execute(*command);
 }
 void Shell::exit() {
     std::cout << BLUE << "Goodbye!\n" << RESET;
@@ -0,0 +1,322 @@
+#include "../../include/utils/arithmetic.h"
+#include "../../include/utils/symbols.h"
+#include <cctype>
+#include <climits>
+
+namespace olsh::Utils {
+
+// recursive descent, one function per precedence level, building nodes as it goes
+class ArithCompiler {
+public:
+    ArithCompiler(std::string_view source, ArithExpr& target) : s(source), out(target) {}
+
+    bool compile(std::string& error) {
+        out.nodes.clear();
+        out.root = comma();
+        skip();
+        if (failed.empty() && i < s.size()) fail("unexpected '" + std::string(s.substr(i)) + "'");
+        if (failed.empty() && out.nodes.empty()) fail("empty expression");
+        if (!failed.empty()) {
+            error = failed;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    using Op = ArithExpr::Op;
+    using Node = ArithExpr::Node;
+
+    std::string_view s;
+    ArithExpr& out;
+    size_t i = 0;
+    std::string failed;
+
+    struct Binary {
+        std::string_view token;
+        Op op;
+        int precedence;
+    };
+
+    // longest first so << isn't read as <
+    static constexpr Binary BINARY[] = {
+        {"**", Op::POW, 12},
+        {"<<", Op::SHL, 9}, {">>", Op::SHR, 9},
+        {"<=", Op::LE, 8}, {">=", Op::GE, 8}, {"==", Op::EQ, 7}, {"!=", Op::NE, 7},
+        {"&&", Op::AND, 3}, {"||", Op::OR, 2},
+        {"*", Op::MUL, 11}, {"/", Op::DIV, 11}, {"%", Op::MOD, 11},
+        {"+", Op::ADD, 10}, {"-", Op::SUB, 10},
+        {"<", Op::LT, 8}, {">", Op::GT, 8},
+        {"&", Op::BIT_AND, 6}, {"^", Op::BIT_XOR, 5}, {"|", Op::BIT_OR, 4},
+    };
+
+    static constexpr Binary ASSIGNMENT[] = {
+        {"<<=", Op::SHL, 0}, {">>=", Op::SHR, 0},
+        {"+=", Op::ADD, 0}, {"-=", Op::SUB, 0}, {"*=", Op::MUL, 0}, {"/=", Op::DIV, 0},
+        {"%=", Op::MOD, 0}, {"&=", Op::BIT_AND, 0}, {"^=", Op::BIT_XOR, 0}, {"|=", Op::BIT_OR, 0},
+        {"=", Op::NUMBER, 0},
+    };
+
+    uint32_t fail(std::string message) {
+        if (failed.empty()) failed = std::move(message);
+        return 0;
+    }
+
+    uint32_t node(Node n) {
+        out.nodes.push_back(n);
+        return (uint32_t)out.nodes.size() - 1;
+    }
+
+    void skip() { while (i < s.size() && std::isspace((unsigned char)s[i])) i++; }
+
+    bool at(std::string_view token) {
+        skip();
+        return s.compare(i, token.size(), token) == 0;
+    }
+
+    bool accept(std::string_view token) {
+        if (!at(token)) return false;
+        i += token.size();
+        return true;
+    }
+
+    // an = that isn't the start of ==
+    bool atAssignment(const Binary*& found) {
+        skip();
+        for (const Binary& a : ASSIGNMENT) {
+            if (s.compare(i, a.token.size(), a.token) != 0) continue;
+            if (a.token == "=" && i + 1 < s.size() && s[i+1] == '=') return false;
+            found = &a;
+            return true;
+        }
+        return false;
+    }
+
+    bool assignable(uint32_t n) { return out.nodes[n].op == Op::VARIABLE; }
+
+    uint32_t comma() {
+        uint32_t left = assignment();
+        while (failed.empty() && accept(",")) {
+            uint32_t right = assignment();
+            left = node({Op::COMMA, Op::NUMBER, left, right});
+        }
+        return left;
+    }
+
+    uint32_t assignment() {
+        uint32_t target = ternary();
+        const Binary* a = nullptr;
+        if (!failed.empty() || !atAssignment(a)) return target;
+        if (!assignable(target)) return fail("can't assign to that, only to a variable");
+        i += a->token.size();
+        uint32_t value = assignment();
+        return node({Op::ASSIGN, a->op, target, value});
+    }
+
+    uint32_t ternary() {
+        uint32_t cond = binary(2);
+        if (!failed.empty() || !accept("?")) return cond;
+        uint32_t yes = comma();
+        if (!accept(":")) return fail("expected ':' for the '?'");
+        uint32_t no = assignment();
+        return node({Op::TERNARY, Op::NUMBER, cond, yes, no});
+    }
+
+    const Binary* binaryOperator() {
+        skip();
+        for (const Binary& b : BINARY) {
+            if (s.compare(i, b.token.size(), b.token) != 0) continue;
+            // a += 1 is an assignment and a & b isn't &&, those are handled elsewhere
+            const Binary* a = nullptr;
+            if (atAssignment(a) && a->token.size() > b.token.size()) return nullptr;
+            if ((b.token == "+" || b.token == "-") && i + 1 < s.size() && s[i+1] == b.token[0]) return nullptr;
+            return &b;
+        }
+        return nullptr;
+    }
+
+    uint32_t binary(int minPrecedence) {
+        uint32_t left = unary();
+        while (failed.empty()) {
+            const Binary* b = binaryOperator();
+            if (!b || b->precedence < minPrecedence) break;
+            i += b->token.size();
+            // ** is the only right associative one
+            uint32_t right = binary(b->op == Op::POW ? b->precedence : b->precedence + 1);
+            left = node({b->op, Op::NUMBER, left, right});
+        }
+        return left;
+    }
+
+    uint32_t unary() {
+        if (accept("++") || accept("--")) {
+            bool inc = s[i-1] == '+';
+            uint32_t target = unary();
+            if (failed.empty() && !assignable(target)) return fail("++/-- needs a variable");
+            return node({inc ? Op::PRE_INC : Op::PRE_DEC, Op::NUMBER, target});
+        }
+        if (accept("!")) return node({Op::NOT, Op::NUMBER, unary()});
+        if (accept("~")) return node({Op::BIT_NOT, Op::NUMBER, unary()});
+        if (accept("-")) return node({Op::NEGATE, Op::NUMBER, unary()});
+        if (accept("+")) return unary();
+
+        uint32_t operand = primary();
+        if (failed.empty() && assignable(operand)) {
+            if (accept("++")) return node({Op::POST_INC, Op::NUMBER, operand});
+            if (accept("--")) return node({Op::POST_DEC, Op::NUMBER, operand});
+        }
+        return operand;
+    }
+
+    uint32_t variable(std::string_view name) {
+        Node n{Op::VARIABLE};
+        n.value = getSymbols().intern(name);
+        return node(n);
+    }
+
+    static bool nameChar(char c) { return std::isalnum((unsigned char)c) || c == '_'; }
+
+    uint32_t primary() {
+        skip();
+        if (i >= s.size()) return fail("expected an operand");
+        char c = s[i];
+
+        if (c == '(') {
+            i++;
+            uint32_t inner = comma();
+            if (!accept(")")) return fail("expected ')'");
+            return inner;
+        }
+
+        if (std::isdigit((unsigned char)c)) {
+            // decimal or 0x hex, leading zeros stay decimal
+            int base = 10;
+            if (c == '0' && i + 1 < s.size() && (s[i+1] == 'x' || s[i+1] == 'X')) { base = 16; i += 2; }
+            unsigned long long v = 0;
+            size_t start = i;
+            while (i < s.size() && std::isxdigit((unsigned char)s[i])) {
+                int d = std::isdigit((unsigned char)s[i]) ? s[i] - '0' : (std::tolower((unsigned char)s[i]) - 'a' + 10);
+                if (d >= base) return fail("bad number '" + std::string(s.substr(start)) + "'");
+                v = v * base + d;
+                i++;
+            }
+            if (i == start || (i < s.size() && nameChar(s[i]))) return fail("bad number");
+            Node n{Op::NUMBER};
+            n.value = (long long)v;
+            return node(n);
+        }
+
+        if (std::isalpha((unsigned char)c) || c == '_') {
+            size_t start = i;
+            while (i < s.size() && nameChar(s[i])) i++;
+            return variable(s.substr(start, i - start));
+        }
+
+        if (c == '$') {
+            // $name ${name} $1 $# $? work as well as the bare name
+            i++;
+            if (i < s.size() && (s[i] == '#' || s[i] == '?')) {
+                return node({s[i++] == '#' ? Op::ARG_COUNT : Op::STATUS});
+            }
+            if (i < s.size() && std::isdigit((unsigned char)s[i])) {
+                Node n{Op::POSITIONAL};
+                while (i < s.size() && std::isdigit((unsigned char)s[i])) n.value = n.value * 10 + (s[i++] - '0');
+                return node(n);
+            }
+            bool braced = i < s.size() && s[i] == '{';
+            if (braced) i++;
+            size_t start = i;
+            while (i < s.size() && nameChar(s[i])) i++;
+            if (i == start) return fail("expected a name after '$'");
+            std::string_view name = s.substr(start, i - start);
+            if (braced && !accept("}")) return fail("expected '}'");
+            return variable(name);
+        }
+
+        return fail("unexpected '" + std::string(1, c) + "'");
+    }
+};
+
+bool ArithExpr::compile(std::string_view text, ArithExpr& out, std::string& error) {
+    ArithCompiler compiler(text, out);
+    return compiler.compile(error);
+}
+
+long long ArithExpr::apply(Op op, long long a, long long b) {
+    // + - * wrap around instead of being undefined
+    using U = unsigned long long;
+    switch (op) {
+        case Op::ADD: return (long long)((U)a + (U)b);
+        case Op::SUB: return (long long)((U)a - (U)b);
+        case Op::MUL: return (long long)((U)a * (U)b);
+        // division by zero is 0, as it always was here
+        case Op::DIV: return b == 0 ? 0 : (b == -1 ? (long long)(0 - (U)a) : a / b);
+        case Op::MOD: return b == 0 || b == -1 ? 0 : a % b;
+        case Op::POW: {
+            if (b < 0) return 0;
+            U result = 1, base = (U)a;
+            while (b) { if (b & 1) result *= base; base *= base; b >>= 1; }
+            return (long long)result;
+        }
+        case Op::SHL: return (long long)((U)a << (b & 63));
+        case Op::SHR: return a >> (b & 63);
+        case Op::LT: return a < b;
+        case Op::LE: return a <= b;
+        case Op::GT: return a > b;
+        case Op::GE: return a >= b;
+        case Op::EQ: return a == b;
+        case Op::NE: return a != b;
+        case Op::BIT_AND: return a & b;
+        case Op::BIT_XOR: return a ^ b;
+        case Op::BIT_OR: return a | b;
+        default: return b;
+    }
+}
+
+long long ArithExpr::eval(uint32_t index, Context& context) const {
+    const Node& n = nodes[index];
+    switch (n.op) {
+        case Op::NUMBER: return n.value;
+        case Op::VARIABLE: return context.get((uint32_t)n.value);
+        case Op::POSITIONAL: return context.positional((uint32_t)n.value);
+        case Op::ARG_COUNT: return context.argumentCount();
+        case Op::STATUS: return context.status();
+
+        case Op::NEGATE: return (long long)(0 - (unsigned long long)eval(n.lhs, context));
+        case Op::NOT: return !eval(n.lhs, context);
+        case Op::BIT_NOT: return ~eval(n.lhs, context);
+        case Op::PRE_INC:
+        case Op::PRE_DEC:
+        case Op::POST_INC:
+        case Op::POST_DEC: {
+            uint32_t symbol = (uint32_t)nodes[n.lhs].value;
+            long long old = context.get(symbol);
+            long long now = apply(n.op == Op::PRE_INC || n.op == Op::POST_INC ? Op::ADD : Op::SUB, old, 1);
+            context.set(symbol, now);
+            return n.op == Op::PRE_INC || n.op == Op::PRE_DEC ? now : old;
+        }
+
+        case Op::AND: return eval(n.lhs, context) && eval(n.rhs, context);
+        case Op::OR: return eval(n.lhs, context) || eval(n.rhs, context);
+        case Op::TERNARY: return eval(n.lhs, context) ? eval(n.rhs, context) : eval(n.third, context);
+        case Op::COMMA: eval(n.lhs, context); return eval(n.rhs, context);
+        case Op::ASSIGN: {
+            uint32_t symbol = (uint32_t)nodes[n.lhs].value;
+            long long value = eval(n.rhs, context);
+            if (n.combine != Op::NUMBER) value = apply(n.combine, context.get(symbol), value);
+            context.set(symbol, value);
+            return value;
+        }
+
+        default: {
+            long long a = eval(n.lhs, context);
+            return apply(n.op, a, eval(n.rhs, context));
+        }
+    }
+}
+
+long long ArithExpr::evaluate(Context& context) const {
+    return nodes.empty() ? 0 : eval(root, context);
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,49 @@
+#include "../../include/utils/assoc_array.h"
+#include <functional>
+
+namespace olsh::Utils {
+
+size_t AssocArray::probe(std::string_view key, size_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t at = hash & mask;
+    while (slots[at]) {
+        const Entry& entry = items[slots[at] - 1];
+        if (entry.hash == hash && entry.key == key) break;
+        at = (at + 1) & mask;
+    }
+    return at;
+}
+
+const std::string* AssocArray::find(std::string_view key) const {
+    if (slots.empty()) return nullptr;
+    uint32_t slot = slots[probe(key, std::hash<std::string_view>{}(key))];
+    return slot ? &items[slot - 1].value : nullptr;
+}
+
+std::string& AssocArray::operator[](std::string_view key) {
+    if ((items.size() + 1) * 2 > slots.size()) grow();
+    size_t hash = std::hash<std::string_view>{}(key);
+    size_t at = probe(key, hash);
+    if (!slots[at]) {
+        items.push_back({std::string(key), std::string(), hash});
+        slots[at] = (uint32_t)items.size();
+    }
+    return items[slots[at] - 1].value;
+}
+
+void AssocArray::clear() {
+    items.clear();
+    slots.clear();
+}
+
+void AssocArray::grow() {
+    slots.assign(slots.empty() ? 16 : slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        size_t at = items[i].hash & mask;
+        while (slots[at]) at = (at + 1) & mask;
+        slots[at] = i + 1;
+    }
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,374 @@
+#include "../../include/utils/event_loop.h"
+
+#ifndef _WIN32
+
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/syscall.h>
+#else
+#include <poll.h>
+#endif
+
+namespace olsh::Utils {
+
+namespace {
+    constexpr uint64_t SIGNAL_SOURCE = 0; // epoll data of the signalfd, real ids start at 1
+
+#ifndef __linux__
+    int s_selfPipe[2] = {-1, -1};
+
+    void onSignal(int sig) {
+        int savedErrno = errno;
+        char byte = static_cast<char>(sig);
+        [[maybe_unused]] ssize_t n = write(s_selfPipe[1], &byte, 1);
+        errno = savedErrno;
+    }
+
+    void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+#endif
+}
+
+EventLoop::EventLoop() {
+    sigemptyset(&signals);
+#ifdef __linux__
+    backendFd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    if (pipe(s_selfPipe) == 0) {
+        setNonBlocking(s_selfPipe[0]);
+        setNonBlocking(s_selfPipe[1]);
+        signalFd = s_selfPipe[0];
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+    closeAll();
+}
+
+int EventLoop::addSource(Source source) {
+    int id = nextId++;
+#ifdef __linux__
+    if (source.fd != -1) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(id);
+        epoll_ctl(backendFd, EPOLL_CTL_ADD, source.fd, &event);
+    }
+#endif
+    sources.emplace(id, std::move(source));
+    return id;
+}
+
+int EventLoop::watchFd(int fd, Callback onReadable) {
+    Source source;
+    source.kind = Kind::FD;
+    source.fd = fd;
+    source.callback = std::move(onReadable);
+    return addSource(std::move(source));
+}
+
+int EventLoop::watchChild(pid_t pid, Callback onExit) {
+    Source source;
+    source.kind = Kind::CHILD;
+    source.pid = pid;
+    source.callback = std::move(onExit);
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // a pidfd turns readable when that one child exits, no scanning every child on SIGCHLD
+    int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (pidfd != -1) {
+        source.fd = pidfd;
+        source.ownsFd = true;
+    }
+#endif
+    if (source.fd == -1) {
+        // no pidfd (old kernel or not linux), SIGCHLD tells us to look.
+        // it may have exited before SIGCHLD was blocked, so look once right away
+        blockSignal(SIGCHLD);
+        checkChildrenNext = true;
+    }
+    return addSource(std::move(source));
+}
+
+int EventLoop::watchSignal(int sig, SignalCallback onSignal) {
+    blockSignal(sig);
+
+    Source source;
+    source.kind = Kind::SIGNAL;
+    source.signal = sig;
+    source.signalCallback = std::move(onSignal);
+    return addSource(std::move(source));
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds delay, Callback onExpire, bool repeat) {
+    Source source;
+    source.kind = Kind::TIMER;
+    source.callback = std::move(onExpire);
+    source.interval = delay;
+    source.repeat = repeat;
+    source.deadline = std::chrono::steady_clock::now() + delay;
+
+#ifdef __linux__
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd != -1) {
+        itimerspec spec{};
+        // a zero it_value would disarm it
+        auto ns = std::max<long long>(std::chrono::nanoseconds(delay).count(), 1);
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        if (repeat) spec.it_interval = spec.it_value;
+        timerfd_settime(timerFd, 0, &spec, nullptr);
+        source.fd = timerFd;
+        source.ownsFd = true;
+    }
+#endif
+    return addSource(std::move(source));
+}
+
+void EventLoop::remove(int id) {
+    auto it = sources.find(id);
+    if (it == sources.end()) return;
+
+    Source& source = it->second;
+#ifdef __linux__
+    if (source.fd != -1) epoll_ctl(backendFd, EPOLL_CTL_DEL, source.fd, nullptr);
+#endif
+    if (source.ownsFd) close(source.fd);
+    // the signal itself stays blocked, unblocking could deliver a pending one with its default action
+    sources.erase(it);
+}
+
+void EventLoop::blockSignal(int sig) {
+    if (sigismember(&signals, sig)) return;
+    sigaddset(&signals, sig);
+
+#ifdef __linux__
+    sigset_t one;
+    sigemptyset(&one);
+    sigaddset(&one, sig);
+    sigprocmask(SIG_BLOCK, &one, nullptr);
+
+    bool created = signalFd == -1;
+    signalFd = signalfd(signalFd, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (created && signalFd != -1) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = SIGNAL_SOURCE;
+        epoll_ctl(backendFd, EPOLL_CTL_ADD, signalFd, &event);
+    }
+#else
+    struct sigaction sa{};
+    sa.sa_handler = onSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(sig, &sa, nullptr);
+#endif
+}
+
+bool EventLoop::runOnce(int timeoutMs) {
+    if (checkChildrenNext) timeoutMs = 0;
+
+#ifdef __linux__
+    epoll_event events[32];
+    int n = epoll_wait(backendFd, events, 32, timeoutMs);
+    bool any = n > 0;
+
+    if (checkChildrenNext) {
+        checkChildrenNext = false;
+        checkChildren();
+    }
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.u64 == SIGNAL_SOURCE) {
+            dispatchSignals();
+        } else {
+            dispatch(static_cast<int>(events[i].data.u64));
+        }
+    }
+    return any;
+#else
+    std::vector<pollfd> fds;
+    std::vector<int> ids;
+    fds.push_back({signalFd, POLLIN, 0});
+    ids.push_back(0);
+
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& [id, source] : sources) {
+        if (source.kind == Kind::TIMER) {
+            // the nearest timer bounds the wait
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(source.deadline - now).count();
+            left = std::max<long long>(left, 0);
+            if (timeoutMs < 0 || left < timeoutMs) timeoutMs = static_cast<int>(left);
+        } else if (source.fd != -1) {
+            fds.push_back({source.fd, POLLIN, 0});
+            ids.push_back(id);
+        }
+    }
+
+    int n = ::poll(fds.data(), fds.size(), timeoutMs);
+    bool any = n > 0;
+
+    if (checkChildrenNext) {
+        checkChildrenNext = false;
+        checkChildren();
+    }
+    for (size_t i = 0; n > 0 && i < fds.size(); ++i) {
+        if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        if (ids[i] == 0) {
+            dispatchSignals();
+        } else {
+            dispatch(ids[i]);
+        }
+    }
+
+    std::vector<int> expired;
+    now = std::chrono::steady_clock::now();
+    for (const auto& [id, source] : sources) {
+        if (source.kind == Kind::TIMER && source.deadline <= now) expired.push_back(id);
+    }
+    for (int id : expired) dispatch(id);
+    return any || !expired.empty();
+#endif
+}
+
+void EventLoop::runUntil(const std::function<bool()>& done) {
+    while (!done()) {
+        runOnce(-1);
+    }
+}
+
+void EventLoop::dispatch(int id) {
+    // callbacks may add or remove sources, so look it up again and work on a copy
+    auto it = sources.find(id);
+    if (it == sources.end()) return;
+
+    Callback callback = it->second.callback;
+    switch (it->second.kind) {
+        case Kind::FD:
+            break;
+        case Kind::CHILD:
+            remove(id); // one shot
+            break;
+        case Kind::TIMER:
+#ifdef __linux__
+            if (it->second.fd != -1) {
+                uint64_t expirations;
+                [[maybe_unused]] ssize_t n = read(it->second.fd, &expirations, sizeof(expirations));
+            }
+#endif
+            if (it->second.repeat) {
+                it->second.deadline = std::chrono::steady_clock::now() + it->second.interval;
+            } else {
+                remove(id);
+            }
+            break;
+        case Kind::SIGNAL:
+            return; // comes through dispatchSignals()
+    }
+    if (callback) callback();
+}
+
+void EventLoop::dispatchSignals() {
+    std::vector<SignalEvent> events;
+#ifdef __linux__
+    signalfd_siginfo info;
+    while (read(signalFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        events.push_back({static_cast<int>(info.ssi_signo), static_cast<pid_t>(info.ssi_pid),
+                          static_cast<int>(info.ssi_code)});
+    }
+#else
+    char buffer[64];
+    ssize_t n;
+    while ((n = read(signalFd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < n; ++i) {
+            events.push_back({static_cast<unsigned char>(buffer[i]), 0, 0});
+        }
+    }
+#endif
+
+    bool childSignal = false;
+    for (const auto& event : events) {
+        if (event.signal == SIGCHLD) childSignal = true;
+
+        std::vector<SignalCallback> callbacks;
+        for (const auto& [id, source] : sources) {
+            if (source.kind == Kind::SIGNAL && source.signal == event.signal) {
+                callbacks.push_back(source.signalCallback);
+            }
+        }
+        // nobody watching means it's dropped, same as an ignored signal
+        for (const auto& callback : callbacks) callback(event);
+    }
+    if (childSignal) checkChildren();
+}
+
+void EventLoop::checkChildren() {
+    // children without a pidfd: peek (WNOWAIT) so the callback can still reap them itself
+    std::vector<int> exited;
+    for (const auto& [id, source] : sources) {
+        if (source.kind != Kind::CHILD || source.fd != -1) continue;
+
+        siginfo_t info{};
+        int rc = waitid(P_PID, static_cast<id_t>(source.pid), &info, WEXITED | WNOHANG | WNOWAIT);
+        if ((rc == 0 && info.si_pid == source.pid) || (rc == -1 && errno == ECHILD)) {
+            exited.push_back(id);
+        }
+    }
+    for (int id : exited) dispatch(id);
+}
+
+void EventLoop::resetAfterFork() {
+    closeAll();
+    sources.clear();
+    sigemptyset(&signals);
+
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, nullptr);
+
+#ifdef __linux__
+    backendFd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    if (pipe(s_selfPipe) == 0) {
+        setNonBlocking(s_selfPipe[0]);
+        setNonBlocking(s_selfPipe[1]);
+        signalFd = s_selfPipe[0];
+    }
+#endif
+}
+
+void EventLoop::closeAll() {
+    // only closes our descriptors, a forked parent keeps its own registrations
+    for (auto& [id, source] : sources) {
+        if (source.ownsFd) close(source.fd);
+    }
+    if (signalFd != -1) close(signalFd);
+    if (backendFd != -1) close(backendFd);
+    signalFd = -1;
+    backendFd = -1;
+#ifndef __linux__
+    if (s_selfPipe[1] != -1) close(s_selfPipe[1]);
+    s_selfPipe[1] = -1;
+#endif
+}
+
+EventLoop& getEventLoop() {
+    static EventLoop instance;
+    return instance;
+}
+
+} // namespace olsh::Utils
+
+#endif
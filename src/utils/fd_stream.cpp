@@ -0,0 +1,79 @@
+#include "../../include/utils/fd_stream.h"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace olsh::Utils {
+
+FdStreamBuf::FdStreamBuf(int fd, bool closeOnDestroy, size_t bufferSize)
+    : fd(fd), ownsFd(closeOnDestroy), inBuffer(bufferSize), outBuffer(bufferSize) {
+    setg(inBuffer.data(), inBuffer.data(), inBuffer.data());
+    setp(outBuffer.data(), outBuffer.data() + outBuffer.size());
+}
+
+FdStreamBuf::~FdStreamBuf() {
+    flushOut();
+    if (ownsFd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+}
+
+bool FdStreamBuf::flushOut() {
+    const char* data = pbase();
+    size_t left = pptr() - pbase();
+    while (left > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned int>(left));
+#else
+        ssize_t n = write(fd, data, left);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            setp(outBuffer.data(), outBuffer.data() + outBuffer.size());
+            return false;
+        }
+        data += n;
+        left -= static_cast<size_t>(n);
+    }
+    setp(outBuffer.data(), outBuffer.data() + outBuffer.size());
+    return true;
+}
+
+FdStreamBuf::int_type FdStreamBuf::underflow() {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    for (;;) {
+#ifdef _WIN32
+        int n = _read(fd, inBuffer.data(), static_cast<unsigned int>(inBuffer.size()));
+#else
+        ssize_t n = read(fd, inBuffer.data(), inBuffer.size());
+#endif
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return traits_type::eof();
+        setg(inBuffer.data(), inBuffer.data(), inBuffer.data() + n);
+        return traits_type::to_int_type(*gptr());
+    }
+}
+
+FdStreamBuf::int_type FdStreamBuf::overflow(int_type ch) {
+    if (!flushOut()) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int FdStreamBuf::sync() {
+    return flushOut() ? 0 : -1;
+}
+
+} // namespace olsh::Utils
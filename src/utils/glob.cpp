@@ -0,0 +1,177 @@
+#include "../../include/utils/glob.h"
+
+namespace olsh::Utils {
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+    auto literalChar = [&](char c) {
+        if (steps.empty() || steps.back().kind != Kind::LITERAL) {
+            steps.push_back({Kind::LITERAL, (uint32_t)text.size(), 0});
+        }
+        text += c;
+        steps.back().size++;
+        least++;
+    };
+
+    char quote = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+            else literalChar(c);
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '\\' && i + 1 < pattern.size()) {
+            literalChar(pattern[++i]);
+        } else if (c == '*') {
+            // ** is *
+            if (steps.empty() || steps.back().kind != Kind::STAR) steps.push_back({Kind::STAR});
+            wild = star = true;
+        } else if (c == '?') {
+            steps.push_back({Kind::ANY});
+            least++;
+            wild = true;
+        } else if (c == '[') {
+            // [!...] or [^...] negates, a ] right at the start is one of the chars, no
+            // closing ] makes the [ an ordinary char
+            size_t j = i + 1;
+            bool negate = j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^');
+            if (negate) j++;
+            size_t first = j;
+            std::bitset<256> set;
+            while (j < pattern.size() && (pattern[j] != ']' || j == first)) {
+                unsigned char from = (unsigned char)pattern[j];
+                if (from == '\\' && j + 1 < pattern.size()) from = (unsigned char)pattern[++j];
+                if (j + 2 < pattern.size() && pattern[j + 1] == '-' && pattern[j + 2] != ']') {
+                    unsigned char to = (unsigned char)pattern[j + 2];
+                    for (unsigned c2 = from; c2 <= to; ++c2) set.set(c2);
+                    j += 3;
+                } else {
+                    set.set(from);
+                    j++;
+                }
+            }
+            if (j >= pattern.size()) {
+                literalChar(c);
+                continue;
+            }
+            if (negate) set.flip();
+            steps.push_back({Kind::SET, (uint32_t)sets.size()});
+            sets.push_back(set);
+            least++;
+            wild = true;
+            i = j;
+        } else {
+            literalChar(c);
+        }
+    }
+}
+
+bool GlobPattern::matches(std::string_view s) const {
+    if (!wild) return s == text;
+    if (s.size() < least || (!star && s.size() != least)) return false;
+
+    size_t si = 0;
+    size_t pi = 0;
+    size_t starStep = SIZE_MAX; // the last * and where in s it currently ends
+    size_t starEnd = 0;
+    while (si < s.size() || pi < steps.size()) {
+        if (pi < steps.size()) {
+            const Step& step = steps[pi];
+            switch (step.kind) {
+                case Kind::STAR:
+                    starStep = pi++;
+                    starEnd = si;
+                    continue;
+                case Kind::ANY:
+                    if (si < s.size()) { si++; pi++; continue; }
+                    break;
+                case Kind::SET:
+                    if (si < s.size() && sets[step.index].test((unsigned char)s[si])) { si++; pi++; continue; }
+                    break;
+                case Kind::LITERAL:
+                    if (s.compare(si, step.size, std::string_view(text).substr(step.index, step.size)) == 0) {
+                        si += step.size;
+                        pi++;
+                        continue;
+                    }
+                    break;
+            }
+        }
+        // let the last * take one more char and try the rest again
+        if (starStep == SIZE_MAX || starEnd >= s.size()) return false;
+        pi = starStep + 1;
+        si = ++starEnd;
+    }
+    return true;
+}
+
+bool GlobPattern::plausible(std::string_view s) const {
+    if (s.size() < least) return false;
+    if (steps.empty()) return true;
+    const Step& first = steps.front();
+    if (first.kind == Kind::LITERAL && s.compare(0, first.size, std::string_view(text).substr(first.index, first.size)) != 0) return false;
+    const Step& last = steps.back();
+    return last.kind != Kind::LITERAL ||
+           (s.size() >= last.size && s.compare(s.size() - last.size, last.size, std::string_view(text).substr(last.index, last.size)) == 0);
+}
+
+size_t GlobPattern::prefix(std::string_view s, bool longest) const {
+    if (!star) {
+        return s.size() >= least && matches(s.substr(0, least)) ? least : std::string_view::npos;
+    }
+    for (size_t i = 0; i <= s.size() - std::min(s.size(), least); ++i) {
+        size_t length = longest ? s.size() - i : least + i;
+        std::string_view candidate = s.substr(0, length);
+        if (plausible(candidate) && matches(candidate)) return length;
+    }
+    return std::string_view::npos;
+}
+
+size_t GlobPattern::suffix(std::string_view s, bool longest) const {
+    if (!star) {
+        return s.size() >= least && matches(s.substr(s.size() - least)) ? s.size() - least : std::string_view::npos;
+    }
+    for (size_t i = 0; i <= s.size() - std::min(s.size(), least); ++i) {
+        size_t start = longest ? i : s.size() - least - i;
+        std::string_view candidate = s.substr(start);
+        if (plausible(candidate) && matches(candidate)) return start;
+    }
+    return std::string_view::npos;
+}
+
+bool GlobPattern::find(std::string_view s, size_t from, size_t& at, size_t& length) const {
+    if (!wild) {
+        if (text.empty()) return false;
+        at = s.find(text, from);
+        length = text.size();
+        return at != std::string_view::npos;
+    }
+    // a match has to start with the pattern's leading literal, there's no point trying
+    // anywhere else
+    std::string_view lead;
+    if (!steps.empty() && steps.front().kind == Kind::LITERAL) {
+        lead = std::string_view(text).substr(steps.front().index, steps.front().size);
+    }
+    // and it has to end with the trailing one, so nothing past the last of those can be
+    // part of a match
+    size_t limit = s.size();
+    const Step& last = steps.back();
+    if (last.kind == Kind::LITERAL) {
+        limit = s.rfind(std::string_view(text).substr(last.index, last.size));
+        if (limit == std::string_view::npos || limit < from) return false;
+        limit += last.size;
+    }
+    for (at = from; at + least <= limit && at < limit; ++at) {
+        if (!lead.empty()) {
+            at = s.find(lead, at);
+            if (at == std::string_view::npos || at + least > limit) return false;
+        }
+        length = prefix(s.substr(at, limit - at), true);
+        if (length != std::string_view::npos && length > 0) return true;
+    }
+    return false;
+}
+
+} // namespace olsh::Utils
@@ -8,6 +8,10 @@
 #include <io.h>
 #else
 #include <unistd.h>
+#include <csignal>
+#include <cstdlib>
+#include <chrono>
+#include "utils/event_loop.h"
 #endif
 
 namespace olsh::Utils {
@@ -56,7 +60,21 @@ std::string InputManager::readLine(const std::string& prompt) {
             return "\x04";
         }
     } else {
+#ifdef _WIN32
         char* line = readline(prompt.c_str());
+#else
+        std::cout << prompt << std::flush;
+        switch (waitForInput()) {
+            case InputWait::INTERRUPTED:
+                return "";
+            case InputWait::TIMED_OUT:
+                std::cout << "\ntimed out waiting for input: auto-logout" << std::endl;
+                return "\x04";
+            case InputWait::READY:
+                break;
+        }
+        char* line = readline("");
+#endif
         
         if (!line) {
             // null return indicates EOF (Ctrl+D) - return special marker
@@ -70,6 +88,38 @@ std::string InputManager::readLine(const std::string& prompt) {
     }
 }
 
+#ifndef _WIN32
+InputManager::InputWait InputManager::waitForInput() {
+    // background jobs get reaped and ctrl+c handled while the prompt is up, without polling
+    EventLoop& loop = getEventLoop();
+    bool ready = false;
+    bool interrupted = false;
+    bool timedOut = false;
+
+    int inputWatch = loop.watchFd(STDIN_FILENO, [&ready] { ready = true; });
+    int interruptWatch = loop.watchSignal(SIGINT, [&interrupted](const SignalEvent&) { interrupted = true; });
+
+    // TMOUT=seconds logs out an idle interactive shell, like bash
+    int timer = -1;
+    if (const char* tmout = std::getenv("TMOUT")) {
+        int seconds = std::atoi(tmout);
+        if (seconds > 0) {
+            timer = loop.addTimer(std::chrono::seconds(seconds), [&timedOut] { timedOut = true; });
+        }
+    }
+
+    loop.runUntil([&] { return ready || interrupted || timedOut; });
+
+    loop.remove(inputWatch);
+    loop.remove(interruptWatch);
+    if (timer != -1) loop.remove(timer);
+
+    if (interrupted) return InputWait::INTERRUPTED;
+    if (timedOut) return InputWait::TIMED_OUT;
+    return InputWait::READY;
+}
+#endif
+
 void InputManager::addToHistory(const std::string& line) {
     if (!line.empty()) {
         readlineHistoryAdd(line.c_str());
@@ -0,0 +1,60 @@
+#include "../../include/utils/mapped_file.h"
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace olsh::Utils {
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::unmap() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(mapped), length);
+#endif
+    mapped = nullptr;
+    length = 0;
+    fallback.clear();
+}
+
+bool MappedFile::open(const std::string& path) {
+    unmap();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            close(fd);
+            return true;
+        }
+        void* address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // it's read front to back once
+            madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+            mapped = static_cast<const char*>(address);
+            length = (size_t)info.st_size;
+            close(fd);
+            return true;
+        }
+    }
+    close(fd);
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    fallback = buffer.str();
+    return true;
+}
+
+} // namespace olsh::Utils
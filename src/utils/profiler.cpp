@@ -0,0 +1,251 @@
+#include "../../include/utils/profiler.h"
+#include <utils/colors.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace olsh::Utils {
+
+namespace {
+    constexpr size_t TABLE_LINES = 20; // hottest lines in the table, the JSON has all of them
+
+    constexpr const char* CATEGORY_NAMES[] = {"fork", "substitution", "expansion"};
+
+    double ms(double msPerTick, ScriptProfiler::Ticks ticks) {
+        return (double)ticks * msPerTick;
+    }
+
+    void jsonString(std::ostream& out, const std::string& s) {
+        out << '"';
+        for (char c : s) {
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        out << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf] << "0123456789abcdef"[c & 0xf];
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    struct LineEntry {
+        const std::string* file;
+        uint32_t line;
+        const ScriptProfiler::LineStats* stats;
+    };
+
+    struct FunctionEntry {
+        const std::string* name;
+        const ScriptProfiler::FunctionStats* stats;
+    };
+}
+
+void ScriptProfiler::start() {
+    if (on) return;
+    on = true;
+    startedTime = Clock::now();
+    started = last = now();
+    topLevel = &functions["(top level)"];
+}
+
+void ScriptProfiler::stop() {
+    if (!on) return;
+    Ticks at = now();
+    slice(at);
+    elapsed += at - started;
+    elapsedTime += Clock::now() - startedTime;
+    on = false;
+}
+
+void ScriptProfiler::enter(Cursor& cursor, const std::string& file) {
+    cursor.lines = &files[file];
+    cursor.line = 0;
+    cursor.callerLines = currentLines;
+    cursor.callerLine = currentLine;
+}
+
+void ScriptProfiler::leave(Cursor& cursor) {
+    if (on) {
+        Ticks at = now();
+        slice(at);
+        if (cursor.line && cursor.started >= started) (*cursor.lines)[cursor.line].inclusive += at - cursor.started;
+    }
+    currentLines = cursor.callerLines;
+    currentLine = cursor.callerLine;
+}
+
+void ScriptProfiler::enterFunction(const std::string& name) {
+    Ticks at = now();
+    slice(at);
+    FunctionStats& function = functions[name];
+    function.calls++;
+    function.running++;
+    calls.push_back({&function, at});
+}
+
+void ScriptProfiler::leaveFunction() {
+    if (calls.empty()) return;
+    Call call = calls.back();
+    if (on) {
+        Ticks at = now();
+        slice(at);
+        if (call.function->running == 1 && call.started >= started) call.function->inclusive += at - call.started;
+    }
+    call.function->running--;
+    calls.pop_back();
+}
+
+void ScriptProfiler::spend(Category category, Ticks time) {
+    size_t c = (size_t)category;
+    if (currentLines) (*currentLines)[currentLine].spent[c] += time;
+    if (--open[c] == 0) spentTotal[c] += time;
+}
+
+void ScriptProfiler::leaveScript() {
+    if (--scripts > 0 || !hasData()) return;
+    stop();
+    report();
+}
+
+void ScriptProfiler::report() {
+    // the script itself runs once, for as long as the profiler did
+    Ticks total = elapsed + (on ? now() - started : 0);
+    Clock::duration time = elapsedTime + (on ? Clock::now() - startedTime : Clock::duration{});
+    if (topLevel) {
+        topLevel->calls = 1;
+        topLevel->inclusive = total;
+    }
+    double msPerTick = total ? std::chrono::duration<double, std::milli>(time).count() / (double)total : 0;
+
+    if (output.empty()) {
+        printTable(std::cerr, total, msPerTick);
+    } else {
+        std::ofstream file(output);
+        if (file.is_open()) {
+            writeJson(file, total, msPerTick);
+        } else {
+            std::cerr << RED << "Error: Cannot write profile to " << output << RESET << std::endl;
+        }
+    }
+
+    files.clear();
+    functions.clear();
+    calls.clear();
+    topLevel = on ? &functions["(top level)"] : nullptr;
+    currentLines = nullptr;
+    currentLine = 0;
+    std::fill(std::begin(spentTotal), std::end(spentTotal), 0);
+    elapsed = 0;
+    elapsedTime = {};
+    startedTime = Clock::now();
+    started = last = now();
+}
+
+namespace {
+    // hottest first, by the time spent on the line itself
+    std::vector<LineEntry> sortedLines(const std::unordered_map<std::string, std::vector<ScriptProfiler::LineStats>>& files) {
+        std::vector<LineEntry> lines;
+        for (const auto& [file, stats] : files) {
+            for (uint32_t line = 1; line < stats.size(); ++line) {
+                if (stats[line].count) lines.push_back({&file, line, &stats[line]});
+            }
+        }
+        std::sort(lines.begin(), lines.end(), [](const LineEntry& a, const LineEntry& b) {
+            if (a.stats->exclusive != b.stats->exclusive) return a.stats->exclusive > b.stats->exclusive;
+            if (*a.file != *b.file) return *a.file < *b.file;
+            return a.line < b.line;
+        });
+        return lines;
+    }
+
+    std::vector<FunctionEntry> sortedFunctions(const std::unordered_map<std::string, ScriptProfiler::FunctionStats>& functions) {
+        std::vector<FunctionEntry> entries;
+        for (const auto& [name, stats] : functions) {
+            if (stats.calls) entries.push_back({&name, &stats});
+        }
+        std::sort(entries.begin(), entries.end(), [](const FunctionEntry& a, const FunctionEntry& b) {
+            if (a.stats->exclusive != b.stats->exclusive) return a.stats->exclusive > b.stats->exclusive;
+            return *a.name < *b.name;
+        });
+        return entries;
+    }
+}
+
+void ScriptProfiler::printTable(std::ostream& out, Ticks total, double msPerTick) const {
+    out << std::fixed << std::setprecision(3);
+    out << "profile: " << ms(msPerTick, total) << " ms";
+    for (size_t c = 0; c < (size_t)Category::COUNT; ++c) {
+        out << ", " << CATEGORY_NAMES[c] << ' ' << ms(msPerTick, spentTotal[c]) << " ms";
+    }
+    out << "\n\n";
+
+    auto lines = sortedLines(files);
+    out << std::setw(12) << "excl ms" << std::setw(12) << "incl ms" << std::setw(10) << "count"
+        << std::setw(11) << "fork ms" << std::setw(11) << "subst ms" << std::setw(11) << "expand ms"
+        << "  line\n";
+    for (size_t i = 0; i < lines.size() && i < TABLE_LINES; ++i) {
+        const LineStats& s = *lines[i].stats;
+        out << std::setw(12) << ms(msPerTick, s.exclusive) << std::setw(12) << ms(msPerTick, s.inclusive) << std::setw(10) << s.count;
+        for (const auto& spent : s.spent) out << std::setw(11) << ms(msPerTick, spent);
+        out << "  " << *lines[i].file << ':' << lines[i].line << '\n';
+    }
+    if (lines.size() > TABLE_LINES) out << "  (" << lines.size() - TABLE_LINES << " more lines)\n";
+
+    out << '\n' << std::setw(12) << "excl ms" << std::setw(12) << "incl ms" << std::setw(10) << "calls"
+        << "  function\n";
+    for (const auto& entry : sortedFunctions(functions)) {
+        const FunctionStats& s = *entry.stats;
+        out << std::setw(12) << ms(msPerTick, s.exclusive) << std::setw(12) << ms(msPerTick, s.inclusive) << std::setw(10) << s.calls
+            << "  " << *entry.name << '\n';
+    }
+    out << std::defaultfloat << std::flush;
+}
+
+void ScriptProfiler::writeJson(std::ostream& out, Ticks total, double msPerTick) const {
+    out << std::fixed << std::setprecision(3);
+    out << "{\"total_ms\":" << ms(msPerTick, total);
+    for (size_t c = 0; c < (size_t)Category::COUNT; ++c) {
+        out << ",\"" << CATEGORY_NAMES[c] << "_ms\":" << ms(msPerTick, spentTotal[c]);
+    }
+
+    out << ",\"lines\":[";
+    bool first = true;
+    for (const auto& entry : sortedLines(files)) {
+        const LineStats& s = *entry.stats;
+        out << (first ? "" : ",") << "{\"file\":";
+        jsonString(out, *entry.file);
+        out << ",\"line\":" << entry.line << ",\"count\":" << s.count
+            << ",\"inclusive_ms\":" << ms(msPerTick, s.inclusive) << ",\"exclusive_ms\":" << ms(msPerTick, s.exclusive);
+        for (size_t c = 0; c < (size_t)Category::COUNT; ++c) {
+            out << ",\"" << CATEGORY_NAMES[c] << "_ms\":" << ms(msPerTick, s.spent[c]);
+        }
+        out << '}';
+        first = false;
+    }
+
+    out << "],\"functions\":[";
+    first = true;
+    for (const auto& entry : sortedFunctions(functions)) {
+        const FunctionStats& s = *entry.stats;
+        out << (first ? "" : ",") << "{\"name\":";
+        jsonString(out, *entry.name);
+        out << ",\"calls\":" << s.calls << ",\"inclusive_ms\":" << ms(msPerTick, s.inclusive)
+            << ",\"exclusive_ms\":" << ms(msPerTick, s.exclusive) << '}';
+        first = false;
+    }
+    out << "]}\n" << std::defaultfloat;
+}
+
+ScriptProfiler& getProfiler() {
+    static ScriptProfiler instance;
+    return instance;
+}
+
+} // namespace olsh::Utils
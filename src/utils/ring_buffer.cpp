@@ -0,0 +1,138 @@
+#include "../../include/utils/ring_buffer.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace olsh::Utils {
+
+RingBuffer::RingBuffer(size_t capacity)
+    : buffer(std::bit_ceil(std::max<size_t>(capacity, 64))), mask(buffer.size() - 1) {}
+
+size_t RingBuffer::write(const char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        // read the event counter before the tail, then a read that lands after the
+        // check still changes it and the wait below returns right away
+        uint32_t seen = consumed.load(std::memory_order_acquire);
+        if (readerClosed.load(std::memory_order_acquire)) break;
+
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t space = buffer.size() - (h - t);
+        if (space == 0) {
+            consumed.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        size_t n = std::min(space, size - done);
+        size_t at = h & mask;
+        size_t first = std::min(n, buffer.size() - at);
+        std::memcpy(buffer.data() + at, data + done, first);
+        std::memcpy(buffer.data(), data + done + first, n - first);
+
+        head.store(h + n, std::memory_order_release);
+        produced.fetch_add(1, std::memory_order_release);
+        produced.notify_one();
+        done += n;
+    }
+    return done;
+}
+
+size_t RingBuffer::read(char* data, size_t size) {
+    if (size == 0) return 0;
+    for (;;) {
+        uint32_t seen = produced.load(std::memory_order_acquire);
+        bool closed = writerClosed.load(std::memory_order_acquire);
+
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            // closed is checked before head, so anything written before the close is seen
+            if (closed) return 0;
+            produced.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        size_t n = std::min(h - t, size);
+        size_t at = t & mask;
+        size_t first = std::min(n, buffer.size() - at);
+        std::memcpy(data, buffer.data() + at, first);
+        std::memcpy(data + first, buffer.data(), n - first);
+
+        tail.store(t + n, std::memory_order_release);
+        consumed.fetch_add(1, std::memory_order_release);
+        consumed.notify_one();
+        return n;
+    }
+}
+
+void RingBuffer::closeWrite() {
+    writerClosed.store(true, std::memory_order_release);
+    produced.fetch_add(1, std::memory_order_release);
+    produced.notify_all();
+}
+
+void RingBuffer::closeRead() {
+    readerClosed.store(true, std::memory_order_release);
+    consumed.fetch_add(1, std::memory_order_release);
+    consumed.notify_all();
+}
+
+RingStreamBuf::RingStreamBuf(std::shared_ptr<RingBuffer> ring, End end, size_t bufferSize)
+    : ring(std::move(ring)), end(end), local(bufferSize) {
+    if (end == End::READ) {
+        setg(local.data(), local.data(), local.data());
+    } else {
+        setp(local.data(), local.data() + local.size());
+    }
+}
+
+RingStreamBuf::~RingStreamBuf() {
+    if (end == End::WRITE) {
+        flushOut();
+        ring->closeWrite();
+    } else {
+        ring->closeRead();
+    }
+}
+
+bool RingStreamBuf::flushOut() {
+    size_t size = pptr() - pbase();
+    bool ok = ring->write(pbase(), size) == size;
+    setp(local.data(), local.data() + local.size());
+    return ok;
+}
+
+RingStreamBuf::int_type RingStreamBuf::underflow() {
+    if (end != End::READ) return traits_type::eof();
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    size_t n = ring->read(local.data(), local.size());
+    if (n == 0) return traits_type::eof();
+    setg(local.data(), local.data(), local.data() + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+RingStreamBuf::int_type RingStreamBuf::overflow(int_type ch) {
+    if (end != End::WRITE || !flushOut()) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize RingStreamBuf::xsputn(const char* s, std::streamsize n) {
+    if (end != End::WRITE) return 0;
+    // big chunks go straight into the ring instead of through the local buffer
+    if (static_cast<size_t>(n) < local.size()) return std::streambuf::xsputn(s, n);
+    if (!flushOut()) return 0;
+    return static_cast<std::streamsize>(ring->write(s, static_cast<size_t>(n)));
+}
+
+int RingStreamBuf::sync() {
+    if (end != End::WRITE) return 0;
+    return flushOut() ? 0 : -1;
+}
+
+} // namespace olsh::Utils
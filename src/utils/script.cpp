@@ -1,5 +1,16 @@
 #include "../../include/utils/script.h"
+#include "../../include/utils/script_compiler.h"
+#include "../../include/utils/symbols.h"
+#include "../../include/utils/mapped_file.h"
+#include "../../include/utils/script_cache.h"
+#include "../../include/utils/streams.h"
+#include "../../include/utils/profiler.h"
+#include "../../include/utils/xtrace.h"
 #include "../../include/shell.h"
+#include "../../include/executor/resource_usage.h"
+#ifdef _WIN32
+#include "../../include/builtins/builtin_registry.h"
+#endif
 #include <utils/colors.h>
 #include <iostream>
 #include <fstream>
@@ -7,42 +18,133 @@
 #include <unordered_map>
 #include <cstdlib>
 #include <cctype>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 namespace {
-    static inline std::string trim(const std::string& s) {
+    static inline std::string_view trimView(std::string_view s) {
         size_t start = 0; while (start < s.size() && std::isspace((unsigned char)s[start])) start++;
         size_t end = s.size(); while (end > start && std::isspace((unsigned char)s[end-1])) end--;
         return s.substr(start, end - start);
     }
 
-    static inline bool starts_with(const std::string& s, const std::string& p) {
-        return s.size() >= p.size() && s.compare(0, p.size(), p) == 0;
+    static inline std::string trim(const std::string& s) {
+        return std::string(trimView(s));
     }
 
-    static inline bool ends_with(const std::string& s, const std::string& suf) {
-        return s.size() >= suf.size() && s.compare(s.size() - suf.size(), suf.size(), suf) == 0;
+    static inline bool starts_with(const std::string& s, const std::string& p) {
+        return s.size() >= p.size() && s.compare(0, p.size(), p) == 0;
     }
 
-    static std::vector<std::string> split_words(const std::string& line) {
+    // keepEmpty keeps '' and "" as words of their own, read -d '' needs them
+    static std::vector<std::string> split_words(const std::string& line, bool keepEmpty = false) {
         std::vector<std::string> out;
         std::string cur;
-        bool in_s=false, in_d=false;
+        bool in_s=false, in_d=false, quoted=false;
         for (size_t i=0;i<line.size();++i) {
             char c=line[i];
             if (c=='\\' && i+1<line.size()) { cur.push_back(line[++i]); continue; }
-            if (c=='"' && !in_s) { in_d=!in_d; continue; }
-            if (c=='\'' && !in_d) { in_s=!in_s; continue; }
-            if (!in_s && !in_d && std::isspace((unsigned char)c)) { if(!cur.empty()){ out.push_back(cur); cur.clear(); } }
+            if (c=='"' && !in_s) { in_d=!in_d; quoted=true; continue; }
+            if (c=='\'' && !in_d) { in_s=!in_s; quoted=true; continue; }
+            if (!in_s && !in_d && std::isspace((unsigned char)c)) {
+                if(!cur.empty() || (keepEmpty && quoted)){ out.push_back(cur); cur.clear(); }
+                quoted=false;
+            }
             else cur.push_back(c);
         }
-        if(!cur.empty()) out.push_back(cur);
+        if(!cur.empty() || (keepEmpty && quoted)) out.push_back(cur);
         return out;
     }
+
+    static bool validName(std::string_view name) {
+        return !name.empty() && !std::isdigit((unsigned char)name[0]) &&
+               name.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") == std::string::npos;
+    }
 }
 
 namespace olsh::Utils {
 
+namespace {
+    // next $ or ` at or after from (size() if there is none). 8 bytes at a time, the same
+    // trick memchr uses: a byte of x ^ pattern is zero where the byte matched
+    size_t findExpansion(std::string_view s, size_t from) {
+        constexpr uint64_t ONES = 0x0101010101010101ULL;
+        constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+        auto has = [](uint64_t word, char c) {
+            uint64_t x = word ^ (ONES * (unsigned char)c);
+            return (x - ONES) & ~x & HIGHS;
+        };
+
+        const char* p = s.data() + from;
+        const char* end = s.data() + s.size();
+        while (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            if (has(word, '$') | has(word, '`')) break;
+            p += 8;
+        }
+        while (p < end && *p != '$' && *p != '`') p++;
+        return (size_t)(p - s.data());
+    }
+
+    // the ) that closes a $( whose inside starts at from. quoted parens and ones in a nested
+    // $(...) or `...` don't count. npos if it never closes
+    size_t closingParen(std::string_view s, size_t from) {
+        int depth = 1;
+        char quote = 0;
+        for (size_t i = from; i < s.size(); ++i) {
+            char c = s[i];
+            if (c == '\\') { i++; continue; }
+            if (quote) {
+                if (c == quote) quote = 0;
+                continue;
+            }
+            if (c == '\'' || c == '"' || c == '`') quote = c;
+            else if (c == '(') depth++;
+            else if (c == ')' && --depth == 0) return i;
+        }
+        return std::string_view::npos;
+    }
+
+    // the } of a ${ whose inside starts at from, a ${...} nested in it has its own
+    size_t closingBrace(std::string_view s, size_t from) {
+        int depth = 1;
+        for (size_t i = from; i < s.size(); ++i) {
+            if (s[i] == '\\') i++;
+            else if (s[i] == '{') depth++;
+            else if (s[i] == '}' && --depth == 0) return i;
+        }
+        return std::string_view::npos;
+    }
+
+    size_t closingBacktick(std::string_view s, size_t from) {
+        for (size_t i = from; i < s.size(); ++i) {
+            if (s[i] == '\\') i++;
+            else if (s[i] == '`') return i;
+        }
+        return std::string_view::npos;
+    }
+}
+
+namespace {
+    // a profile covers the outermost script that runs, it's reported when that one is done
+    struct ProfiledScript {
+        ProfiledScript() { getProfiler().enterScript(); }
+        ~ProfiledScript() { getProfiler().leaveScript(); }
+    };
+}
+
 ScriptInterpreter::ScriptInterpreter(olsh::Shell* shellInstance) : shell(shellInstance) {}
 
 bool ScriptInterpreter::isScriptFile(const std::string& filename) {
@@ -60,17 +162,39 @@ int ScriptInterpreter::executeScript(const std::string& filename,
         return 1;
     }
 
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << RED << "Error: Cannot open script file: " << filename << RESET << std::endl;
-        return 1;
+    // an unchanged script runs from what the compiler made of it last time
+    ScriptCache& cache = getScriptCache();
+    ScriptCache::Key key;
+    bool cacheable = ScriptCache::keyFor(filename, key) && key.size <= ScriptCache::MAX_SCRIPT_SIZE;
+    ScriptCache::Statements compiled;
+    if (cacheable && cache.enabled() && cache.load(key, filename, compiled)) {
+        ProfiledScript profiled;
+        int status = 0;
+        for (const auto& program : compiled) status = execute(program, 0, args, nullptr, status);
+        return status;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
+    if (!cacheable) {
+        // too big to keep (or to map, every page read would stay in the shell's memory),
+        // it's streamed from the file instead
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << RED << "Error: Cannot open script file: " << filename << RESET << std::endl;
+            return 1;
+        }
+        ScriptStream stream(file);
+        return run(stream, filename, args);
+    }
 
-    return executeScriptContent(buffer.str(), args);
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << RED << "Error: Cannot open script file: " << filename << RESET << std::endl;
+        return 1;
+    }
+    ScriptStream stream(file.data());
+    int status = run(stream, filename, args, cache.enabled() ? &compiled : nullptr);
+    if (!compiled.empty()) cache.store(key, compiled);
+    return status;
 }
 
 int ScriptInterpreter::executeScriptContent(const std::string& content) {
@@ -79,182 +203,1018 @@ int ScriptInterpreter::executeScriptContent(const std::string& content) {
 
 int ScriptInterpreter::executeScriptContent(const std::string& content,
                                             const std::vector<std::string>& args) {
-    std::istringstream stream(content);
-    return executeLines(stream, args, 0);
+    ScriptStream stream(content);
+    return run(stream, "script", args);
 }
 
-// ---- helpers ----
+int ScriptInterpreter::executeStream(std::istream& input, const std::string& name,
+                                     const std::vector<std::string>& args) {
+    ScriptStream stream(input);
+    // a read in the script takes the lines after it, the same buffer has to serve both
+    std::istream* saved = scriptInput;
+    if (&input == &std::cin) scriptInput = &input;
+    int status = run(stream, name, args);
+    scriptInput = saved;
+    return status;
+}
 
-// simple arithmetic parser
-class ArithParser {
-    const std::string& s; size_t i;
-    void skip(){ while(i<s.size() && std::isspace((unsigned char)s[i])) i++; }
-    long long parseNumber(){ skip(); bool neg=false; if (i<s.size() && (s[i]=='+' || s[i]=='-')) { neg = s[i]=='-'; i++; }
-        skip(); long long val=0; bool any=false; while(i<s.size() && std::isdigit((unsigned char)s[i])){ any=true; val = val*10 + (s[i]-'0'); i++; }
-        return neg? -val: val; }
-    long long parseFactor(){ skip(); if (i<s.size() && s[i]=='('){ i++; long long v=parseExpr(); skip(); if (i<s.size() && s[i]==')') i++; return v; } return parseNumber(); }
-    long long parseTerm(){ long long v=parseFactor(); while(true){ skip(); if (i>=s.size()) break; char c=s[i]; if (c=='*'||c=='/'||c=='%'){ i++; long long r=parseFactor(); if(c=='*') v*=r; else if(c=='/') v = r==0? 0 : v/r; else v = r==0? 0 : v%r; } else break; } return v; }
-public:
-    ArithParser(const std::string& str): s(str), i(0){}
-    long long parseExpr(){ long long v=parseTerm(); while(true){ skip(); if (i>=s.size()) break; char c=s[i]; if (c=='+'||c=='-'){ i++; long long r=parseTerm(); if(c=='+') v+=r; else v-=r; } else break; } return v; }
-};
+// ---- variables ----
 
-long long ScriptInterpreter::evalArithmetic(const std::string& expr) {
-    ArithParser p(expr);
-    return p.parseExpr();
-}
-
-std::string ScriptInterpreter::expandArithmetic(const std::string& line) {
-    std::string out; out.reserve(line.size());
-    for (size_t i=0;i<line.size();){
-        if (line[i]=='$' && i+3<line.size() && line[i+1]=='(' && line[i+2]=='(') {
-            size_t j=i+3; int depth=1; while(j<line.size() && depth>0){ if(line[j]=='(') depth++; else if(line[j]==')') depth--; j++; }
-            if (depth==0 && j<line.size() && line[j]==')') { // had closing ))
-                std::string expr = line.substr(i+3, (j-1)-(i+3));
-                // replace bare identifiers with variable values
-                std::string replaced; replaced.reserve(expr.size());
-                for (size_t k=0; k<expr.size(); ){
-                    char c = expr[k];
-                    if (std::isalpha((unsigned char)c) || c=='_'){
-                        size_t m=k+1; while(m<expr.size() && (std::isalnum((unsigned char)expr[m]) || expr[m]=='_')) m++;
-                        std::string name = expr.substr(k, m-k);
-                        std::string val;
-                        auto it = variables.find(name);
-                        if (it != variables.end()) val = it->second; else {
-                            const char* env = std::getenv(name.c_str()); if (env) val = env; else val = "0";
-                        }
-                        // if val not numeric, default to 0
-                        bool numeric=true; if (val.empty()) numeric=false; else {
-                            size_t p=0; if (val[0]=='+'||val[0]=='-') p=1; for (; p<val.size(); ++p){ if(!std::isdigit((unsigned char)val[p])) { numeric=false; break; } }
-                        }
-                        replaced += numeric ? val : std::string("0");
-                        k = m; continue;
-                    }
-                    replaced.push_back(c); k++;
-                }
-                long long v = evalArithmetic(replaced);
-                out += std::to_string(v);
-                i = j+1;
-                continue;
+namespace {
+    // "42" and "-7" become numbers, "007", "+1" or " 1" have to come back out as they went in
+    bool canonicalNumber(const std::string& text, long long& number) {
+        if (text.empty() || text.size() > 20) return false;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (ec != std::errc() || end != text.data() + text.size()) return false;
+        size_t digits = text[0] == '-' ? 1 : 0;
+        return !(text.size() > digits + 1 && text[digits] == '0') && text != "-0";
+    }
+
+    void setEnvironment(const std::string& name, const char* value) {
+#ifdef _WIN32
+        _putenv_s(name.c_str(), value ? value : "");
+#else
+        if (value) setenv(name.c_str(), value, 1);
+        else unsetenv(name.c_str());
+#endif
+    }
+}
+
+const ScriptInterpreter::Variable* ScriptInterpreter::findVariable(uint32_t symbol) const {
+    if (symbol >= variables.size() || variables[symbol].type == Variable::Type::UNSET) return nullptr;
+    return &variables[symbol];
+}
+
+void ScriptInterpreter::appendVariable(std::string& out, std::string_view name) const {
+    if (const Variable* v = findVariable(getSymbols().find(name))) {
+        if (v->type == Variable::Type::STRING) {
+            out += v->text;
+        } else if (v->type == Variable::Type::ARRAY) {
+            if (!v->items.empty()) out += v->items[0];
+        } else if (v->type == Variable::Type::ASSOC) {
+            if (const std::string* value = v->map.find("0")) out += *value;
+        } else {
+            char buffer[24];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), v->number);
+            out.append(buffer, end);
+        }
+        return;
+    }
+    if (appendLastUsage(out, name)) return;
+    if (const char* env = std::getenv(std::string(name).c_str())) out += env;
+}
+
+long long ScriptInterpreter::numericVariable(uint32_t symbol) const {
+    std::string_view text;
+    if (const Variable* v = findVariable(symbol)) {
+        if (v->type == Variable::Type::INTEGER) return v->number;
+        if (v->type == Variable::Type::ARRAY) {
+            if (!v->items.empty()) text = v->items[0];
+        } else if (v->type == Variable::Type::ASSOC) {
+            if (const std::string* value = v->map.find("0")) text = *value;
+        } else {
+            text = v->text;
+        }
+    } else if (const char* env = std::getenv(getSymbols().name(symbol).c_str())) {
+        text = env;
+    } else {
+        return 0;
+    }
+
+    // anything that isn't a plain (signed) number counts as 0
+    long long number = 0;
+    if (!text.empty() && text[0] == '+') text.remove_prefix(1);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), number);
+    return ec == std::errc() && end == text.data() + text.size() ? number : 0;
+}
+
+ScriptInterpreter::Variable& ScriptInterpreter::slot(uint32_t symbol) {
+    if (symbol >= variables.size()) variables.resize(getSymbols().size());
+    return variables[symbol];
+}
+
+void ScriptInterpreter::setVariable(uint32_t symbol, std::string value) {
+    Variable& v = slot(symbol);
+    if (v.type >= Variable::Type::ARRAY) {
+        v.items.clear();
+        v.map.clear();
+    }
+    if (canonicalNumber(value, v.number)) {
+        v.type = Variable::Type::INTEGER;
+        v.text.clear();
+    } else {
+        v.type = Variable::Type::STRING;
+        v.text = std::move(value);
+    }
+    if (v.exported) exportVariable(symbol);
+}
+
+void ScriptInterpreter::setVariable(uint32_t symbol, long long value) {
+    Variable& v = slot(symbol);
+    if (v.type >= Variable::Type::ARRAY) {
+        v.items.clear();
+        v.map.clear();
+    }
+    v.type = Variable::Type::INTEGER;
+    v.number = value;
+    if (v.exported) exportVariable(symbol);
+}
+
+void ScriptInterpreter::exportVariable(uint32_t symbol) {
+    Variable& v = slot(symbol);
+    v.exported = true;
+    if (v.type == Variable::Type::UNSET || v.type >= Variable::Type::ARRAY) return;
+    const std::string& name = getSymbols().name(symbol);
+    setEnvironment(name, v.type == Variable::Type::STRING ? v.text.c_str() : std::to_string(v.number).c_str());
+}
+
+int ScriptInterpreter::declare(const std::string& text, ScriptOp op, Frame* frame) {
+    const char* what = op == ScriptOp::LOCAL ? "local" : op == ScriptOp::EXPORT ? "export" : "declare";
+    if (op == ScriptOp::LOCAL && !frame) {
+        std::cerr << RED << "local: can only be used in a function" << RESET << std::endl;
+        return 1;
+    }
+
+    // -a and -A make the names arrays, indexed and associative
+    std::string_view rest = text;
+    Variable::Type type = Variable::Type::UNSET;
+    if (rest.size() >= 2 && rest[0] == '-' && (rest[1] == 'a' || rest[1] == 'A') &&
+        (rest.size() == 2 || rest[2] == ' ' || rest[2] == '\t')) {
+        type = rest[1] == 'a' ? Variable::Type::ARRAY : Variable::Type::ASSOC;
+        rest = trimView(rest.substr(2));
+    }
+    if (type != Variable::Type::UNSET && op == ScriptOp::EXPORT) {
+        std::cerr << RED << "export: arrays can't be exported" << RESET << std::endl;
+        return 1;
+    }
+
+    // NAME = value like set, NAME=value, or a list of NAMEs
+    std::vector<std::pair<std::string, std::string>> values;
+    std::vector<std::string> names;
+    size_t eq = rest.find('=');
+    if (eq != std::string_view::npos) {
+        names.emplace_back(trimView(rest.substr(0, eq)));
+        values.emplace_back(names.back(), trimView(rest.substr(eq + 1)));
+    } else {
+        names = split_words(std::string(rest));
+    }
+
+    for (const std::string& name : names) {
+        if (!validName(name)) {
+            std::cerr << RED << what << ": '" << name << "': not a valid name" << RESET << std::endl;
+            return 1;
+        }
+        uint32_t symbol = getSymbols().intern(name);
+
+        if (op == ScriptOp::EXPORT) {
+            exportVariable(symbol);
+            continue;
+        }
+
+        if (op == ScriptOp::DECLARE) {
+            // one that's already the right kind of array keeps its elements
+            Variable& v = slot(symbol);
+            if (type != Variable::Type::UNSET && v.type != type) {
+                bool exported = v.exported;
+                v = Variable{};
+                v.type = type;
+                v.exported = exported;
             }
+            continue;
         }
-        out.push_back(line[i++]);
+
+        // a second local for the same name in the same call keeps the first saved value
+        bool saved = false;
+        for (const auto& entry : frame->saved) saved = saved || entry.first == symbol;
+        if (!saved) frame->saved.emplace_back(symbol, slot(symbol));
+
+        // a local starts out empty and not exported, even if the name it hides was
+        Variable& v = slot(symbol);
+        v = Variable{};
+        v.type = type == Variable::Type::UNSET ? Variable::Type::STRING : type;
     }
-    return out;
-}
-
-std::string ScriptInterpreter::substituteBackticks(const std::string& line,
-                                                   int lastExitCode,
-                                                   const std::vector<std::string>& args) {
-    std::string out; out.reserve(line.size());
-    for (size_t i=0;i<line.size();){
-        if (line[i]=='`'){
-            size_t j=i+1; while(j<line.size() && line[j] != '`') j++;
-            if (j<line.size() && line[j]=='`'){
-                std::string cmd = line.substr(i+1, j-(i+1));
-                // Expand inside backticks first (no nested backticks)
-                cmd = expandLine(cmd, lastExitCode, args);
-                // decide if builtin
-                auto words = split_words(cmd);
-                bool isBuiltin = !words.empty() && (
-                    words[0]=="cd" || words[0]=="ls" || words[0]=="pwd" || words[0]=="echo" ||
-                    words[0]=="rm" || words[0]=="cat" || words[0]=="clear" || words[0]=="history" || words[0]=="alias"
-                );
-                std::string val;
-                if (isBuiltin) {
-                    // capture stdout during execution
-                    auto* old = std::cout.rdbuf();
-                    std::ostringstream capture;
-                    std::cout.rdbuf(capture.rdbuf());
-                    (void)shell->processCommand(cmd);
-                    std::cout.rdbuf(old);
-                    val = capture.str();
-                } else {
-                    // capture external using popen
-                    FILE* pipe = nullptr;
+
+    for (auto& [name, value] : values) {
+        if (int status = assign(name, std::move(value), what)) return status;
+    }
+    return 0;
+}
+
+int ScriptInterpreter::assign(std::string_view target, std::string value, const char* what) {
+    bool append = !target.empty() && target.back() == '+';
+    if (append) target = trimView(target.substr(0, target.size() - 1));
+    std::string_view sub;
+    size_t open = target.find('[');
+    bool element = open != std::string_view::npos && target.back() == ']';
+    if (element) {
+        sub = target.substr(open + 1, target.size() - open - 2);
+        target = target.substr(0, open);
+    }
+    // plain names never were checked here, only what's new is
+    if ((append || element) && !validName(target)) {
+        std::cerr << RED << what << ": '" << target << "': not a valid name" << RESET << std::endl;
+        return 1;
+    }
+
+    uint32_t symbol = getSymbols().intern(target);
+    if (element) return assignElement(symbol, sub, std::move(value), append, what);
+    if (value.size() >= 2 && value.front() == '(' && value.back() == ')') {
+        return assignList(symbol, std::string_view(value).substr(1, value.size() - 2), append, what);
+    }
+    // NAME = value on an array is its element 0
+    const Variable* v = findVariable(symbol);
+    if (v && v->type >= Variable::Type::ARRAY) return assignElement(symbol, "0", std::move(value), append, what);
+    if (append) {
+        std::string joined;
+        appendVariable(joined, target);
+        value = joined + value;
+    }
+    setVariable(symbol, std::move(value));
+    return 0;
+}
+
+namespace {
+    // [KEY]=value in a ( ) list
+    bool keyedElement(std::string_view word, std::string_view& key, std::string_view& value) {
+        size_t close = word.find("]=");
+        if (word.empty() || word[0] != '[' || close == std::string_view::npos) return false;
+        key = word.substr(1, close - 1);
+        value = word.substr(close + 2);
+        return true;
+    }
+}
+
+int ScriptInterpreter::assignList(uint32_t symbol, std::string_view list, bool append, const char* what) {
+    auto words = split_words(std::string(list), true);
+    Variable& v = slot(symbol);
+    std::string_view key, value;
+
+    if (v.type == Variable::Type::ASSOC) {
+        if (!append) v.map.clear();
+        for (const std::string& word : words) {
+            if (!keyedElement(word, key, value)) {
+                std::cerr << RED << what << ": " << getSymbols().name(symbol) << ": '" << word
+                          << "': needs to be [KEY]=value" << RESET << std::endl;
+                return 1;
+            }
+            v.map[key] = value;
+        }
+        return 0;
+    }
+
+    if (!append) toArray(symbol, false).items.clear();
+    // plain words go after the last one, [N]=value ones where they say
+    size_t next = toArray(symbol, true).items.size();
+    for (std::string& word : words) {
+        size_t index = next;
+        if (keyedElement(word, key, value)) {
+            if (!arrayIndex(symbol, key, index) || index >= MAX_ELEMENTS) {
+                std::cerr << RED << what << ": " << getSymbols().name(symbol) << "[" << key << "]: bad array subscript" << RESET << std::endl;
+                return 1;
+            }
+            word = std::string(value);
+        }
+        std::vector<std::string>& items = slot(symbol).items;
+        if (index >= items.size()) items.resize(index + 1);
+        items[index] = std::move(word);
+        next = index + 1;
+    }
+    return 0;
+}
+
+int ScriptInterpreter::assignElement(uint32_t symbol, std::string_view sub, std::string value,
+                                     bool append, const char* what) {
+    if (slot(symbol).type == Variable::Type::ASSOC) {
+        std::string& element = slot(symbol).map[sub];
+        if (append) element += value;
+        else element = std::move(value);
+        return 0;
+    }
+
+    size_t index = 0;
+    if (!arrayIndex(symbol, sub, index) || index >= MAX_ELEMENTS) {
+        std::cerr << RED << what << ": " << getSymbols().name(symbol) << "[" << sub << "]: bad array subscript" << RESET << std::endl;
+        return 1;
+    }
+    Variable& v = toArray(symbol, true);
+    if (index >= v.items.size()) v.items.resize(index + 1);
+    if (append) v.items[index] += value;
+    else v.items[index] = std::move(value);
+    return 0;
+}
+
+ScriptInterpreter::Variable& ScriptInterpreter::toArray(uint32_t symbol, bool keep) {
+    Variable& v = slot(symbol);
+    if (v.type == Variable::Type::ARRAY) return v;
+    std::string first;
+    bool kept = keep && v.type != Variable::Type::UNSET;
+    if (kept) appendVariable(first, getSymbols().name(symbol));
+    bool exported = v.exported;
+    v = Variable{};
+    v.type = Variable::Type::ARRAY;
+    v.exported = exported;
+    if (kept) v.items.push_back(std::move(first));
+    return v;
+}
+
+bool ScriptInterpreter::arithmeticValue(std::string_view text, long long& value) {
+    text = trimView(text);
+    if (text.empty()) return false;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) return true;
+    static const std::vector<std::string> none;
+    ArithExpr expr;
+    std::string message;
+    if (!ArithExpr::compile(text, expr, message)) return false;
+    value = evalArithmetic(expr, 0, none);
+    return true;
+}
+
+bool ScriptInterpreter::arrayIndex(uint32_t symbol, std::string_view sub, size_t& index) {
+    long long n = 0;
+    if (!arithmeticValue(sub, n)) return false;
+    // -1 is the last one
+    if (n < 0) {
+        const Variable* v = findVariable(symbol);
+        n += !v ? 0 : v->type == Variable::Type::ARRAY ? (long long)v->items.size() : 1;
+        if (n < 0) return false;
+    }
+    index = (size_t)n;
+    return true;
+}
+
+void ScriptInterpreter::appendElement(std::string& out, uint32_t symbol, std::string_view sub) {
+    const Variable* v = findVariable(symbol);
+    if (!v) return;
+    if (sub == "@" || sub == "*") {
+        if (v->type == Variable::Type::ARRAY) {
+            for (size_t i = 0; i < v->items.size(); ++i) {
+                if (i) out += ' ';
+                out += v->items[i];
+            }
+        } else if (v->type == Variable::Type::ASSOC) {
+            bool first = true;
+            for (const auto& entry : v->map.entries()) {
+                if (!first) out += ' ';
+                out += entry.value;
+                first = false;
+            }
+        } else {
+            appendVariable(out, getSymbols().name(symbol));
+        }
+        return;
+    }
+    if (v->type == Variable::Type::ASSOC) {
+        if (const std::string* value = v->map.find(sub)) out += *value;
+        return;
+    }
+    // the subscript is arithmetic that can set variables, v is looked up again after it
+    size_t index = 0;
+    if (!arrayIndex(symbol, sub, index)) return;
+    v = findVariable(symbol);
+    if (!v) return;
+    if (v->type == Variable::Type::ARRAY) {
+        if (index < v->items.size()) out += v->items[index];
+    } else if (index == 0) {
+        appendVariable(out, getSymbols().name(symbol));
+    }
+}
+
+std::vector<std::string> ScriptInterpreter::arrayValues(uint32_t symbol, bool keys) const {
+    std::vector<std::string> values;
+    const Variable* v = findVariable(symbol);
+    if (!v) return values;
+    if (v->type == Variable::Type::ARRAY) {
+        if (!keys) return v->items;
+        values.reserve(v->items.size());
+        for (size_t i = 0; i < v->items.size(); ++i) values.push_back(std::to_string(i));
+    } else if (v->type == Variable::Type::ASSOC) {
+        values.reserve(v->map.size());
+        for (const auto& entry : v->map.entries()) values.push_back(keys ? entry.key : entry.value);
+    } else if (keys) {
+        values.emplace_back("0");
+    } else {
+        values.emplace_back();
+        appendVariable(values.back(), getSymbols().name(symbol));
+    }
+    return values;
+}
+
+void ScriptInterpreter::leave(Frame& frame) {
+    // newest first, so the oldest saved value is the one that sticks
+    for (auto it = frame.saved.rbegin(); it != frame.saved.rend(); ++it) {
+        Variable& v = slot(it->first);
+        bool wasExported = v.exported;
+        v = std::move(it->second);
+        if (v.exported) exportVariable(it->first);
+        else if (wasExported) setEnvironment(getSymbols().name(it->first), nullptr);
+    }
+    frame.saved.clear();
+}
+
+// ---- read ----
+
+std::istream* ScriptInterpreter::input(int fd) {
+    if (fd == -1) {
+        // a done < FILE loop, or a redirection of whatever runs the script
+        std::istream& current = in();
+        if (&current != &std::cin) return &current;
+        if (scriptInput) return scriptInput;
+        fd = 0;
+    }
+    auto it = inputs.find(fd);
+    if (it != inputs.end()) return &it->second->stream;
+#ifndef _WIN32
+    if (fcntl(fd, F_GETFD) == -1) return nullptr;
+#endif
+    return &inputs.emplace(fd, std::make_unique<Input>(fd, false)).first->second->stream;
+}
+
+bool ScriptInterpreter::openInput(const std::string& file) {
 #ifdef _WIN32
-                    pipe = _popen(cmd.c_str(), "r");
+    int fd = _open(file.c_str(), _O_RDONLY | _O_BINARY);
 #else
-                    pipe = popen(cmd.c_str(), "r");
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
 #endif
-                    if (pipe) {
-                        char buffer[512]; size_t n;
-                        while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) val.append(buffer, n);
+    if (fd == -1) {
+        std::cerr << RED << "Script error: cannot open " << file << ": " << std::strerror(errno) << RESET << std::endl;
+        return false;
+    }
+    // one left over for the same number was for an fd that's been closed since
+    auto& slot = inputs[fd];
+    slot = std::make_unique<Input>(fd, true);
+    redirected.emplace_back(fd, std::make_unique<StreamScope>(&slot->stream, nullptr, nullptr));
+    return true;
+}
+
+void ScriptInterpreter::closeInput() {
+    int fd = redirected.back().first;
+    redirected.pop_back();
+    inputs.erase(fd);
+}
+
+int ScriptInterpreter::read(const std::string& text) {
+    auto words = split_words(text, true);
+    bool raw = false;
+    char delim = '\n';
+    int fd = -1;
+    size_t first = 0;
+    for (; first < words.size() && words[first].size() > 1 && words[first][0] == '-'; ++first) {
+        const std::string& option = words[first];
+        if (option == "--") { first++; break; }
+        if (option == "-r") {
+            raw = true;
+        } else if (option == "-d" || option == "-u") {
+            if (first + 1 == words.size()) {
+                std::cerr << RED << "read: " << option << ": option requires an argument" << RESET << std::endl;
+                return 2;
+            }
+            const std::string& value = words[++first];
+            if (option == "-d") {
+                delim = value.empty() ? '\0' : value[0];
+                continue;
+            }
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), fd);
+            if (ec != std::errc() || end != value.data() + value.size() || fd < 0) {
+                std::cerr << RED << "read: " << value << ": invalid file descriptor" << RESET << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << RED << "read: " << option << ": invalid option" << RESET << std::endl;
+            return 2;
+        }
+    }
+    for (size_t i = first; i < words.size(); ++i) {
+        if (!validName(words[i])) {
+            std::cerr << RED << "read: '" << words[i] << "': not a valid name" << RESET << std::endl;
+            return 1;
+        }
+    }
+
+    std::istream* stream = input(fd);
+    if (!stream) {
+        std::cerr << RED << "read: " << fd << ": invalid file descriptor" << RESET << std::endl;
+        return 1;
+    }
+
+    // up to the delimiter, which getline finds with a scan of the buffer. without -r a
+    // backslash at the end of a line joins the next one to it
+    std::string line;
+    bool ended = false;
+    for (std::string part;;) {
+        std::getline(*stream, part, delim);
+        ended = !stream->eof() && !stream->fail();
+        stream->clear(); // at the end of a terminal there can be more later
+        line += part;
+        if (raw || !ended || delim != '\n' || line.empty() || line.back() != '\\') break;
+        size_t slashes = line.size() - line.find_last_not_of('\\') - 1;
+        if (slashes % 2 == 0) break;
+        line.pop_back();
+    }
+
+    // fields are split on blanks and the last name gets the rest of the line. without -r a
+    // backslash keeps the char after it as it is, blank or not
+    bool escapes = !raw && line.find('\\') != std::string::npos;
+    auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\n'; };
+    size_t at = 0;
+    auto field = [&](bool rest, bool trimmed) {
+        std::string value;
+        size_t kept = 0; // up to the last char that isn't a trailing blank
+        while (at < line.size()) {
+            char c = line[at];
+            if (escapes && c == '\\' && at + 1 < line.size()) {
+                value += line[at + 1];
+                at += 2;
+                kept = value.size();
+                continue;
+            }
+            if (!rest && blank(c)) break;
+            value += c;
+            at++;
+            if (!blank(c)) kept = value.size();
+        }
+        if (trimmed) value.resize(kept);
+        return value;
+    };
+
+    if (first == words.size()) {
+        // plain read keeps the blanks, REPLY is the line as it came
+        setVariable(getSymbols().intern("REPLY"), escapes ? field(true, false) : std::move(line));
+    } else if (first + 1 == words.size() && !escapes) {
+        size_t begin = std::min(line.find_first_not_of(" \t\n"), line.size());
+        size_t end = line.find_last_not_of(" \t\n") + 1;
+        if (end < begin) end = begin;
+        if (end < line.size()) line.resize(end);
+        if (begin) line.erase(0, begin);
+        setVariable(getSymbols().intern(words[first]), std::move(line));
+    } else {
+        for (size_t i = first; i < words.size(); ++i) {
+            while (at < line.size() && blank(line[at])) at++;
+            setVariable(getSymbols().intern(words[i]), field(i + 1 == words.size(), true));
+        }
+    }
+    return ended ? 0 : 1;
+}
+
+// ---- helpers ----
+
+class ScriptInterpreter::ArithScope : public ArithExpr::Context {
+public:
+    ArithScope(ScriptInterpreter& si, int lastExitCode, const std::vector<std::string>& arguments)
+        : interpreter(si), exitCode(lastExitCode), args(arguments) {}
+
+    long long get(uint32_t symbol) override { return interpreter.numericVariable(symbol); }
+    void set(uint32_t symbol, long long value) override { interpreter.setVariable(symbol, value); }
+    long long positional(uint32_t index) override {
+        if (index < 1 || index > args.size()) return 0;
+        long long v = 0;
+        const std::string& arg = args[index - 1];
+        auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), v);
+        return ec == std::errc() && end == arg.data() + arg.size() ? v : 0;
+    }
+    long long argumentCount() override { return (long long)args.size(); }
+    long long status() override { return exitCode; }
+
+private:
+    ScriptInterpreter& interpreter;
+    int exitCode;
+    const std::vector<std::string>& args;
+};
+
+long long ScriptInterpreter::evalArithmetic(const ArithExpr& expr,
+                                           int lastExitCode,
+                                           const std::vector<std::string>& args) {
+    ArithScope scope(*this, lastExitCode, args);
+    return expr.evaluate(scope);
+}
+
+// output of a $(...) or `...`, with the trailing newlines cut off. everything runs in here
+// with out() pointed at a string: functions straight through the VM, builtins like any other
+// line and externals get started directly by the executor, which pumps their stdout into it
+std::string ScriptInterpreter::captureCommand(const std::string& cmd) {
+    // this can be in the middle of expanding into the shared buffer, what runs now expands
+    // lines of its own
+    std::string pending;
+    pending.swap(expansion);
+
+    ScriptProfiler::Span span(getProfiler(), ScriptProfiler::Category::SUBSTITUTION);
+    Tracer& tracer = getTracer();
+    if (tracer.active()) tracer.command(depth + 1, {}, 0, cmd);
+    std::ostringstream capture;
+    {
+        StreamScope scope(nullptr, &capture, nullptr);
+        auto words = functions.empty() ? std::vector<std::string>() : split_words(cmd);
+        auto itf = words.empty() ? functions.end() : functions.find(words[0]);
+        if (itf != functions.end()) {
+            (void)callFunction(words[0], itf->second, std::vector<std::string>(words.begin() + 1, words.end()));
+        } else {
 #ifdef _WIN32
-                        _pclose(pipe);
+            // the executor can't point an external at out() here yet, those still go through _popen
+            std::istringstream first(cmd);
+            std::string name;
+            first >> name;
+            if (!name.empty() && !getBuiltinRegistry().isBuiltin(name)) {
+                if (FILE* pipe = _popen(cmd.c_str(), "r")) {
+                    char buffer[512]; size_t n;
+                    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) capture.write(buffer, n);
+                    _pclose(pipe);
+                }
+            } else {
+                (void)runLine(cmd);
+            }
 #else
-                        pclose(pipe);
+            (void)runLine(cmd);
 #endif
-                    }
-                }
-                // trim trailing newlines
-                while(!val.empty() && (val.back()=='\n' || val.back()=='\r')) val.pop_back();
-                out += val;
-                i = j+1;
-                continue;
+        }
+        capture.flush();
+    }
+    expansion.swap(pending);
+
+    std::string val = capture.str();
+    while (!val.empty() && (val.back() == '\n' || val.back() == '\r')) val.pop_back();
+    return val;
+}
+
+// one pass over [from, to) of the text: plain runs are copied in bulk, $((...)) (compiled with
+// the text), $(command), `command`, $? $@ $# $N ${VAR} and $VAR are replaced as they come up.
+// what a substitution produces is never looked at again
+void ScriptInterpreter::expandInto(std::string& out,
+                                   const ScriptText& text,
+                                   size_t from,
+                                   size_t to,
+                                   int lastExitCode,
+                                   const std::vector<std::string>& args) {
+    std::string_view line = std::string_view(text.raw).substr(0, to);
+    auto arith = std::lower_bound(text.arith.begin(), text.arith.end(), from,
+                                  [](const ScriptArith& a, size_t at) { return a.begin < at; });
+
+    size_t i = from;
+    while (i < to) {
+        size_t next = findExpansion(line, i);
+        out.append(line, i, next - i);
+        i = next;
+        if (i >= to) break;
+
+        if (arith != text.arith.end() && arith->begin == i) {
+            char buffer[24];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), evalArithmetic(arith->expr, lastExitCode, args));
+            out.append(buffer, end);
+            i = arith->end;
+            ++arith;
+            continue;
+        }
+
+        // $(command) or `command`. the inside is expanded first, so a $(...) nested in it has
+        // already run and left its output by the time this one does. into its own string,
+        // running it can come back in here
+        char c = i + 1 < line.size() ? line[i+1] : '\0';
+        if (line[i] == '`' || c == '(') {
+            bool backtick = line[i] == '`';
+            size_t j = backtick ? closingBacktick(line, i + 1) : closingParen(line, i + 2);
+            if (j == std::string_view::npos) { out.push_back(line[i++]); continue; }
+            std::string cmd;
+            expandInto(cmd, text, i + (backtick ? 1 : 2), j, lastExitCode, args);
+            while (arith != text.arith.end() && arith->begin < j) ++arith;
+            out += captureCommand(cmd);
+            i = j + 1;
+            continue;
+        }
+
+        // $
+        if (c == '?') {
+            char buffer[16];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), lastExitCode);
+            out.append(buffer, end);
+            i += 2; continue;
+        }
+        if (c == '@') {
+            for (size_t k = 0; k < args.size(); ++k) { if (k) out += ' '; out += args[k]; }
+            i += 2; continue;
+        }
+        if (c == '#') { out += std::to_string(args.size()); i += 2; continue; }
+        // positional
+        if (std::isdigit((unsigned char)c)) {
+            size_t j = i + 1; size_t idx = 0;
+            while (j < line.size() && std::isdigit((unsigned char)line[j])) { idx = idx * 10 + (line[j] - '0'); j++; }
+            if (idx >= 1 && idx <= args.size()) out += args[idx-1];
+            i = j; continue;
+        }
+        // ${VAR}, ${arr[i]} ...
+        if (c == '{' && i + 2 < line.size()) {
+            size_t j = closingBrace(line, i + 2);
+            if (j != std::string_view::npos) {
+                expandBraced(out, text, i + 2, j, lastExitCode, args);
+                while (arith != text.arith.end() && arith->begin < j) ++arith;
+                i = j + 1; continue;
             }
         }
+        // $VAR_NAME
+        size_t j = i + 1;
+        while (j < line.size() && (std::isalnum((unsigned char)line[j]) || line[j] == '_')) j++;
+        if (j > i + 1) {
+            appendVariable(out, line.substr(i + 1, j - (i + 1)));
+            i = j; continue;
+        }
         out.push_back(line[i++]);
     }
-    return out;
-}
-
-std::string ScriptInterpreter::expandVariables(const std::string& line,
-                                               int lastExitCode,
-                                               const std::vector<std::string>& args) {
-    std::string out; out.reserve(line.size());
-    for (size_t i=0;i<line.size();){
-        if (line[i]=='$'){
-            // special cases: $? $@ $# $1..$9 and $VAR
-            if (i+1<line.size() && line[i+1]=='?') { out += std::to_string(lastExitCode); i+=2; continue; }
-            if (i+1<line.size() && line[i+1]=='@') {
-                std::string joined;
-                for (size_t k=0;k<args.size();++k){ if(k) joined+=' '; joined+=args[k]; }
-                out += joined; i+=2; continue;
+}
+
+namespace {
+    // end of the pattern in ${v/pattern/replacement}: the first / that isn't escaped or
+    // inside a nested ${...} or $(...)
+    size_t patternEnd(std::string_view s, size_t from, size_t to) {
+        int depth = 0;
+        for (size_t i = from; i < to; ++i) {
+            char c = s[i];
+            if (c == '\\') i++;
+            else if (c == '{' || c == '(') depth++;
+            else if ((c == '}' || c == ')') && depth > 0) depth--;
+            else if (c == '/' && depth == 0) return i;
+        }
+        return to;
+    }
+
+    void appendNumber(std::string& out, size_t n) {
+        char buffer[24];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), n);
+        out.append(buffer, end);
+    }
+}
+
+const GlobPattern& ScriptInterpreter::glob(const std::string& pattern) {
+    auto it = patterns.find(pattern);
+    if (it != patterns.end()) return it->second;
+    // patterns built from data that changes every time would pile up otherwise
+    if (patterns.size() >= MAX_PATTERNS) patterns.clear();
+    return patterns.emplace(pattern, GlobPattern(pattern)).first->second;
+}
+
+void ScriptInterpreter::expandBraced(std::string& out,
+                                     const ScriptText& text,
+                                     size_t from,
+                                     size_t to,
+                                     int lastExitCode,
+                                     const std::vector<std::string>& args) {
+    std::string_view inside = std::string_view(text.raw).substr(from, to - from);
+    auto bad = [&]() {
+        std::cerr << RED << "Script error: ${" << inside << "}: bad substitution" << RESET << std::endl;
+    };
+    auto expand = [&](std::string& into, size_t begin, size_t end) {
+        expandInto(into, text, begin, end, lastExitCode, args);
+    };
+    if (inside == "#") {
+        appendNumber(out, args.size());
+        return;
+    }
+
+    // ${#NAME} is a length, ${#NAME[@]} how many elements there are and ${!NAME[@]} their keys
+    char prefix = inside.size() > 1 && (inside[0] == '#' || inside[0] == '!') ? inside[0] : '\0';
+    size_t start = prefix ? 1 : 0;
+    size_t end = start;
+    while (end < inside.size() && (std::isalnum((unsigned char)inside[end]) || inside[end] == '_')) end++;
+    std::string_view name = inside.substr(start, end - start);
+    bool positional = !name.empty() && std::isdigit((unsigned char)name[0]);
+    if (name.empty() || (positional && name.find_first_not_of("0123456789") != std::string_view::npos)) {
+        bad();
+        return;
+    }
+    uint32_t symbol = positional ? SymbolTable::NONE : getSymbols().find(name);
+
+    std::string_view sub;
+    std::string expandedSub;
+    bool subscripted = !positional && end < inside.size() && inside[end] == '[';
+    if (subscripted) {
+        size_t close = end + 1;
+        for (int depth = 1; close < inside.size(); ++close) {
+            if (inside[close] == '[') depth++;
+            else if (inside[close] == ']' && --depth == 0) break;
+        }
+        if (close >= inside.size()) {
+            bad();
+            return;
+        }
+        sub = inside.substr(end + 1, close - end - 1);
+        if (sub.find_first_of("$`") != std::string_view::npos) {
+            expand(expandedSub, from + end + 1, from + close);
+            sub = expandedSub;
+        }
+        end = close + 1;
+    }
+    bool all = subscripted && (sub == "@" || sub == "*");
+    std::string_view op = inside.substr(end);
+    size_t operand = from + end; // where the operator starts in the raw text
+
+    // the value, and whether it's set at all (as opposed to empty)
+    auto fetch = [&](std::string& value) {
+        if (positional) {
+            size_t index = 0;
+            std::from_chars(name.data(), name.data() + name.size(), index);
+            if (index < 1 || index > args.size()) return false;
+            value += args[index - 1];
+            return true;
+        }
+        if (subscripted) {
+            appendElement(value, symbol, sub);
+            return !value.empty() || (all && findVariable(symbol));
+        }
+        if (!findVariable(symbol) && appendLastUsage(value, name)) return true;
+        appendVariable(value, name);
+        return findVariable(symbol) || std::getenv(std::string(name).c_str());
+    };
+    // what the operators below work on one at a time, every element for NAME[@]
+    auto values = [&]() {
+        std::vector<std::string> list;
+        if (all) {
+            list = arrayValues(symbol, false);
+        } else {
+            fetch(list.emplace_back());
+        }
+        return list;
+    };
+    auto join = [&](const std::vector<std::string>& list) {
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (i) out += ' ';
+            out += list[i];
+        }
+    };
+
+    if (prefix) {
+        if (!op.empty() || (prefix == '!' && !all)) {
+            bad();
+        } else if (prefix == '!') {
+            join(arrayValues(symbol, true));
+        } else if (all) {
+            const Variable* v = findVariable(symbol);
+            appendNumber(out, !v ? 0
+                            : v->type == Variable::Type::ARRAY ? v->items.size()
+                            : v->type == Variable::Type::ASSOC ? v->map.size()
+                            : 1);
+        } else {
+            // bytes, not characters
+            std::string value;
+            fetch(value);
+            appendNumber(out, value.size());
+        }
+        return;
+    }
+
+    if (op.empty()) {
+        fetch(out);
+        return;
+    }
+
+    char first = op[0];
+    char second = op.size() > 1 ? op[1] : '\0';
+
+    // ${v:-word} ${v-word} ${v:=word} ${v=word} ${v:+word} ${v+word}. the word is only
+    // expanded when it's used, a $(...) in it doesn't run otherwise
+    bool colon = first == ':' && (second == '-' || second == '=' || second == '+');
+    if (colon || first == '-' || first == '=' || first == '+') {
+        char kind = colon ? second : first;
+        size_t word = operand + (colon ? 2 : 1);
+        std::string value;
+        bool set = fetch(value);
+        bool stands = set && (!colon || !value.empty());
+        if (kind == '+') {
+            if (stands) expand(out, word, to);
+        } else if (stands) {
+            out += value;
+        } else {
+            std::string fallback;
+            expand(fallback, word, to);
+            if (kind == '=') {
+                if (positional || subscripted) {
+                    std::cerr << RED << "Script error: ${" << inside << "}: can't assign this way" << RESET << std::endl;
+                } else {
+                    setVariable(getSymbols().intern(name), fallback);
+                }
             }
-            if (i+1<line.size() && line[i+1]=='#') { out += std::to_string(args.size()); i+=2; continue; }
-            // positional
-            if (i+1<line.size() && std::isdigit((unsigned char)line[i+1])){
-                size_t j=i+1; int idx = 0; while(j<line.size() && std::isdigit((unsigned char)line[j])){ idx = idx*10 + (line[j]-'0'); j++; }
-                if (idx>=1 && (size_t)idx <= args.size()) out += args[idx-1];
-                i = j; continue;
+            out += fallback;
+        }
+        return;
+    }
+
+    // ${v#pattern} ${v##pattern} ${v%pattern} ${v%%pattern}, shortest and longest match
+    if (first == '#' || first == '%') {
+        bool longest = second == first;
+        std::string source;
+        expand(source, operand + (longest ? 2 : 1), to);
+        const GlobPattern& pattern = glob(source);
+        auto list = values();
+        for (std::string& value : list) {
+            if (first == '#') {
+                size_t n = pattern.prefix(value, longest);
+                if (n != std::string_view::npos) value.erase(0, n);
+            } else {
+                size_t n = pattern.suffix(value, longest);
+                if (n != std::string_view::npos) value.resize(n);
             }
-            // ${VAR}
-            if (i+2<line.size() && line[i+1]=='{' ){
-                size_t j=i+2; while(j<line.size() && line[j] != '}') j++;
-                if (j<line.size()){
-                    std::string name = line.substr(i+2, j-(i+2));
-                    std::string val;
-                    auto it = variables.find(name);
-                    if (it != variables.end()) val = it->second; else {
-                        const char* env = std::getenv(name.c_str()); if(env) val = env;
-                    }
-                    out += val; i = j+1; continue;
+        }
+        join(list);
+        return;
+    }
+
+    // ${v/pattern/replacement}, // for every match, /# and /% for one at the start or end
+    if (first == '/') {
+        bool every = second == '/';
+        char anchor = second == '#' || second == '%' ? second : '\0';
+        size_t begin = operand + (every || anchor ? 2 : 1);
+        size_t slash = patternEnd(text.raw, begin, to);
+        std::string source, replacement;
+        expand(source, begin, slash);
+        if (slash < to) expand(replacement, slash + 1, to);
+        const GlobPattern& pattern = glob(source);
+        auto list = values();
+        for (std::string& value : list) {
+            if (anchor == '#') {
+                size_t n = pattern.prefix(value, true);
+                if (n != std::string_view::npos) value.replace(0, n, replacement);
+            } else if (anchor == '%') {
+                size_t n = pattern.suffix(value, true);
+                if (n != std::string_view::npos) value.replace(n, std::string::npos, replacement);
+            } else {
+                std::string result;
+                size_t pos = 0, at = 0, length = 0;
+                while (pattern.find(value, pos, at, length)) {
+                    result.append(value, pos, at - pos);
+                    result += replacement;
+                    pos = at + length;
+                    if (!every) break;
                 }
+                if (pos == 0 && result.empty()) continue;
+                result.append(value, pos, std::string::npos);
+                value = std::move(result);
             }
-            // $VAR_NAME
-            size_t j=i+1; while(j<line.size() && (std::isalnum((unsigned char)line[j]) || line[j]=='_' )) j++;
-            if (j>i+1){
-                std::string name = line.substr(i+1, j-(i+1));
-                std::string val;
-                auto it = variables.find(name);
-                if (it != variables.end()) val = it->second; else { const char* env = std::getenv(name.c_str()); if(env) val=env; }
-                out += val; i = j; continue;
+        }
+        join(list);
+        return;
+    }
+
+    // ${v^} ${v^^} ${v,} ${v,,}, only the chars matching a pattern when there's one
+    if (first == '^' || first == ',') {
+        bool every = second == first;
+        std::string source;
+        expand(source, operand + (every ? 2 : 1), to);
+        const GlobPattern* pattern = source.empty() ? nullptr : &glob(source);
+        auto list = values();
+        for (std::string& value : list) {
+            for (size_t i = 0; i < value.size() && (every || i == 0); ++i) {
+                if (pattern && !pattern->matches(std::string_view(&value[i], 1))) continue;
+                value[i] = first == '^' ? (char)std::toupper((unsigned char)value[i])
+                                        : (char)std::tolower((unsigned char)value[i]);
             }
         }
-        out.push_back(line[i++]);
+        join(list);
+        return;
+    }
+
+    // ${v:offset} ${v:offset:length}, both arithmetic, negative counts from the end. on
+    // NAME[@] they pick elements
+    if (first == ':') {
+        std::string spec;
+        expand(spec, operand + 1, to);
+        size_t split = spec.find(':');
+        long long offset = 0, length = 0;
+        bool limited = split != std::string::npos;
+        if (!arithmeticValue(std::string_view(spec).substr(0, split), offset) ||
+            (limited && !arithmeticValue(std::string_view(spec).substr(split + 1), length))) {
+            bad();
+            return;
+        }
+        auto range = [&](size_t size, size_t& begin, size_t& count) {
+            long long b = offset < 0 ? (long long)size + offset : offset;
+            if (b < 0 || b > (long long)size) return false;
+            long long e = !limited ? (long long)size : length < 0 ? (long long)size + length : b + length;
+            begin = (size_t)b;
+            count = e > b ? (size_t)std::min<long long>(e, (long long)size) - begin : 0;
+            return true;
+        };
+        size_t begin = 0, count = 0;
+        if (all) {
+            auto list = arrayValues(symbol, false);
+            if (!range(list.size(), begin, count)) return;
+            join(std::vector<std::string>(list.begin() + (long)begin, list.begin() + (long)(begin + count)));
+        } else {
+            std::string value;
+            fetch(value);
+            if (range(value.size(), begin, count)) out.append(value, begin, count);
+        }
+        return;
     }
-    return out;
+
+    bad();
 }
 
-std::string ScriptInterpreter::expandLine(const std::string& input,
-                                          int lastExitCode,
-                                          const std::vector<std::string>& args) {
-    // order: arithmetic, backticks, variables
-    std::string s = expandArithmetic(input);
-    s = substituteBackticks(s, lastExitCode, args);
-    s = expandVariables(s, lastExitCode, args);
-    return s;
+const std::string& ScriptInterpreter::expandLine(const ScriptText& text,
+                                                 int lastExitCode,
+                                                 const std::vector<std::string>& args) {
+    // most lines have nothing to expand, the compiler already checked
+    if (text.plain) return text.raw;
+
+    ScriptProfiler::Span span(getProfiler(), ScriptProfiler::Category::EXPANSION);
+    expansion.clear();
+    expandInto(expansion, text, 0, text.raw.size(), lastExitCode, args);
+    return expansion;
 }
 
 bool ScriptInterpreter::evalCondition(const std::string& condRaw,
@@ -294,226 +1254,250 @@ bool ScriptInterpreter::evalCondition(const std::string& condRaw,
     return false;
 }
 
-// core executor for a set of lines
-int ScriptInterpreter::executeBlock(const std::vector<std::string>& lines,
-                                    std::vector<std::string> args,
-                                    int depth) {
-    int lastExitCode = 0;
-    for (size_t idx=0; idx<lines.size(); ++idx){
-        std::string raw = trim(lines[idx]);
-        if (raw.empty()) continue;
-        if (raw[0]=='#') continue;
-
-        // function definition
-        if (starts_with(raw, "function ")){
-            auto rest = trim(raw.substr(9));
-            // format: name {  or name{ on same line
-            std::string name; size_t pos = rest.find('{');
-            if (pos != std::string::npos){ name = trim(rest.substr(0,pos)); }
-            else { name = trim(rest); }
-            // collect body until closing '}'
-            std::vector<std::string> body;
-            if (pos != std::string::npos && pos+1 < rest.size()){
-                std::string after = trim(rest.substr(pos+1));
-                if (!after.empty()) body.push_back(after);
-            }
-            int brace=1;
-            while (++idx < lines.size()){
-                std::string ln = lines[idx];
-                for(char c: ln){ if(c=='{') brace++; else if(c=='}') brace--; }
-                // strip trailing '}' if present
-                std::string lntrim = ln;
-                if (!lntrim.empty() && lntrim.back()=='}'){
-                    // remove last closing brace
-                    size_t cut = lntrim.find_last_of('}');
-                    lntrim = trim(lntrim.substr(0, cut));
-                }
-                if (!lntrim.empty()) body.push_back(lntrim);
-                if (brace==0) break;
-            }
-            functions[name] = FunctionDef{body};
-            continue;
-        }
+// the VM. control flow was resolved by the compiler, all that's left per instruction is
+// expanding its text and doing the one thing it says
+int ScriptInterpreter::execute(const std::shared_ptr<const ScriptProgram>& program,
+                               uint32_t chunk,
+                               const std::vector<std::string>& args,
+                               Frame* frame,
+                               int status) {
+    if (depth > MAX_DEPTH) {
+        std::cerr << RED << "Script error: functions nested deeper than " << MAX_DEPTH << RESET << std::endl;
+        return 1;
+    }
+    // calls from substitutions count as well, they nest on the same stack
+    struct Nesting {
+        int& depth;
+        explicit Nesting(int& d) : depth(d) { depth++; }
+        ~Nesting() { depth--; }
+    } nesting(depth);
 
-        // expand line for substitution before control structure parsing
-        std::string line = expandLine(raw, lastExitCode, args);
+    const auto& code = program->chunks[chunk].code;
+    const auto& texts = program->texts;
 
-        // set builtin: set VAR = value
-        if (starts_with(line, "set ")){
-            std::string rest = trim(line.substr(4));
-            size_t eq = rest.find('=');
-            if (eq != std::string::npos){
-                std::string var = trim(rest.substr(0, eq));
-                std::string val = trim(rest.substr(eq+1));
-                variables[var] = val;
-            }
-            continue;
+    // while profiling, every instruction but a jump is a reading of the clock. the chunk is
+    // entered at its first one, set -o profile can turn it on halfway through
+    ScriptProfiler& profiler = getProfiler();
+    Tracer& tracer = getTracer();
+    struct Profiled {
+        ScriptProfiler& profiler;
+        ScriptProfiler::Cursor cursor;
+        ~Profiled() { if (cursor.lines) profiler.leave(cursor); }
+    } profiled{profiler, {}};
+
+    // values of the for loops currently running in this chunk, innermost last
+    struct ForLoop {
+        std::vector<std::string> values;
+        size_t next = 0;
+    };
+    std::vector<ForLoop> loops;
+
+    // done < FILE loops this chunk opened, closed on the way out if it never gets to their end
+    struct OpenInputs {
+        ScriptInterpreter& interpreter;
+        size_t count = 0;
+        ~OpenInputs() { for (; count; count--) interpreter.closeInput(); }
+    } opened{*this};
+
+    int lastExitCode = status;
+    size_t pc = 0;
+    while (pc < code.size()) {
+        const ScriptInstruction& ins = code[pc++];
+        if (profiler.active() && ins.op != ScriptOp::JUMP) {
+            if (!profiled.cursor.lines) profiler.enter(profiled.cursor, program->name);
+            profiler.step(profiled.cursor, ins.line);
         }
+        switch (ins.op) {
+            case ScriptOp::RUN: {
+                const std::string& line = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) trace(*program, ins, line);
 
-        // if/elif/else/fi handling: collect whole if block starting at current idx
-        if (starts_with(raw, "if ") || starts_with(raw, "if[")){
-            // accumulate lines until 'fi'
-            std::vector<std::pair<std::string, std::vector<std::string>>> branches; // (cond or "else", body)
-            std::string currentCond = trim(raw);
-            std::vector<std::string> currentBody;
-            bool inThen = false;
-            // If line contains 'then', split
-            auto handleThenSplit = [&](const std::string& l){
-                size_t th = l.find("then");
-                if (th != std::string::npos){
-                    inThen = true; return trim(l.substr(th+4));
-                }
-                return std::string();
-            };
-            std::string remainder = handleThenSplit(raw);
-            if (!remainder.empty()) currentBody.push_back(remainder);
-            while (++idx < lines.size()){
-                std::string l = trim(lines[idx]);
-                if (l == "fi") break;
-                if (starts_with(l, "elif ")){
-                    // push previous branch
-                    branches.push_back({currentCond, currentBody});
-                    currentCond = l; currentBody.clear(); inThen=false;
-                    remainder = handleThenSplit(l);
-                    if (!remainder.empty()) currentBody.push_back(remainder);
-                    continue;
+                // function call?
+                auto words = functions.empty() ? std::vector<std::string>() : split_words(line);
+                if (!words.empty()) {
+                    auto itf = functions.find(words[0]);
+                    if (itf != functions.end()) {
+                        lastExitCode = callFunction(words[0], itf->second, std::vector<std::string>(words.begin() + 1, words.end()));
+                        break;
+                    }
                 }
-                if (l == "else"){
-                    branches.push_back({currentCond, currentBody});
-                    currentCond = "else"; currentBody.clear(); inThen=true; continue;
+                if (&line != &expansion) {
+                    lastExitCode = runLine(line);
+                    break;
                 }
-                std::string r = l;
-                if (!inThen){ r = handleThenSplit(l); if (r.empty()) continue; }
-                currentBody.push_back(r);
+                // the command can expand lines of its own (a script, time ...), the buffer goes
+                // along with it and comes back afterwards
+                std::string taken;
+                taken.swap(expansion);
+                lastExitCode = runLine(taken);
+                if (taken.capacity() > expansion.capacity()) expansion.swap(taken);
+                break;
             }
-            branches.push_back({currentCond, currentBody});
-
-            // evaluate branches
-            bool executed=false; int rc=0;
-            for (auto& [condLine, body] : branches){
-                if (condLine=="else"){
-                    rc = executeBlock(body, args, depth+1); executed=true; break;
-                }
-                // condition text between if and then
-                std::string condText = condLine;
-                if (starts_with(condText, "if ")) condText = trim(condText.substr(3));
-                // remove trailing ; if any
-                if (!condText.empty() && condText.back()==';') condText.pop_back();
-                // expand and evaluate
-                condText = expandLine(condText, lastExitCode, args);
-                if (evalCondition(condText, lastExitCode, args)){
-                    rc = executeBlock(body, args, depth+1); executed=true; break;
+            case ScriptOp::SET: {
+                // set VAR = value
+                std::string_view rest = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) trace(*program, ins, "set", rest);
+                size_t eq = rest.find('=');
+                if (eq != std::string_view::npos && assign(trimView(rest.substr(0, eq)), std::string(trimView(rest.substr(eq + 1))), "set")) {
+                    lastExitCode = 1;
                 }
+                break;
             }
-            lastExitCode = rc;
-            continue;
-        }
-
-        // while loop: while [ condition ]; do ... done
-        if (starts_with(raw, "while ")){
-            // gather body until done
-            std::string header = raw; // may include ; do
-            std::vector<std::string> body;
-            bool haveDo = header.find(" do") != std::string::npos || ends_with(header, ";do") || ends_with(header, "; do");
-            if (haveDo){
-                size_t p = header.find("do");
-                if (p!=std::string::npos){ std::string after = trim(header.substr(p+2)); if(!after.empty()) body.push_back(after); header = trim(header.substr(0,p)); }
-            } else {
-                // scan lines to find a 'do' line; leave idx on that line
-                while (idx + 1 < lines.size()){
-                    std::string l = trim(lines[idx+1]);
-                    if (l == "do") { idx += 1; haveDo = true; break; }
-                    idx += 1; // skip intervening lines if any (unlikely)
+            case ScriptOp::LOCAL:
+            case ScriptOp::EXPORT:
+            case ScriptOp::DECLARE: {
+                const std::string& text = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) {
+                    trace(*program, ins, ins.op == ScriptOp::EXPORT ? "export" : ins.op == ScriptOp::LOCAL ? "local" : "declare", text);
                 }
+                lastExitCode = declare(text, ins.op, frame);
+                break;
             }
-            // now collect body until done, starting after current idx
-            while (idx + 1 < lines.size()){
-                std::string l = lines[idx+1];
-                if (trim(l) == "done") { idx += 1; break; }
-                body.push_back(l);
-                idx += 1;
+            case ScriptOp::ARITH:
+                if (tracer.active()) trace(*program, ins, "((", program->exprSources[ins.a] + " ))");
+                lastExitCode = evalArithmetic(program->exprs[ins.a], lastExitCode, args) != 0 ? 0 : 1;
+                break;
+            case ScriptOp::JUMP:
+                pc = ins.b;
+                break;
+            case ScriptOp::JUMP_UNLESS_ARITH:
+                if (tracer.active()) trace(*program, ins, "((", program->exprSources[ins.a] + " ))");
+                if (evalArithmetic(program->exprs[ins.a], lastExitCode, args) == 0) pc = ins.b;
+                break;
+            case ScriptOp::JUMP_UNLESS: {
+                const std::string& cond = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) trace(*program, ins, cond);
+                if (!evalCondition(cond, lastExitCode, args)) pc = ins.b;
+                break;
             }
-            // condition text between while and (optional) ; do
-            std::string condText = trim(header.substr(6));
-            int rc = 0;
-            while (true){
-                std::string expandedCond = expandLine(condText, lastExitCode, args);
-                if (!evalCondition(expandedCond, lastExitCode, args)) break;
-                rc = executeBlock(body, args, depth+1);
-                lastExitCode = rc;
+            case ScriptOp::FOR_BEGIN: {
+                const std::string& list = expandLine(texts[ins.a], lastExitCode, args);
+                // the loop's FOR_NEXT comes right after, with the name
+                if (tracer.active()) trace(*program, ins, "for " + getSymbols().name(code[pc].a) + " in", list);
+                loops.push_back({split_words(list)});
+                break;
             }
-            continue;
-        }
-
-        // for loop: for VAR in list; do ... done
-        if (starts_with(raw, "for ")){
-            std::string header = raw;
-            std::vector<std::string> body;
-            bool haveDo = header.find(" do") != std::string::npos || ends_with(header, ";do") || ends_with(header, "; do");
-            if (haveDo){ size_t p=header.find("do"); if(p!=std::string::npos){ std::string after=trim(header.substr(p+2)); if(!after.empty()) body.push_back(after); header=trim(header.substr(0,p)); } }
-            else {
-                while (idx + 1 < lines.size()){
-                    std::string l = trim(lines[idx+1]);
-                    if (l == "do") { idx += 1; haveDo = true; break; }
-                    idx += 1;
+            case ScriptOp::FOR_ARRAY: {
+                loops.push_back({arrayValues(ins.a, ins.b != 0)});
+                if (tracer.active()) {
+                    std::string list;
+                    for (const std::string& value : loops.back().values) (list += value) += ' ';
+                    if (!list.empty()) list.pop_back();
+                    trace(*program, ins, "for " + getSymbols().name(code[pc].a) + " in", list);
                 }
+                break;
             }
-            while (idx + 1 < lines.size()){
-                std::string l = lines[idx+1];
-                if (trim(l) == "done") { idx += 1; break; }
-                body.push_back(l);
-                idx += 1;
+            case ScriptOp::FOR_NEXT: {
+                ForLoop& loop = loops.back();
+                if (loop.next < loop.values.size()) {
+                    setVariable(ins.a, loop.values[loop.next++]);
+                } else {
+                    loops.pop_back();
+                    pc = ins.b;
+                }
+                break;
             }
-            // parse header: for VAR in LIST
-            std::string hdr = trim(header.substr(4));
-            auto parts = split_words(expandLine(hdr, lastExitCode, args));
-            if (parts.size() >= 3 && parts[1]=="in"){
-                std::string varName = parts[0];
-                std::vector<std::string> list(parts.begin()+2, parts.end());
-                int rc = 0;
-                for (const auto& val : list){ variables[varName] = val; rc = executeBlock(body, args, depth+1); lastExitCode = rc; }
+            case ScriptOp::FUNCTION:
+                functions[texts[ins.a].raw] = FunctionDef{program, ins.b};
+                break;
+            case ScriptOp::STATUS:
+                lastExitCode = (int)ins.a;
+                break;
+            case ScriptOp::READ: {
+                const std::string& text = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) trace(*program, ins, "read", text);
+                lastExitCode = read(text);
+                break;
             }
-            continue;
-        }
-
-        // function call?
-        {
-            auto words = split_words(line);
-            if (!words.empty()){
-                auto itf = functions.find(words[0]);
-                if (itf != functions.end()){
-                    std::vector<std::string> fargs;
-                    if (words.size()>1) fargs.assign(words.begin()+1, words.end());
-                    // save and set positional args
-                    int rc = executeBlock(itf->second.body, fargs, depth+1);
-                    lastExitCode = rc;
-                    continue;
+            case ScriptOp::JUMP_UNLESS_OK:
+                if (lastExitCode != 0) pc = ins.b;
+                break;
+            case ScriptOp::INPUT_BEGIN: {
+                const std::string& file = expandLine(texts[ins.a], lastExitCode, args);
+                if (tracer.active()) trace(*program, ins, "<", file);
+                auto words = split_words(file);
+                if (openInput(words.empty() ? std::string() : words[0])) {
+                    opened.count++;
+                } else {
+                    lastExitCode = 1;
+                    pc = ins.b;
                 }
+                break;
             }
-        }
-
-        // normal command
-        try {
-            lastExitCode = shell->processCommand(line);
-        } catch (const std::exception& e) {
-            std::cerr << RED << "Script error: " << e.what() << RESET << std::endl;
-            lastExitCode = 1;
+            case ScriptOp::INPUT_END:
+                opened.count--;
+                closeInput();
+                break;
         }
     }
     return lastExitCode;
 }
 
-int ScriptInterpreter::executeLines(std::istringstream& stream,
-                                    std::vector<std::string> args,
-                                    int depth) {
-    std::string line;
-    std::vector<std::string> lines;
-    while (std::getline(stream, line)){
-        // skip shebang
-        if (lines.empty() && starts_with(line, "#!")) continue;
-        lines.push_back(line);
+// copied, the function may redefine itself while it runs
+int ScriptInterpreter::callFunction(const std::string& name, FunctionDef function,
+                                    const std::vector<std::string>& args) {
+    ScriptProfiler& profiler = getProfiler();
+    bool profiled = profiler.active();
+    if (profiled) profiler.enterFunction(name);
+    Frame call;
+    int status = execute(function.program, function.chunk, args, &call);
+    leave(call);
+    if (profiled) profiler.leaveFunction();
+    return status;
+}
+
+void ScriptInterpreter::trace(const ScriptProgram& program, const ScriptInstruction& ins, std::string_view text) {
+    getTracer().command(depth, program.name, ins.line, text);
+}
+
+void ScriptInterpreter::trace(const ScriptProgram& program, const ScriptInstruction& ins,
+                              std::string_view word, std::string_view text) {
+    std::string line(word);
+    line += ' ';
+    line += text;
+    trace(program, ins, line);
+}
+
+// normal command
+int ScriptInterpreter::runLine(const std::string& line) {
+    // set -x has shown it already, the shell doesn't have to again
+    Tracer& tracer = getTracer();
+    if (tracer.active()) tracer.traced();
+    try {
+        return shell->processCommand(line);
+    } catch (const std::exception& e) {
+        std::cerr << RED << "Script error: " << e.what() << RESET << std::endl;
+        return 1;
+    }
+}
+
+// every top-level statement runs as soon as it's compiled, before the next one is read
+int ScriptInterpreter::run(ScriptStream& stream,
+                           const std::string& name,
+                           const std::vector<std::string>& args,
+                           ScriptCache::Statements* compiled) {
+    ProfiledScript profiled;
+    std::shared_ptr<ScriptProgram> program;
+    ScriptSyntaxError error;
+    int status = 0;
+    while (true) {
+        // a statement that defined a function left its program to the function,
+        // otherwise the last one is reused
+        if (!program || program.use_count() > 1) {
+            program = std::make_shared<ScriptProgram>();
+            program->name = name;
+        }
+        if (!stream.next(*program, error)) break;
+        if (compiled) compiled->push_back(program);
+        status = execute(program, 0, args, nullptr, status);
+    }
+
+    if (!error.message.empty()) {
+        if (compiled) compiled->clear(); // only a script that compiled all the way is worth keeping
+        std::cerr << RED << "Error: " << name << ": line " << error.line << ": syntax error: " << error.message << RESET << std::endl;
+        return 2;
     }
-    return executeBlock(lines, std::move(args), depth);
+    return status;
 }
 
 }
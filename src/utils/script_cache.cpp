@@ -0,0 +1,409 @@
+#include "../../include/utils/script_cache.h"
+#include "../../include/utils/mapped_file.h"
+#include "../../include/utils/symbols.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace olsh::Utils {
+
+namespace {
+    constexpr std::string_view MAGIC = "OLSC";
+
+    // entries are only read back on the machine that wrote them, numbers go in as they are in memory
+    class Writer {
+    public:
+        std::string bytes;
+        std::vector<uint32_t> symbols; // ids of this process in the order the entry numbers them
+
+        template <typename T>
+        void put(T value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+        void text(std::string_view s) {
+            put<uint32_t>((uint32_t)s.size());
+            bytes.append(s);
+        }
+
+        // symbol ids only mean something in this process, the entry has its own numbering
+        uint32_t symbol(uint32_t id) {
+            auto [it, added] = numbers.try_emplace(id, (uint32_t)symbols.size());
+            if (added) symbols.push_back(id);
+            return it->second;
+        }
+
+    private:
+        std::unordered_map<uint32_t, uint32_t> numbers;
+    };
+
+    // every read is bounds checked, a truncated or garbled entry is a miss and not a crash
+    class Reader {
+    public:
+        std::vector<uint32_t> symbols; // entry numbering -> ids of this process
+
+        explicit Reader(std::string_view data) : s(data) {}
+
+        template <typename T>
+        bool get(T& value) {
+            if (s.size() - at < sizeof(T)) return false;
+            std::memcpy(&value, s.data() + at, sizeof(T));
+            at += sizeof(T);
+            return true;
+        }
+
+        bool text(std::string& out) {
+            uint32_t size = 0;
+            if (!get(size) || s.size() - at < size) return false;
+            out.assign(s.substr(at, size));
+            at += size;
+            return true;
+        }
+
+        // a count of things at least each bytes big, so a bad one can't make us allocate gigabytes
+        bool count(uint32_t& n, size_t each) {
+            return get(n) && (uint64_t)n * each <= s.size() - at;
+        }
+
+        bool symbol(uint32_t& id) {
+            if (id >= symbols.size()) return false;
+            id = symbols[id];
+            return true;
+        }
+
+        bool finished() const { return at == s.size(); }
+
+    private:
+        std::string_view s;
+        size_t at = 0;
+    };
+
+    // names the entries and checks them, hash carries on from an earlier piece
+    uint64_t fnv1a(std::string_view s, uint64_t hash = 1469598103934665603ULL) {
+        for (unsigned char c : s) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+// ArithExpr's nodes are private, this is the one other thing that needs them
+struct ArithCodec {
+    using Op = ArithExpr::Op;
+
+    static int arity(Op op) {
+        switch (op) {
+            case Op::NUMBER: case Op::VARIABLE: case Op::POSITIONAL: case Op::ARG_COUNT: case Op::STATUS:
+                return 0;
+            case Op::NEGATE: case Op::NOT: case Op::BIT_NOT:
+            case Op::PRE_INC: case Op::PRE_DEC: case Op::POST_INC: case Op::POST_DEC:
+                return 1;
+            case Op::TERNARY:
+                return 3;
+            default:
+                return 2;
+        }
+    }
+
+    static void save(Writer& w, const ArithExpr& expr) {
+        w.put<uint32_t>(expr.root);
+        w.put<uint32_t>((uint32_t)expr.nodes.size());
+        for (const auto& node : expr.nodes) {
+            w.put<uint8_t>((uint8_t)node.op);
+            w.put<uint8_t>((uint8_t)node.combine);
+            w.put<uint32_t>(node.lhs);
+            w.put<uint32_t>(node.rhs);
+            w.put<uint32_t>(node.third);
+            w.put<int64_t>(node.op == Op::VARIABLE ? w.symbol((uint32_t)node.value) : node.value);
+        }
+    }
+
+    static bool load(Reader& r, ArithExpr& expr) {
+        uint32_t count = 0;
+        if (!r.get(expr.root) || !r.count(count, 22)) return false;
+        if (count > 0 && expr.root >= count) return false;
+        expr.nodes.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto& node = expr.nodes[i];
+            uint8_t op = 0, combine = 0;
+            int64_t value = 0;
+            if (!r.get(op) || !r.get(combine) || !r.get(node.lhs) || !r.get(node.rhs) ||
+                !r.get(node.third) || !r.get(value)) return false;
+            if (op > (uint8_t)Op::COMMA || combine > (uint8_t)Op::COMMA) return false;
+            node.op = (Op)op;
+            node.combine = (Op)combine;
+            node.value = value;
+            // the compiler always adds children before their parent, anything else could loop
+            int children = arity(node.op);
+            if ((children > 0 && node.lhs >= i) || (children > 1 && node.rhs >= i) ||
+                (children > 2 && node.third >= i)) return false;
+            if (node.op == Op::VARIABLE) {
+                uint32_t symbol = (uint32_t)value;
+                if (value < 0 || !r.symbol(symbol)) return false;
+                node.value = symbol;
+            }
+            bool assigns = node.op == Op::ASSIGN || node.op == Op::PRE_INC || node.op == Op::PRE_DEC ||
+                           node.op == Op::POST_INC || node.op == Op::POST_DEC;
+            if (assigns && expr.nodes[node.lhs].op != Op::VARIABLE) return false;
+        }
+        return true;
+    }
+};
+
+namespace {
+    void saveProgram(Writer& w, const ScriptProgram& program) {
+        w.put<uint32_t>((uint32_t)program.texts.size());
+        for (const auto& text : program.texts) {
+            w.text(text.raw);
+            w.put<uint8_t>(text.plain);
+            w.put<uint32_t>((uint32_t)text.arith.size());
+            for (const auto& arith : text.arith) {
+                w.put<uint64_t>(arith.begin);
+                w.put<uint64_t>(arith.end);
+                ArithCodec::save(w, arith.expr);
+            }
+        }
+        w.put<uint32_t>((uint32_t)program.exprs.size());
+        for (size_t i = 0; i < program.exprs.size(); ++i) {
+            w.text(program.exprSources[i]);
+            ArithCodec::save(w, program.exprs[i]);
+        }
+        w.put<uint32_t>((uint32_t)program.chunks.size());
+        for (const auto& chunk : program.chunks) {
+            w.put<uint32_t>((uint32_t)chunk.code.size());
+            for (const auto& ins : chunk.code) {
+                w.put<uint8_t>((uint8_t)ins.op);
+                w.put<uint32_t>(ins.op == ScriptOp::FOR_NEXT || ins.op == ScriptOp::FOR_ARRAY ? w.symbol(ins.a) : ins.a);
+                w.put<uint32_t>(ins.b);
+                w.put<uint32_t>(ins.line);
+            }
+        }
+    }
+
+    // whatever an instruction points at has to be there, the VM doesn't check again
+    bool valid(const ScriptProgram& program) {
+        for (const auto& text : program.texts) {
+            for (const auto& arith : text.arith) {
+                if (arith.begin >= arith.end || arith.end > text.raw.size()) return false;
+            }
+        }
+        for (const auto& chunk : program.chunks) {
+            size_t size = chunk.code.size();
+            for (const auto& ins : chunk.code) {
+                switch (ins.op) {
+                    case ScriptOp::RUN:
+                    case ScriptOp::SET:
+                    case ScriptOp::LOCAL:
+                    case ScriptOp::EXPORT:
+                    case ScriptOp::FOR_BEGIN:
+                    case ScriptOp::READ:
+                    case ScriptOp::DECLARE:
+                        if (ins.a >= program.texts.size()) return false;
+                        break;
+                    case ScriptOp::ARITH:
+                        if (ins.a >= program.exprs.size()) return false;
+                        break;
+                    case ScriptOp::JUMP:
+                    case ScriptOp::FOR_NEXT:
+                    case ScriptOp::JUMP_UNLESS_OK:
+                        if (ins.b > size) return false;
+                        break;
+                    case ScriptOp::JUMP_UNLESS:
+                    case ScriptOp::INPUT_BEGIN:
+                        if (ins.a >= program.texts.size() || ins.b > size) return false;
+                        break;
+                    case ScriptOp::JUMP_UNLESS_ARITH:
+                        if (ins.a >= program.exprs.size() || ins.b > size) return false;
+                        break;
+                    case ScriptOp::FUNCTION:
+                        if (ins.a >= program.texts.size() || ins.b == 0 || ins.b >= program.chunks.size()) return false;
+                        break;
+                    case ScriptOp::STATUS:
+                    case ScriptOp::INPUT_END:
+                        break;
+                    case ScriptOp::FOR_ARRAY:
+                        if (ins.b > 1) return false;
+                        break;
+                    default:
+                        return false;
+                }
+            }
+        }
+        return !program.chunks.empty();
+    }
+
+    bool loadProgram(Reader& r, ScriptProgram& program) {
+        uint32_t count = 0;
+        if (!r.count(count, 9)) return false;
+        program.texts.resize(count);
+        for (auto& text : program.texts) {
+            uint8_t plain = 0;
+            uint32_t arithCount = 0;
+            if (!r.text(text.raw) || !r.get(plain) || !r.count(arithCount, 24)) return false;
+            text.plain = plain != 0;
+            text.arith.resize(arithCount);
+            for (auto& arith : text.arith) {
+                uint64_t begin = 0, end = 0;
+                if (!r.get(begin) || !r.get(end) || !ArithCodec::load(r, arith.expr)) return false;
+                arith.begin = begin;
+                arith.end = end;
+            }
+        }
+
+        if (!r.count(count, 12)) return false;
+        program.exprs.resize(count);
+        program.exprSources.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!r.text(program.exprSources[i]) || !ArithCodec::load(r, program.exprs[i])) return false;
+        }
+
+        if (!r.count(count, 4)) return false;
+        program.chunks.resize(count);
+        for (auto& chunk : program.chunks) {
+            if (!r.count(count, 13)) return false;
+            chunk.code.resize(count);
+            for (auto& ins : chunk.code) {
+                uint8_t op = 0;
+                if (!r.get(op) || !r.get(ins.a) || !r.get(ins.b) || !r.get(ins.line)) return false;
+                if (op > (uint8_t)ScriptOp::DECLARE) return false;
+                ins.op = (ScriptOp)op;
+                if ((ins.op == ScriptOp::FOR_NEXT || ins.op == ScriptOp::FOR_ARRAY) && !r.symbol(ins.a)) return false;
+            }
+        }
+        return valid(program);
+    }
+}
+
+ScriptCache::ScriptCache() {
+    const char* setting = std::getenv("OLSH_SCRIPT_CACHE");
+    if (setting && std::strcmp(setting, "0") == 0) return;
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+    if (home) directory = std::string(home) + "\\.olshell\\scripts";
+#else
+    const char* home = std::getenv("HOME");
+    if (home) directory = std::string(home) + "/.olshell/scripts";
+#endif
+}
+
+bool ScriptCache::keyFor(const std::string& path, Key& key) {
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    if (ec) return false;
+    key.size = std::filesystem::file_size(absolute, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(absolute, ec);
+    if (ec) return false;
+    key.mtime = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    key.path = absolute.lexically_normal().string();
+    return true;
+}
+
+std::string ScriptCache::entryPath(const Key& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.olc", (unsigned long long)fnv1a(key.path));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool ScriptCache::load(const Key& key, const std::string& name, Statements& statements) const {
+    if (!enabled()) return false;
+    MappedFile file;
+    if (!file.open(entryPath(key))) return false;
+    std::string_view data = file.data();
+    if (data.substr(0, MAGIC.size()) != MAGIC) return false;
+    Reader r(data.substr(MAGIC.size()));
+
+    // a flipped byte could still make a program that loads, just not the one that was stored
+    uint64_t checksum = 0;
+    if (!r.get(checksum) || checksum != fnv1a(data.substr(MAGIC.size() + sizeof(checksum)))) return false;
+
+    // a different script that happens to hash the same is a miss like any other
+    uint32_t version = 0;
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!r.get(version) || version != VERSION || !r.text(path) || path != key.path ||
+        !r.get(size) || size != key.size || !r.get(mtime) || mtime != key.mtime) return false;
+
+    uint32_t count = 0;
+    if (!r.count(count, 4)) return false;
+    SymbolTable& table = getSymbols();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string symbol;
+        if (!r.text(symbol)) return false;
+        r.symbols.push_back(table.intern(symbol));
+    }
+
+    if (!r.count(count, 12)) return false;
+    Statements loaded;
+    loaded.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto program = std::make_shared<ScriptProgram>();
+        program->name = name;
+        if (!loadProgram(r, *program)) return false;
+        loaded.push_back(std::move(program));
+    }
+    if (!r.finished()) return false;
+
+    statements = std::move(loaded);
+    return true;
+}
+
+void ScriptCache::store(const Key& key, const Statements& statements) const {
+    if (!enabled()) return;
+
+    Writer body;
+    body.put<uint32_t>((uint32_t)statements.size());
+    for (const auto& program : statements) saveProgram(body, *program);
+
+    Writer head;
+    head.put<uint32_t>(VERSION);
+    head.text(key.path);
+    head.put<uint64_t>(key.size);
+    head.put<int64_t>(key.mtime);
+    head.put<uint32_t>((uint32_t)body.symbols.size());
+    for (uint32_t id : body.symbols) head.text(getSymbols().name(id));
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) return;
+
+    // written next to it and renamed over it, a shell running the script at the same time
+    // either sees the old entry or the whole new one
+    std::string target = entryPath(key);
+    std::string temporary = target + "." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        uint64_t checksum = fnv1a(body.bytes, fnv1a(head.bytes));
+        out.write(MAGIC.data(), (std::streamsize)MAGIC.size());
+        out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        out.write(head.bytes.data(), (std::streamsize)head.bytes.size());
+        out.write(body.bytes.data(), (std::streamsize)body.bytes.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, target, ec);
+    if (ec) std::filesystem::remove(temporary, ec);
+}
+
+ScriptCache& getScriptCache() {
+    static ScriptCache instance;
+    return instance;
+}
+
+} // namespace olsh::Utils
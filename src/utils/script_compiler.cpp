@@ -0,0 +1,576 @@
+#include "../../include/utils/script_compiler.h"
+#include "../../include/utils/symbols.h"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+
+namespace olsh::Utils {
+
+namespace {
+    struct Line {
+        std::string text; // trimmed
+        uint32_t number;
+    };
+
+    std::string trim(std::string_view s) {
+        size_t start = 0; while (start < s.size() && std::isspace((unsigned char)s[start])) start++;
+        size_t end = s.size(); while (end > start && std::isspace((unsigned char)s[end-1])) end--;
+        return std::string(s.substr(start, end - start));
+    }
+
+    bool isBreak(char c) {
+        return c == ' ' || c == '\t' || c == ';';
+    }
+
+    std::string_view firstWord(std::string_view s) {
+        size_t end = 0;
+        while (end < s.size() && !isBreak(s[end])) end++;
+        return s.substr(0, end);
+    }
+
+    // where word appears as a word of its own outside quotes ("; then", " do"), npos if it doesn't.
+    // a plain find would also hit [ $done -eq 1 ] or echo "then"
+    size_t findKeyword(std::string_view s, std::string_view word) {
+        char quote = 0;
+        for (size_t p = 0; p < s.size(); ++p) {
+            char c = s[p];
+            if (quote) { if (c == quote) quote = 0; continue; }
+            if (c == '"' || c == '\'') { quote = c; continue; }
+            if (s.compare(p, word.size(), word) != 0) continue;
+            size_t end = p + word.size();
+            if ((p == 0 || isBreak(s[p-1])) && (end == s.size() || isBreak(s[end]))) return p;
+        }
+        return std::string_view::npos;
+    }
+
+    // "echo x; done" -> where the "; done" starts, so one-line bodies end their block. only
+    // words that close something count, and only right after a ;
+    size_t findClosing(std::string_view s) {
+        size_t best = std::string_view::npos;
+        for (std::string_view word : {"done", "fi", "else", "elif"}) {
+            size_t from = 0;
+            while (true) {
+                size_t at = findKeyword(s.substr(from), word);
+                if (at == std::string_view::npos) break;
+                at += from;
+                size_t before = at;
+                while (before > 0 && (s[before-1] == ' ' || s[before-1] == '\t')) before--;
+                if (before > 0 && s[before-1] == ';') { best = std::min(best, before - 1); break; }
+                from = at + word.size();
+            }
+        }
+        return best;
+    }
+
+    // the < of "read x < FILE", npos without one
+    size_t findInput(std::string_view s) {
+        char quote = 0;
+        for (size_t p = 0; p < s.size(); ++p) {
+            char c = s[p];
+            if (c == '\\') { p++; continue; }
+            if (quote) { if (c == quote) quote = 0; continue; }
+            if (c == '"' || c == '\'' || c == '`') quote = c;
+            else if (c == '<') return p;
+        }
+        return std::string_view::npos;
+    }
+
+    // for X in "${NAME[@]}" or ${!NAME[@]} without the quotes, the elements (or keys) don't
+    // have to be joined into a string and split again
+    bool wholeArray(std::string_view list, std::string_view& name, bool& keys) {
+        if (list.size() >= 2 && list.front() == '"' && list.back() == '"') list = list.substr(1, list.size() - 2);
+        if (list.size() < 6 || list.compare(0, 2, "${") != 0 || list.compare(list.size() - 4, 4, "[@]}") != 0) return false;
+        list = list.substr(2, list.size() - 6);
+        keys = !list.empty() && list.front() == '!';
+        if (keys) list.remove_prefix(1);
+        if (list.empty() || std::isdigit((unsigned char)list[0])) return false;
+        for (char c : list) {
+            if (!std::isalnum((unsigned char)c) && c != '_') return false;
+        }
+        name = list;
+        return true;
+    }
+
+    // (( expr )) -> expr, false if text isn't one
+    bool arithmeticCommand(std::string_view text, std::string_view& expr) {
+        if (text.size() < 4 || text.compare(0, 2, "((") != 0 || text.compare(text.size() - 2, 2, "))") != 0) return false;
+        expr = text.substr(2, text.size() - 4);
+        return true;
+    }
+
+    // set -o profile, set +x ... are for the set builtin, only set NAME = value is an assignment
+    bool setsOption(std::string_view text) {
+        size_t at = text.find_first_not_of(" \t", 3);
+        return at != std::string_view::npos && at > 3 && (text[at] == '-' || text[at] == '+');
+    }
+
+    // the lines a compiler works on. read pulls more when it runs out, so a script that's still
+    // coming in only has to be there up to the end of the statement being compiled
+    struct LineWindow {
+        std::deque<Line> lines;
+        std::function<bool(std::string&)> read; // next raw line, false at the end. none: lines is all of it
+        uint32_t number = 0;                     // of the last raw line read
+
+        // true if there's a line at pos, reading as far as needed. blank lines, comments and
+        // the shebang never make it in
+        bool has(size_t pos) {
+            while (pos >= lines.size()) {
+                std::string raw;
+                if (!read || !read(raw)) {
+                    read = nullptr;
+                    return false;
+                }
+                number++;
+                if (number == 1 && raw.compare(0, 2, "#!") == 0) continue;
+                std::string text = trim(raw);
+                if (text.empty() || text[0] == '#') continue;
+                lines.push_back({std::move(text), number});
+            }
+            return true;
+        }
+    };
+
+    // "cond ;" -> "cond"
+    std::string stripSemicolon(std::string_view s) {
+        std::string out = trim(s);
+        while (!out.empty() && out.back() == ';') { out.pop_back(); out = trim(out); }
+        return out;
+    }
+
+    class Compiler {
+    public:
+        Compiler(ScriptProgram& p, ScriptSyntaxError& e, LineWindow& source, uint32_t target)
+            : program(p), error(e), window(source), lines(source.lines), chunk(target) {}
+
+        bool compile() {
+            std::string_view stop;
+            // text() can fail without the statement around it noticing
+            return block({}, stop) && error.message.empty();
+        }
+
+        // just the next statement, the lines it used are dropped afterwards.
+        // false when there's none left or it has an error
+        bool step() {
+            if (!more()) return false;
+            bool ok = statement() && error.message.empty();
+            lines.erase(lines.begin(), lines.begin() + (long)pos);
+            pos = 0;
+            return ok;
+        }
+
+    private:
+        ScriptProgram& program;
+        ScriptSyntaxError& error;
+        LineWindow& window;
+        std::deque<Line>& lines;
+        size_t pos = 0;
+        uint32_t chunk;
+
+        bool more() { return window.has(pos); }
+
+        // not cached, a function body adds a chunk and that can move the others
+        std::vector<ScriptInstruction>& code() { return program.chunks[chunk].code; }
+        uint32_t here() { return (uint32_t)code().size(); }
+
+        uint32_t emit(ScriptOp op, uint32_t a, uint32_t b, uint32_t line) {
+            code().push_back({op, a, b, line});
+            return here() - 1;
+        }
+
+        void patch(uint32_t at) { code()[at].b = here(); }
+
+        uint32_t text(std::string s, uint32_t line) {
+            ScriptText& t = program.texts.emplace_back();
+            std::string message;
+            if (!compileText(std::move(s), t, message)) fail(line, message);
+            return (uint32_t)program.texts.size() - 1;
+        }
+
+        bool expression(std::string_view s, uint32_t line, uint32_t& index) {
+            std::string message;
+            ArithExpr& expr = program.exprs.emplace_back();
+            program.exprSources.emplace_back(trim(s));
+            if (!ArithExpr::compile(s, expr, message)) return fail(line, "((" + std::string(s) + ")): " + message);
+            index = (uint32_t)program.exprs.size() - 1;
+            return true;
+        }
+
+        // a condition is a [ ... ] test to expand, a (( ... )) to evaluate or a read that
+        // holds as long as there's input
+        bool test(const std::string& cond, uint32_t line, uint32_t& at) {
+            std::string_view expr;
+            uint32_t index = 0;
+            if (firstWord(cond) == "read") {
+                emit(ScriptOp::READ, text(trim(std::string_view(cond).substr(4)), line), 0, line);
+                at = emit(ScriptOp::JUMP_UNLESS_OK, 0, 0, line);
+                return true;
+            }
+            if (!arithmeticCommand(cond, expr)) {
+                at = emit(ScriptOp::JUMP_UNLESS, text(cond, line), 0, line);
+                return true;
+            }
+            if (!expression(expr, line, index)) return false;
+            at = emit(ScriptOp::JUMP_UNLESS_ARITH, index, 0, line);
+            return true;
+        }
+
+        // "done" or "done < FILE", file is left empty without one
+        bool loopEnd(uint32_t line, std::string& file) {
+            std::string_view rest = lines[pos].text;
+            size_t at = rest.find_first_not_of(" \t", 4);
+            if (at == std::string_view::npos || rest[at] != '<') {
+                consume(4);
+                return true;
+            }
+            size_t end = std::min(rest.find(';', at), rest.size());
+            file = trim(rest.substr(at + 1, end - at - 1));
+            if (file.empty()) return fail(line, "expected a file after 'done <'");
+            consume(end);
+            return true;
+        }
+
+        // the code from from on reads file, a loop or a single read. it's opened right before,
+        // an instruction slipped in now that the end is known, and closed here
+        void redirectInput(uint32_t from, std::string file, uint32_t line) {
+            uint32_t name = text(std::move(file), line);
+            auto& c = code();
+            for (uint32_t i = 0; i < c.size(); ++i) {
+                switch (c[i].op) {
+                    case ScriptOp::JUMP:
+                    case ScriptOp::JUMP_UNLESS:
+                    case ScriptOp::JUMP_UNLESS_ARITH:
+                    case ScriptOp::JUMP_UNLESS_OK:
+                    case ScriptOp::FOR_NEXT:
+                    case ScriptOp::INPUT_BEGIN:
+                        // jumps back to the top of the loop stay in it, the ones from before
+                        // it still land on what now opens the file
+                        if (c[i].b > from || (c[i].b == from && i >= from)) c[i].b++;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            c.insert(c.begin() + from, ScriptInstruction{ScriptOp::INPUT_BEGIN, name, 0, line});
+            emit(ScriptOp::INPUT_END, 0, 0, line);
+            code()[from].b = here();
+        }
+
+        bool fail(uint32_t line, std::string message) {
+            if (error.message.empty()) error = {line, std::move(message)};
+            return false;
+        }
+
+        // drops the first size chars of the current line, what's left ("else echo x") is the next line
+        void consume(size_t size) {
+            std::string rest = trim(std::string_view(lines[pos].text).substr(size));
+            while (!rest.empty() && rest.front() == ';') rest = trim(std::string_view(rest).substr(1));
+            if (rest.empty()) pos++;
+            else lines[pos].text = std::move(rest);
+        }
+
+        // statements until a line starting with one of stops, which is left for the caller.
+        // stop is empty when the lines ran out instead
+        bool block(std::initializer_list<std::string_view> stops, std::string_view& stop) {
+            while (more()) {
+                std::string_view word = firstWord(lines[pos].text);
+                for (std::string_view s : stops) {
+                    if (word == s) { stop = s; return true; }
+                }
+                if (!statement()) return false;
+            }
+            stop = {};
+            return true;
+        }
+
+        bool statement() {
+            const Line& line = lines[pos];
+            std::string_view word = firstWord(line.text);
+
+            if (word == "if" || line.text.compare(0, 3, "if[") == 0) return ifStatement();
+            if (word == "while") return whileStatement();
+            if (word == "for") return forStatement();
+            if (word == "function") return functionStatement();
+            for (std::string_view keyword : {"then", "do", "elif", "else", "fi", "done"}) {
+                if (word == keyword) return fail(line.number, "unexpected '" + std::string(word) + "'");
+            }
+
+            // echo x; done
+            size_t closing = findClosing(line.text);
+            if (closing != std::string::npos) {
+                Line head{trim(std::string_view(line.text).substr(0, closing)), line.number};
+                lines[pos].text = trim(std::string_view(line.text).substr(closing + 1));
+                if (!head.text.empty()) lines.insert(lines.begin() + (long)pos, std::move(head));
+                return true;
+            }
+
+            std::string_view expr;
+            if (arithmeticCommand(line.text, expr)) {
+                uint32_t index = 0;
+                if (!expression(expr, line.number, index)) return false;
+                emit(ScriptOp::ARITH, index, 0, line.number);
+            } else if (word == "set" && line.text.size() > 3 && !setsOption(line.text)) {
+                emit(ScriptOp::SET, text(trim(std::string_view(line.text).substr(3)), line.number), 0, line.number);
+            } else if (word == "read") {
+                std::string_view rest = std::string_view(line.text).substr(4);
+                size_t input = findInput(rest);
+                uint32_t from = emit(ScriptOp::READ, text(trim(rest.substr(0, std::min(input, rest.size()))), line.number), 0, line.number);
+                if (input != std::string_view::npos) {
+                    std::string file = trim(rest.substr(input + 1));
+                    if (file.empty()) return fail(line.number, "expected a file after '<'");
+                    redirectInput(from, std::move(file), line.number);
+                }
+            } else if (word == "local" || word == "export" || word == "declare") {
+                ScriptOp op = word == "local" ? ScriptOp::LOCAL : word == "export" ? ScriptOp::EXPORT : ScriptOp::DECLARE;
+                emit(op, text(trim(std::string_view(line.text).substr(word.size())), line.number), 0, line.number);
+            } else {
+                emit(ScriptOp::RUN, text(line.text, line.number), 0, line.number);
+            }
+            pos++;
+            return true;
+        }
+
+        // "keyword HEAD; opener [rest]" or the opener on a line of its own. leaves pos on
+        // whatever follows the opener
+        bool header(std::string_view keyword, std::string_view opener, std::string& head) {
+            const Line& line = lines[pos];
+            std::string_view rest = std::string_view(line.text).substr(keyword.size());
+            size_t at = findKeyword(rest, opener);
+            if (at != std::string_view::npos) {
+                head = stripSemicolon(rest.substr(0, at));
+                consume(keyword.size() + at + opener.size());
+                return true;
+            }
+
+            head = stripSemicolon(rest);
+            uint32_t number = line.number;
+            pos++;
+            if (!more() || firstWord(lines[pos].text) != opener) {
+                return fail(number, "expected '" + std::string(opener) + "' after '" + std::string(keyword) + "'");
+            }
+            consume(opener.size());
+            return true;
+        }
+
+        bool ifStatement() {
+            uint32_t start = lines[pos].number;
+            uint32_t line = start;
+            std::string cond;
+            if (!header("if", "then", cond)) return false;
+
+            // every branch ends with a jump past the rest of the if
+            std::vector<uint32_t> ends;
+            std::string_view stop;
+            while (true) {
+                uint32_t skip = 0;
+                if (!test(cond, line, skip)) return false;
+                if (!block({"elif", "else", "fi"}, stop)) return false;
+                if (stop.empty()) return fail(start, "missing 'fi'");
+                ends.push_back(emit(ScriptOp::JUMP, 0, 0, line));
+                patch(skip);
+                if (stop != "elif") break;
+                line = lines[pos].number;
+                if (!header("elif", "then", cond)) return false;
+            }
+
+            if (stop == "else") {
+                consume(4);
+                if (!block({"fi"}, stop)) return false;
+                if (stop.empty()) return fail(start, "missing 'fi'");
+            } else {
+                emit(ScriptOp::STATUS, 0, 0, start);
+            }
+            consume(2);
+            for (uint32_t at : ends) patch(at);
+            return true;
+        }
+
+        bool whileStatement() {
+            uint32_t line = lines[pos].number;
+            std::string cond;
+            if (!header("while", "do", cond)) return false;
+
+            uint32_t top = here();
+            uint32_t exit = 0;
+            if (!test(cond, line, exit)) return false;
+            std::string_view stop;
+            if (!block({"done"}, stop)) return false;
+            if (stop.empty()) return fail(line, "missing 'done'");
+            std::string file;
+            if (!loopEnd(line, file)) return false;
+            emit(ScriptOp::JUMP, 0, top, line);
+            patch(exit);
+            if (!file.empty()) redirectInput(top, std::move(file), line);
+            return true;
+        }
+
+        bool forStatement() {
+            uint32_t line = lines[pos].number;
+            std::string head;
+            if (!header("for", "do", head)) return false;
+
+            // NAME in WORDS...
+            std::string_view name = firstWord(head);
+            std::string_view rest = std::string_view(head).substr(name.size());
+            size_t in = findKeyword(rest, "in");
+            if (name.empty() || in == std::string_view::npos || !trim(rest.substr(0, in)).empty()) {
+                return fail(line, "expected 'for NAME in WORDS...'");
+            }
+
+            std::string list = trim(rest.substr(in + 2));
+            std::string_view array;
+            bool keys = false;
+            uint32_t begin = wholeArray(list, array, keys)
+                ? emit(ScriptOp::FOR_ARRAY, getSymbols().intern(array), keys ? 1 : 0, line)
+                : emit(ScriptOp::FOR_BEGIN, text(std::move(list), line), 0, line);
+            uint32_t top = emit(ScriptOp::FOR_NEXT, getSymbols().intern(name), 0, line);
+            std::string_view stop;
+            if (!block({"done"}, stop)) return false;
+            if (stop.empty()) return fail(line, "missing 'done'");
+            std::string file;
+            if (!loopEnd(line, file)) return false;
+            emit(ScriptOp::JUMP, 0, top, line);
+            patch(top);
+            if (!file.empty()) redirectInput(begin, std::move(file), line);
+            return true;
+        }
+
+        bool functionStatement() {
+            uint32_t line = lines[pos].number;
+            std::string rest = trim(std::string_view(lines[pos].text).substr(8));
+            size_t brace = rest.find('{');
+            std::string name = trim(std::string_view(rest).substr(0, brace));
+            if (name.empty()) return fail(line, "function without a name");
+            pos++;
+
+            // function name
+            // {
+            if (brace == std::string::npos) {
+                if (!more() || lines[pos].text[0] != '{') return fail(line, "expected '{' after 'function " + name + "'");
+                rest = lines[pos].text;
+                brace = 0;
+                pos++;
+            }
+
+            // the body is everything up to the matching }, text after { or before } included
+            LineWindow body;
+            int depth = 1;
+            std::string leftover;
+            auto take = [&](std::string_view s, uint32_t number) {
+                for (size_t i = 0; i < s.size(); ++i) {
+                    if (s[i] == '{') depth++;
+                    else if (s[i] == '}' && --depth == 0) {
+                        std::string before = trim(s.substr(0, i));
+                        if (!before.empty()) body.lines.push_back({std::move(before), number});
+                        leftover = trim(s.substr(i + 1));
+                        return true;
+                    }
+                }
+                std::string all = trim(s);
+                if (!all.empty()) body.lines.push_back({std::move(all), number});
+                return false;
+            };
+
+            bool closed = take(std::string_view(rest).substr(brace + 1), line);
+            if (closed) {
+                if (!leftover.empty()) { pos--; lines[pos].text = leftover; }
+            } else {
+                while (more() && !(closed = take(lines[pos].text, lines[pos].number))) pos++;
+                if (!closed) return fail(line, "missing '}' for function " + name);
+                if (leftover.empty()) pos++;
+                else lines[pos].text = leftover;
+            }
+
+            uint32_t target = (uint32_t)program.chunks.size();
+            program.chunks.emplace_back();
+            Compiler inner(program, error, body, target);
+            if (!inner.compile()) return false;
+            emit(ScriptOp::FUNCTION, text(name, line), target, line);
+            return true;
+        }
+    };
+}
+
+bool compileText(std::string raw, ScriptText& out, std::string& error) {
+    out.arith.clear();
+    out.plain = raw.find_first_of("$`") == std::string::npos;
+    for (size_t i = 0; i + 3 < raw.size(); ++i) {
+        if (raw[i] != '$' || raw[i+1] != '(' || raw[i+2] != '(') continue;
+
+        // $(( up to the ) matching the second (, then one more )
+        size_t j = i + 3;
+        int depth = 1;
+        while (j < raw.size() && depth > 0) {
+            if (raw[j] == '(') depth++;
+            else if (raw[j] == ')') depth--;
+            j++;
+        }
+        if (depth != 0 || j >= raw.size() || raw[j] != ')') continue;
+
+        ScriptArith& arith = out.arith.emplace_back();
+        arith.begin = i;
+        arith.end = j + 1;
+        if (!ArithExpr::compile(std::string_view(raw).substr(i + 3, j - 1 - (i + 3)), arith.expr, error)) {
+            error = raw.substr(i, j + 1 - i) + ": " + error;
+            out.arith.pop_back();
+            out.raw = std::move(raw);
+            return false;
+        }
+        i = j;
+    }
+    out.raw = std::move(raw);
+    return true;
+}
+
+namespace {
+    // raw lines of a string, the last one doesn't need a \n
+    std::function<bool(std::string&)> stringLines(std::string_view source) {
+        return [source, start = size_t(0)](std::string& raw) mutable {
+            if (start >= source.size()) return false;
+            size_t end = source.find('\n', start);
+            if (end == std::string_view::npos) end = source.size();
+            raw.assign(source, start, end - start);
+            start = end + 1;
+            return true;
+        };
+    }
+
+    void reset(ScriptProgram& program) {
+        program.texts.clear();
+        program.exprs.clear();
+        program.exprSources.clear();
+        program.chunks.assign(1, ScriptChunk{});
+    }
+}
+
+bool compileScript(std::string_view source, ScriptProgram& program, ScriptSyntaxError& error) {
+    LineWindow window;
+    window.read = stringLines(source);
+    reset(program);
+    Compiler compiler(program, error, window, 0);
+    return compiler.compile();
+}
+
+struct ScriptStream::State {
+    LineWindow window;
+};
+
+ScriptStream::ScriptStream(std::istream& in) : state(std::make_unique<State>()) {
+    state->window.read = [&in](std::string& raw) { return (bool)std::getline(in, raw); };
+}
+
+ScriptStream::ScriptStream(std::string_view source) : state(std::make_unique<State>()) {
+    state->window.read = stringLines(source);
+}
+
+ScriptStream::~ScriptStream() = default;
+
+bool ScriptStream::next(ScriptProgram& program, ScriptSyntaxError& error) {
+    reset(program);
+    Compiler compiler(program, error, state->window, 0);
+    return compiler.step();
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,63 @@
+#include "../../include/utils/streams.h"
+#include "../../include/utils/fd_stream.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#define STDOUT_FILENO 1
+#else
+#include <unistd.h>
+#endif
+
+namespace olsh::Utils {
+
+namespace {
+    // null means the std stream
+    thread_local std::istream* t_in = nullptr;
+    thread_local std::ostream* t_out = nullptr;
+    thread_local std::ostream* t_err = nullptr;
+
+    // std::cout's own buffer writes to fd 1, anything swapped in later doesn't
+    std::streambuf* const s_stdoutBuf = std::cout.rdbuf();
+}
+
+std::istream& in() {
+    return t_in ? *t_in : std::cin;
+}
+
+std::ostream& out() {
+    return t_out ? *t_out : std::cout;
+}
+
+std::ostream& err() {
+    return t_err ? *t_err : std::cerr;
+}
+
+int inFd() {
+    auto* buffer = dynamic_cast<FdStreamBuf*>(in().rdbuf());
+    if (!buffer || buffer->in_avail() > 0) return -1;
+    return buffer->getFd();
+}
+
+int outFd() {
+    std::ostream& stream = out();
+    stream.flush();
+    if (auto* buffer = dynamic_cast<FdStreamBuf*>(stream.rdbuf())) return buffer->getFd();
+    if (stream.rdbuf() == s_stdoutBuf) return STDOUT_FILENO;
+    return -1;
+}
+
+StreamScope::StreamScope(std::istream* in, std::ostream* out, std::ostream* err)
+    : savedIn(t_in), savedOut(t_out), savedErr(t_err) {
+    if (in) t_in = in;
+    if (out) t_out = out;
+    if (err) t_err = err;
+}
+
+StreamScope::~StreamScope() {
+    t_in = savedIn;
+    t_out = savedOut;
+    t_err = savedErr;
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,25 @@
+#include "../../include/utils/symbols.h"
+
+namespace olsh::Utils {
+
+uint32_t SymbolTable::intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+
+    uint32_t symbol = (uint32_t)names.size();
+    names.emplace_back(name);
+    ids.emplace(names.back(), symbol);
+    return symbol;
+}
+
+uint32_t SymbolTable::find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? NONE : it->second;
+}
+
+SymbolTable& getSymbols() {
+    static SymbolTable symbols;
+    return symbols;
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,100 @@
+#include "../../include/utils/xtrace.h"
+#include <utils/colors.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace olsh::Utils {
+
+void Tracer::start() {
+    if (on) return;
+
+    int fd = 2;
+    bool owned = false;
+    const char* file = std::getenv("OLSH_XTRACEFILE");
+    const char* number = std::getenv("OLSH_XTRACEFD");
+    if (file && *file) {
+#ifdef _WIN32
+        int opened = _open(file, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        int opened = open(file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (opened == -1) {
+            std::cerr << RED << "Error: Cannot open trace file " << file << ": " << std::strerror(errno) << RESET << std::endl;
+        } else {
+            fd = opened;
+            owned = true;
+        }
+    } else if (number && *number) {
+        int parsed = -1;
+        auto [end, ec] = std::from_chars(number, number + std::strlen(number), parsed);
+        if (ec != std::errc() || *end != '\0' || parsed < 0) {
+            std::cerr << RED << "Error: OLSH_XTRACEFD is not a file descriptor: " << number << RESET << std::endl;
+        } else {
+            fd = parsed;
+        }
+    }
+
+    out = std::make_unique<FdStreamBuf>(fd, owned, 8 * 1024);
+#ifdef _WIN32
+    terminal = _isatty(fd) != 0;
+#else
+    terminal = isatty(fd) != 0;
+#endif
+    last = Clock::now();
+    on = true;
+}
+
+void Tracer::stop() {
+    if (!on) return;
+    on = false;
+    skip = false;
+    out.reset(); // flushed, and closed if it was a file of our own
+}
+
+void Tracer::command(int depth, std::string_view file, uint32_t line, std::string_view text) {
+    if (!out) return;
+    Clock::time_point now = Clock::now();
+    double delta = std::chrono::duration<double>(now - last).count();
+    last = now;
+
+    for (int i = 0; i < std::max(depth, 1); ++i) out->sputc('+');
+    char stamp[32];
+    int length = std::snprintf(stamp, sizeof(stamp), " +%.6fs ", delta);
+    out->sputn(stamp, length);
+    if (!file.empty()) {
+        out->sputn(file.data(), (std::streamsize)file.size());
+        char number[16];
+        auto [end, ec] = std::to_chars(number, number + sizeof(number), line);
+        out->sputc(':');
+        out->sputn(number, end - number);
+        out->sputn(": ", 2);
+    }
+    out->sputn(text.data(), (std::streamsize)text.size());
+    out->sputc('\n');
+    if (terminal) out->pubsync();
+}
+
+void Tracer::flush() {
+    if (out) out->pubsync();
+}
+
+Tracer& getTracer() {
+    static Tracer instance;
+    return instance;
+}
+
+} // namespace olsh::Utils
@@ -0,0 +1,129 @@
+#include "../../include/utils/zero_copy.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#endif
+
+namespace olsh::Utils {
+
+namespace {
+    constexpr size_t CHUNK = 1 << 30; // per call, the kernel caps it anyway
+
+#ifdef __linux__
+    enum class Result { DONE, UNSUPPORTED, FAILED };
+
+    // runs one of the syscalls until EOF. UNSUPPORTED means try the next way,
+    // that's fine even halfway through since every one of them moves the fd offsets
+    template <typename Step>
+    Result drive(Step step, long long& total) {
+        for (;;) {
+            ssize_t n = step();
+            if (n > 0) {
+                total += n;
+                continue;
+            }
+            if (n == 0) return Result::DONE;
+            if (errno == EINTR) continue;
+            if (errno == EPIPE) return Result::FAILED;
+            // EINVAL, EXDEV, ENOSYS, EOPNOTSUPP, EBADF for O_APPEND targets, EISDIR...
+            // the read/write loop reports it if it's a real error
+            return Result::UNSUPPORTED;
+        }
+    }
+#endif
+}
+
+#ifdef __linux__
+void growPipe(int fd) {
+    // 16 pages by default, so every splice/tee would only move 64k. fails quietly past
+    // /proc/sys/fs/pipe-max-size, the pipe just stays as it is
+    fcntl(fd, F_SETPIPE_SZ, 1 << 20);
+}
+#endif
+
+bool zeroCopyEnabled() {
+    // OLSH_ZERO_COPY=0 forces the buffered loop (mostly for benchmarking)
+    static const bool enabled = [] {
+        const char* mode = std::getenv("OLSH_ZERO_COPY");
+        return !(mode && std::strcmp(mode, "0") == 0);
+    }();
+    return enabled;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned int>(size));
+#else
+        ssize_t n = write(fd, data, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+long long copyFd(int inFd, int outFd) {
+    long long total = 0;
+
+#ifdef __linux__
+    if (zeroCopyEnabled()) {
+        struct stat in{}, out{};
+        if (fstat(inFd, &in) == 0 && fstat(outFd, &out) == 0) {
+            Result result = Result::UNSUPPORTED;
+
+            // file to file: stays inside the filesystem (reflinks on btrfs/xfs, server side on nfs)
+            if (S_ISREG(in.st_mode) && S_ISREG(out.st_mode)) {
+                result = drive([&] { return copy_file_range(inFd, nullptr, outFd, nullptr, CHUNK, 0); }, total);
+            }
+            // file to anything: page cache straight into the pipe/socket/file
+            if (result == Result::UNSUPPORTED && S_ISREG(in.st_mode)) {
+                result = drive([&] { return sendfile(outFd, inFd, nullptr, CHUNK); }, total);
+            }
+            // a pipe on one side: pages are moved, not copied
+            if (result == Result::UNSUPPORTED && (S_ISFIFO(in.st_mode) || S_ISFIFO(out.st_mode))) {
+                if (S_ISFIFO(in.st_mode)) growPipe(inFd);
+                if (S_ISFIFO(out.st_mode)) growPipe(outFd);
+                result = drive([&] { return splice(inFd, nullptr, outFd, nullptr, CHUNK, SPLICE_F_MOVE); }, total);
+            }
+
+            if (result == Result::DONE) return total;
+            if (result == Result::FAILED) return -1;
+        }
+    }
+#endif
+
+    std::vector<char> buffer(128 * 1024);
+    for (;;) {
+#ifdef _WIN32
+        int n = _read(inFd, buffer.data(), static_cast<unsigned int>(buffer.size()));
+#else
+        ssize_t n = read(inFd, buffer.data(), buffer.size());
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return total;
+        if (!writeAll(outFd, buffer.data(), static_cast<size_t>(n))) return -1;
+        total += n;
+    }
+}
+
+} // namespace olsh::Utils
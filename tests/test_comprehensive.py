@@ -4,6 +4,8 @@ Tests all major functionality including commands, parsing, execution, and featur
 """
 
 import unittest
+import json
+import re
 import subprocess
 import os
 import tempfile
@@ -125,6 +127,35 @@ class OlshellTestBase(unittest.TestCase):
             return filepath.read_text(encoding='utf-8')
         return ""
 
+    def run_olshell_script(self, script_name, args=(), env=None, timeout=60, input_text=None):
+        """
+        Run a .olsh script file directly (olshell script.olsh args...), with input_text
+        on its stdin if there is one
+
+        Returns:
+            tuple: (stdout, stderr, return_code, elapsed_seconds)
+        """
+        run_env = dict(os.environ)
+        if env:
+            run_env.update(env)
+
+        start_time = time.time()
+        try:
+            result = subprocess.run(
+                [str(self.olshell_exe), script_name, *args],
+                **({"stdin": subprocess.DEVNULL} if input_text is None else {"input": input_text}),
+                capture_output=True,
+                text=True,
+                cwd=self.test_dir,
+                env=run_env,
+                encoding='utf-8',
+                errors='replace',
+                timeout=timeout
+            )
+            return result.stdout, result.stderr, result.returncode, time.time() - start_time
+        except subprocess.TimeoutExpired as e:
+            return e.stdout or "", e.stderr or "", -1, time.time() - start_time
+
 
 class TestBasicCommands(OlshellTestBase):
     """Test basic shell commands"""
@@ -298,6 +329,28 @@ class TestRedirection(OlshellTestBase):
             self.assertNotIn("original content", content)
 
 
+    def test_stderr_redirection(self):
+        """Test fd-numbered redirection of a builtin's errors"""
+        stdout, stderr, code = self.run_olshell_command('cat missing.txt 2> errors.txt')
+        self.assertNotEqual(code, -1)
+        self.assertIn("missing.txt", self.read_file_content("errors.txt"))
+        self.assertNotIn("No such file", stderr)
+
+    def test_stderr_to_stdout_redirection(self):
+        """Test 2>&1 and &> sending both streams to the same file"""
+        self.run_olshell_command('cat missing.txt > both.txt 2>&1')
+        self.assertIn("missing.txt", self.read_file_content("both.txt"))
+
+        self.run_olshell_command('cat missing.txt &> all.txt')
+        self.assertIn("missing.txt", self.read_file_content("all.txt"))
+
+    def test_redirection_does_not_leak_into_shell(self):
+        """Test that output after a redirected builtin goes back to the terminal"""
+        stdout, stderr, code = self.run_olshell_command('echo "to file" > leak.txt', 'echo "to terminal"')
+        self.assertIn("to terminal", stdout)
+        self.assertNotIn("to terminal", self.read_file_content("leak.txt"))
+
+
 class TestPipelines(OlshellTestBase):
     """Test pipeline operations"""
     
@@ -323,6 +376,70 @@ class TestPipelines(OlshellTestBase):
             content = self.read_file_content("piped_file.txt")
             self.assertIn("piped output", content)
 
+    def test_empty_pipeline_stage_is_an_error(self):
+        """Test that an empty stage after | is a syntax error instead of being dropped"""
+        self.create_test_file("stages.olsh", 'echo c || echo d\necho q | | cat\necho after\n')
+        stdout, stderr, code, _ = self.run_olshell_script("stages.olsh")
+        self.assertIn("syntax error near unexpected token `|'", stderr)
+        self.assertEqual(stdout.split(), ["after"])
+
+    def test_pipeline_reads_from_previous_stage(self):
+        """Test that cat in a pipeline reads the pipe, not the shell's input"""
+        stdout, stderr, code = self.run_olshell_command('echo "from pipe" | cat', 'echo "still running"')
+        self.assertIn("from pipe", stdout)
+        self.assertIn("still running", stdout)
+
+    @unittest.skipIf(sys.platform == "win32", "no real pipes on windows")
+    def test_builtin_stages_mixed_with_externals(self):
+        """Test builtin stages next to each other and next to externals, including a reader that quits early"""
+        lines = "".join(f"line {i}\n" for i in range(200000))
+        self.create_test_file("big.txt", lines)
+
+        stdout, stderr, code = self.run_olshell_command(
+            'cat big.txt | cat | cat | wc -l; cat big.txt | head -n 1',
+            'echo "still running"')
+        self.assertIn("200000", stdout)
+        self.assertIn("line 0", stdout)
+        self.assertNotIn("line 1\n", stdout)
+        # the broken pipe must not take the shell down with it
+        self.assertIn("still running", stdout)
+
+    @unittest.skipIf(sys.platform == "win32", "no exec bits on windows")
+    def test_script_without_shebang(self):
+        """Test that an executable file without a #! runs through sh, alone and in a pipeline, both launch modes"""
+        bin_dir = os.path.join(self.test_dir, "bin")
+        os.makedirs(bin_dir, exist_ok=True)
+        script = os.path.join(bin_dir, "ns")
+        with open(script, "w") as f:
+            f.write("echo from-noshebang $1\n")
+        os.chmod(script, 0o755)
+        self.create_test_file("noshebang.olsh", "ns one\nns two | cat\n")
+        for mode in ("spawn", "fork"):
+            env = {"PATH": bin_dir + os.pathsep + os.environ.get("PATH", ""), "OLSH_LAUNCH": mode}
+            stdout, stderr, code, _ = self.run_olshell_script("noshebang.olsh", env=env)
+            self.assertIn("from-noshebang one", stdout, f"{mode}: {stderr}")
+            self.assertIn("from-noshebang two", stdout, f"{mode}: {stderr}")
+            self.assertNotIn("Exec format error", stderr)
+
+    @unittest.skipIf(sys.platform == "win32", "no rusage on windows")
+    def test_time_and_last_rusage(self):
+        """Test the time builtin over a whole pipeline and the per-stage usage left in OLSH_LAST_RUSAGE"""
+        stdout, stderr, code = self.run_olshell_command('time -v sleep 0.2 | cat')
+        self.assertRegex(stderr, r"real\t0m0\.[2-9]\d*s")
+        self.assertIn("user\t", stderr)
+        self.assertIn("maxrss\t", stderr)
+        self.assertIn("stage 1 (sleep 0.2): real=", stderr)
+        self.assertIn("stage 2 (cat): real=", stderr)
+
+        self.create_test_file("usage.olsh", "sleep 0.1\necho $OLSH_LAST_RUSAGE\nsleep 0 | sleep 0\necho $OLSH_LAST_RUSAGE_STAGES\nprintenv OLSH_LAST_RUSAGE OLSH_LAST_RUSAGE_STAGES\n")
+        stdout, stderr, code, _ = self.run_olshell_script("usage.olsh")
+        lines = [line for line in stdout.splitlines() if line.startswith("real=")]
+        self.assertEqual(len(lines), 2, stdout)
+        self.assertRegex(lines[0], r"^real=0\.1\d* user=[\d.]+ sys=[\d.]+ maxrss=[1-9]\d* nvcsw=\d+ nivcsw=\d+ minflt=\d+ majflt=\d+$")
+        self.assertEqual(lines[1].count("maxrss="), 2)
+        # made up on read like $?, children never see them
+        self.assertEqual(stdout.count("real="), 3, stdout)
+
 
 class TestCommandChaining(OlshellTestBase):
     """Test command chaining with semicolons"""
@@ -334,6 +451,58 @@ class TestCommandChaining(OlshellTestBase):
         self.assertIn("second", stdout)
         self.assertIn("third", stdout)
     
+    def test_background_and_wait(self):
+        """Test starting commands with & and waiting for them"""
+        stdout, stderr, code = self.run_olshell_command('echo "bg output" > bg.txt & wait; cat bg.txt')
+        self.assertNotEqual(code, -1)
+        self.assertIn("bg output", stdout)
+
+    def test_empty_list_item_is_an_error(self):
+        """Test that && , & & and ;; are syntax errors instead of running things in the background"""
+        for line in ("echo a && echo ran > ran.txt", "echo a & & echo ran > ran.txt", "echo a;; echo ran > ran.txt"):
+            stdout, stderr, code = self.run_olshell_command(line)
+            self.assertIn("syntax error near unexpected token", stderr, line)
+            self.assertFalse(self.file_exists("ran.txt"), line)
+
+    @unittest.skipIf(sys.platform == "win32", "no job control on windows")
+    def test_jobs_kill_and_wait(self):
+        """Test listing a background job, killing it by job spec and waiting for it"""
+        start = time.time()
+        stdout, stderr, code = self.run_olshell_command('sleep 5 &\njobs\nkill %1\nwait %1\njobs -p\necho "after"')
+        self.assertNotEqual(code, -1)
+        self.assertIn("Running", stdout)
+        self.assertIn("sleep 5", stdout)
+        self.assertIn("after", stdout)
+        self.assertLess(time.time() - start, 4.5, "kill %1 should have ended the job")
+
+    @unittest.skipIf(sys.platform == "win32", "no job control on windows")
+    def test_kill_out_of_range_ids(self):
+        """Test that pids, job numbers and signals too big for their type are rejected, not wrapped or thrown"""
+        stdout, stderr, code = self.run_olshell_command(
+            'kill -0 4294967295\nkill %99999999999999999999\nkill -l 99999999999\n'
+            'fg 99999999999999999999999\nwait 99999999999999999999\necho "after"')
+        self.assertIn("4294967295: arguments must be process or job IDs", stderr)
+        self.assertIn("%99999999999999999999: no such job", stderr)
+        self.assertIn("99999999999: invalid signal specification", stderr)
+        self.assertIn("99999999999999999999999: no such job", stderr)
+        self.assertNotIn("stol", stderr)
+        self.assertNotIn("stoi", stderr)
+        self.assertIn("after", stdout)
+
+    @unittest.skipIf(sys.platform == "win32", "needs /bin/echo")
+    def test_hash_builtin(self):
+        """Test the command location cache behind hash"""
+        stdout, stderr, code = self.run_olshell_command('hash -p /bin/echo say; say "pinned"; hash')
+        self.assertNotEqual(code, -1)
+        self.assertIn("pinned", stdout)
+        self.assertIn("/bin/echo", stdout)
+
+        stdout, stderr, code = self.run_olshell_command('hash -p /bin/echo say; hash -r; hash')
+        self.assertIn("hash table empty", stdout)
+
+        stdout, stderr, code = self.run_olshell_command('hash olsh_no_such_command')
+        self.assertIn("not found", stdout + stderr)
+
     def test_chaining_with_file_ops(self):
         """Test chaining file operations"""
         # Test the chain separately to debug the issue
@@ -452,6 +621,345 @@ pwd
         stdout, stderr, code = self.run_olshell_command('ls', expect_exit=True)
         self.assertIn("test_script.olsh", stdout)
 
+    def test_loop_lines_are_parsed_once(self):
+        """Test that a while loop reuses the parsed lines instead of parsing them every iteration"""
+        self.create_test_file("loop.olsh", (
+            "set I = 0\n"
+            "while [ $I -lt 50 ]; do\n"
+            "  echo loop > /dev/null\n"
+            "  set I = $((I + 1))\n"
+            "done\n"
+            "hash -s\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("loop.olsh")
+        match = re.search(r"parsed\s+(\d+) hits, (\d+) misses", stdout)
+        self.assertIsNotNone(match, stdout + stderr)
+        self.assertGreaterEqual(int(match.group(1)), 49)
+        self.assertLessEqual(int(match.group(2)), 5)
+
+    def test_nested_blocks_and_elif(self):
+        """Test that elif branches and nested loops are matched to their own fi/done"""
+        self.create_test_file("blocks.olsh", (
+            "set X = 2\n"
+            "if [ $X -eq 1 ]; then\n"
+            "  echo one\n"
+            "elif [ $X -eq 2 ]; then\n"
+            "  echo two\n"
+            "else\n"
+            "  echo other\n"
+            "fi\n"
+            "for A in 1 2; do\n"
+            "  for B in x y; do echo pair:$A$B; done\n"
+            "done\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("blocks.olsh")
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("two", stdout)
+        self.assertNotIn("other", stdout)
+        self.assertEqual(re.findall(r"pair:(\w+)", stdout), ["1x", "1y", "2x", "2y"])
+
+    def test_arithmetic_operators(self):
+        """Test the C operator set in $((...)) and (( ... )) lines and conditions"""
+        self.create_test_file("arith.olsh", (
+            "set A = 7\n"
+            "echo $((A * 2 + 1)) $((A > 3 && A < 10)) $((A == 7 ? 100 : 200)) $((1 << 4 | 3)) $((2 ** 10))\n"
+            "echo $((B = 5, B += 3)) $((B++)) $((B)) $(( $1 + ${A} ))\n"
+            "set I = 0\n"
+            "while (( I < 3 )); do\n"
+            "  (( I++ ))\n"
+            "done\n"
+            "if (( I == 3 )); then echo counted; fi\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("arith.olsh", args=("5",))
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("15 1 100 19 1024", stdout)
+        self.assertIn("8 8 9 12", stdout)
+        self.assertIn("counted", stdout)
+
+    def test_local_and_export(self):
+        """Test that locals end with their function and only exported variables reach commands"""
+        self.create_test_file("scopes.olsh", (
+            "set X = outer\n"
+            "function show {\n"
+            "  local X = inner\n"
+            "  echo in:$X\n"
+            "  printenv X\n"
+            "}\n"
+            "show\n"
+            "echo out:$X\n"
+            "export Y = 42\n"
+            "printenv Y\n"
+            "function fib {\n"
+            "  local N = $1\n"
+            "  if (( N < 2 )); then set R = $N; else\n"
+            "    fib $((N - 1))\n"
+            "    local A = $R\n"
+            "    fib $((N - 2))\n"
+            "    set R = $((A + R))\n"
+            "  fi\n"
+            "}\n"
+            "fib 12\n"
+            "echo fib:$R\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("scopes.olsh")
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("in:inner", stdout)
+        self.assertIn("out:outer", stdout)
+        self.assertNotIn("\ninner\n", "\n" + stdout)
+        self.assertIn("\n42\n", "\n" + stdout)
+        self.assertIn("fib:144", stdout)
+
+    def test_command_substitution(self):
+        """Test nested $(...), backticks, functions, builtins and externals in substitutions"""
+        self.create_test_file("subst.olsh", (
+            "function greet {\n"
+            "  set CALLED = yes\n"
+            "  echo hello $1\n"
+            "}\n"
+            "echo nested:$(echo $(echo inner))\n"
+            "echo func:$(greet $(echo ann)) called:$CALLED\n"
+            "echo tick:`greet bob`\n"
+            "echo made:$(mkdir subst_dir)$(ls subst_dir)done\n"
+            "echo ext:$(printf 'a\\n\\n\\n' | tr a b)!\n"
+            "echo mixed:$((2 * 3))$(echo x)`echo y`\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("subst.olsh")
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("nested:inner", stdout)
+        # functions run inside the shell, what they set is still there afterwards
+        self.assertIn("func:hello ann called:yes", stdout)
+        self.assertIn("tick:hello bob", stdout)
+        self.assertTrue(os.path.isdir(os.path.join(self.test_dir, "subst_dir")))
+        self.assertIn("ext:b!", stdout)
+        self.assertIn("mixed:6xy", stdout)
+
+    def test_syntax_error_stops_the_script(self):
+        """Test that a block without its done never runs and ends the script"""
+        self.create_test_file("broken.olsh", "echo started\nwhile [ 1 ]; do\n  echo body\n")
+        stdout, stderr, code, _ = self.run_olshell_script("broken.olsh")
+        self.assertEqual(code, 2)
+        # statements run as they're read, the one before the broken block already has
+        self.assertIn("started", stdout)
+        self.assertNotIn("body", stdout)
+        self.assertIn("line 2", stderr)
+        self.assertIn("missing 'done'", stderr)
+
+    def test_compiled_script_cache(self):
+        """Test that a script runs from the cache until it changes and survives a broken entry"""
+        env = {"HOME": self.test_dir}
+        cache_dir = os.path.join(self.test_dir, ".olshell", "scripts")
+        self.create_test_file("cached.olsh", (
+            "function twice {\n  echo $(( $1 * 2 ))\n}\n"
+            "for N in 1 2; do twice $N; done\n"
+        ))
+        first = self.run_olshell_script("cached.olsh", env=env)
+        self.assertEqual(first[2], 0, first[1])
+        entries = os.listdir(cache_dir)
+        self.assertEqual(len(entries), 1)
+
+        second = self.run_olshell_script("cached.olsh", env=env)
+        self.assertEqual(second[:3], first[:3])
+        self.assertIn("2\n4", second[0])
+
+        # a different size (and mtime) is a miss, the new text is what runs
+        self.create_test_file("cached.olsh", "echo changed $((6 * 7))\n")
+        stdout, stderr, code, _ = self.run_olshell_script("cached.olsh", env=env)
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("changed 42", stdout)
+
+        # a garbled entry is ignored and rewritten
+        entry = os.path.join(cache_dir, entries[0])
+        with open(entry, "r+b") as f:
+            f.seek(os.path.getsize(entry) // 2)
+            f.write(b"\xff" * 16)
+        stdout, stderr, code, _ = self.run_olshell_script("cached.olsh", env=env)
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("changed 42", stdout)
+
+    def test_script_from_stdin(self):
+        """Test that olshell - runs a piped script while it's still being written"""
+        proc = subprocess.Popen(
+            [str(self.olshell_exe), "-", "arg"],
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+            cwd=self.test_dir, text=True
+        )
+        try:
+            proc.stdin.write("echo first $1\n")
+            proc.stdin.flush()
+            # the first statement is complete, its output can't wait for the end of the script
+            self.assertEqual(proc.stdout.readline().strip(), "first arg")
+            proc.stdin.write("for X in a b; do\n  echo item:$X\ndone\necho last:$?\n")
+            proc.stdin.close()
+            stdout = proc.stdout.read()
+            self.assertEqual(proc.wait(timeout=10), 0, proc.stderr.read())
+        finally:
+            proc.kill()
+            proc.stdout.close()
+            proc.stderr.close()
+        self.assertIn("item:a\nitem:b", stdout)
+        self.assertIn("last:0", stdout)
+
+    def test_profile(self):
+        """Test that --profile and set -o profile report time per line and per function"""
+        self.create_test_file("profiled.olsh", (
+            "function add {\n  (( total = total + $1 ))\n}\n"
+            "set total = 0\n"
+            "for N in 1 2 3 4; do\n  add $N\ndone\n"
+            "echo $(add 5)$total\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("--profile=profile.json", args=("profiled.olsh",))
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("15", stdout)
+        with open(os.path.join(self.test_dir, "profile.json")) as f:
+            profile = json.load(f)
+        lines = {entry["line"]: entry for entry in profile["lines"]}
+        self.assertEqual(lines[2]["count"], 5)
+        self.assertEqual(lines[6]["count"], 4)
+        self.assertGreaterEqual(lines[6]["inclusive_ms"], lines[6]["exclusive_ms"])
+        self.assertGreater(lines[8]["substitution_ms"], 0)
+        functions = {entry["name"]: entry for entry in profile["functions"]}
+        self.assertEqual(functions["add"]["calls"], 5)
+        self.assertEqual(functions["(top level)"]["calls"], 1)
+
+        # switched on halfway, the table goes to stderr once the script is done
+        self.create_test_file("halfway.olsh", (
+            "echo unprofiled\n"
+            "set -o profile\n"
+            "for N in 1 2; do\n  echo $N\ndone\n"
+            "set -o nonsense\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("halfway.olsh")
+        self.assertIn("unknown option: nonsense", stderr)
+        self.assertIn("profile:", stderr)
+        self.assertIn("halfway.olsh:4", stderr)
+        self.assertNotIn("halfway.olsh:1\n", stderr)
+        self.assertIn("(top level)", stderr)
+
+    def test_xtrace(self):
+        """Test that set -x traces expanded commands with depth, source line and time"""
+        self.create_test_file("traced.olsh", (
+            "function greet {\n  echo \"hi $1\"\n}\n"
+            "echo untraced\n"
+            "set -x\n"
+            "set WHO = world\n"
+            "for N in 1 2; do\n  (( N > 1 )) && echo skip\ndone\n"
+            "greet $WHO\n"
+            "set R = $(echo sub)\n"
+            "set +x\n"
+            "echo after\n"
+        ))
+        trace_file = os.path.join(self.test_dir, "trace.log")
+        stdout, stderr, code, _ = self.run_olshell_script("traced.olsh", env={"OLSH_XTRACEFILE": trace_file})
+        self.assertEqual(code, 0, stderr)
+        self.assertIn("hi world", stdout)
+        with open(trace_file) as f:
+            trace = f.read().splitlines()
+        lines = [re.sub(r" \+\d+\.\d{6}s ", " ", line) for line in trace]
+        self.assertEqual(lines[0], "+ traced.olsh:6: set WHO = world")
+        self.assertIn("+ traced.olsh:7: for N in 1 2", lines)
+        self.assertIn("+ traced.olsh:10: greet world", lines)
+        self.assertIn("++ traced.olsh:2: echo \"hi world\"", lines)
+        self.assertIn("++ echo sub", lines)
+        self.assertIn("+ traced.olsh:11: set R = sub", lines)
+        self.assertEqual(lines[-1], "+ traced.olsh:12: set +x")
+        self.assertFalse(any("untraced" in line or "after" in line for line in lines))
+
+        # typed at the prompt there's no source line
+        stdout, stderr, code = self.run_olshell_command("set -x\necho typed\nset +x\nset -o")
+        self.assertIn("+ ", stderr)
+        self.assertTrue(re.search(r"^\S*\+ \+\d+\.\d{6}s echo typed$", stderr, re.M), stderr)
+        self.assertIn("xtrace\toff", stdout)
+
+    def test_read(self):
+        """Test read from a done < FILE loop, -r, -d, -u and splitting into names"""
+        data = os.path.join(self.test_dir, "data.txt")
+        with open(data, "w") as f:
+            f.write("alpha beta  gamma\n  padded  \nback\\\nslash a\\ b\nno newline")
+        self.create_test_file("reader.olsh", (
+            "set N = 0\n"
+            f"while read first rest; do\n  (( N = N + 1 ))\n  echo \"$N[$first][$rest]\"\ndone < {data}\n"
+            "echo \"after [$first][$rest] $N\"\n"
+            f"for F in 1 2; do\n  read -r line\n  echo \"r$F[$line]\"\ndone < {data}\n"
+            f"read -d a head < {data}\n"
+            "echo \"d[$head] $?\"\n"
+            "read -u 0 one\n"
+            "read\n"
+            "echo \"u[$one] reply[$REPLY]\"\n"
+            "read x y z\n"
+            "echo \"$x|$y|$z\"\n"
+            "read gone\n"
+            "echo \"eof $? [$gone]\"\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("reader.olsh", input_text="first line\n  keep  \n1 2 3 4\n")
+        self.assertEqual(stderr, "")
+        for line in ("1[alpha][beta  gamma]", "2[padded][]", "3[backslash][a b]",
+                     "after [no][newline] 3", "r1[alpha beta  gamma]", "r2[padded]",
+                     "d[] 0", "u[first line] reply[  keep  ]", "1|2|3 4", "eof 1 []"):
+            self.assertIn(line, stdout)
+
+    def test_arrays(self):
+        """Test indexed and associative arrays in expansions, assignments and for loops"""
+        self.create_test_file("arrays.olsh", (
+            "set fruits = (apple \"big banana\" cherry)\n"
+            "echo \"n=${#fruits[@]} first=$fruits second=${fruits[1]} last=${fruits[-1]}\"\n"
+            "set I = 1\n"
+            "set fruits[I + 2] = date\n"
+            "set fruits += (elder)\n"
+            "echo \"all: ${fruits[@]} keys: ${!fruits[@]} at: ${fruits[$I]}\"\n"
+            "for f in \"${fruits[@]}\"; do\n  echo \"item <$f>\"\ndone\n"
+            "declare -A color\n"
+            "set color = ([apple]=red [\"big banana\"]=yellow)\n"
+            "set color[kiwi] = green\n"
+            "set color[apple] += ish\n"
+            "for k in \"${!color[@]}\"; do\n  echo \"$k -> ${color[$k]}\"\ndone\n"
+            "echo \"count ${#color[@]} missing [${color[plum]}]\"\n"
+            "function f {\n  local -A m = ([a]=1 [b]=2)\n  local arr = (x y z)\n  echo \"in f: ${m[b]} ${arr[-1]}\"\n}\n"
+            "f\n"
+            "echo \"after f: [${arr[@]}]\"\n"
+            "set fruits[-9] = x\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("arrays.olsh")
+        for line in ("n=3 first=apple second=big banana last=cherry",
+                     "all: apple big banana cherry date elder keys: 0 1 2 3 4 at: big banana",
+                     "item <big banana>", "item <elder>",
+                     "apple -> redish", "big banana -> yellow", "kiwi -> green",
+                     "count 3 missing []", "in f: 2 z", "after f: []"):
+            self.assertIn(line, stdout)
+        self.assertEqual(stdout.count("item <"), 5)
+        self.assertIn("bad array subscript", stderr)
+
+    def test_parameter_expansion(self):
+        """Test ${v#p} ${v%p} ${v/p/r} ${v:o:l} ${#v} ${v:-w} and case conversion"""
+        self.create_test_file("params.olsh", (
+            "set path = /usr/local/lib/libfoo.so.1.2\n"
+            "echo \"base ${path##*/} dir ${path%/*} ext ${path#*.} last ${path##*.} stem ${path%%.*}\"\n"
+            "echo \"len ${#path} sub ${path:5:5} tail ${path: -3} mid ${path:15:-6}\"\n"
+            "set s = hello world hello\n"
+            "echo \"one ${s/hello/bye} all ${s//hello/bye} del ${s//o/} start ${s/#hello/X} end ${s/%hello/Y} class ${s//[eo]/_}\"\n"
+            "echo \"up ${s^^} first ${s^} low ${s,,} some ${s^^[lo]}\"\n"
+            "set empty =\n"
+            "echo \"def ${unset_var:-fallback} [${empty:-d}] [${empty-d}] alt ${s:+yes} [${unset_var:+yes}]\"\n"
+            "echo \"assign ${newv:=7} then $newv\"\n"
+            "set arr = (a.txt b.txt c.txt)\n"
+            "echo \"each ${arr[@]%.txt} slice ${arr[@]:1:2} elem ${#arr[2]}\"\n"
+            "function f {\n  echo \"obj ${1%.c}.o ${2:-none}\"\n}\n"
+            "f main.c\n"
+            "set ext = so\n"
+            "echo \"pattern var ${path%.$ext*}\"\n"
+        ))
+        stdout, stderr, code, _ = self.run_olshell_script("params.olsh")
+        self.assertEqual(stderr, "")
+        for line in ("base libfoo.so.1.2 dir /usr/local/lib ext so.1.2 last 2 stem /usr/local/lib/libfoo",
+                     "len 28 sub local tail 1.2 mid libfoo",
+                     "one bye world hello all bye world bye del hell wrld hell start X world hello end hello world Y class h_ll_ w_rld h_ll_",
+                     "up HELLO WORLD HELLO first Hello world hello low hello world hello some heLLO wOrLd heLLO",
+                     "def fallback [d] [] alt yes []",
+                     "assign 7 then 7",
+                     "each a b c slice b.txt c.txt elem 5",
+                     "obj main.o none",
+                     "pattern var /usr/local/lib/libfoo"):
+            self.assertIn(line, stdout)
+
 
 class TestComplexScenarios(OlshellTestBase):
     """Test complex real-world scenarios"""
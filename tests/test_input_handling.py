@@ -287,5 +287,32 @@ class TestAdvancedInputFeatures(OlshellTestBase):
             self.fail("Shell did not recover from interrupt properly")
 
 
+    @unittest.skipIf(sys.platform == "win32", "uses POSIX signals")
+    def test_sigint_reaches_foreground_command(self):
+        """Test that SIGINT to the shell stops the running command and the shell keeps going"""
+        import signal
+        process = subprocess.Popen(
+            [str(self.olshell_exe)],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            text=True,
+            cwd=self.test_dir,
+            env={**os.environ, "HOME": self.test_dir}  # no aliases from other tests
+        )
+        try:
+            start = time.time()
+            process.stdin.write('sleep 5\necho "after sigint"\nexit\n')
+            process.stdin.flush()
+            time.sleep(0.5)
+            process.send_signal(signal.SIGINT)
+
+            stdout, stderr = process.communicate(timeout=10)
+            self.assertIn("after sigint", stdout)
+            self.assertLess(time.time() - start, 4, "sleep should have been interrupted")
+        except subprocess.TimeoutExpired:
+            process.kill()
+            self.fail("Shell did not recover from SIGINT")
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
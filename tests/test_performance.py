@@ -8,6 +8,7 @@ import subprocess
 import time
 import threading
 import os
+import shutil
 from pathlib import Path
 import sys
 
@@ -274,6 +275,522 @@ class TestStressScenarios(OlshellTestBase):
         self.assertIn("good command 4", stdout)
 
 
+@unittest.skipIf(sys.platform == "win32", "posix_spawn/fork launch paths are unix only")
+class TestProcessLaunch(OlshellTestBase):
+    """Benchmark external command launch latency: posix_spawn vs fork as the shell grows"""
+
+    LAUNCHES = 200
+
+    def write_launch_script(self, name, count):
+        self.create_test_file(name, (
+            "set I = 0\n"
+            f"while [ $I -lt {count} ]; do\n"
+            "  true\n"
+            "  set I = $((I + 1))\n"
+            "done\n"
+        ))
+
+    def write_history(self, lines):
+        # the history is loaded into memory at startup, so a big one grows the shell's RSS
+        history_dir = Path(self.test_dir) / ".olshell"
+        history_dir.mkdir(exist_ok=True)
+        line = "echo history padding line to grow the shell process " + "x" * 40 + "\n"
+        (history_dir / "history").write_text(line * lines)
+
+    def measure_launch(self, mode, history_lines):
+        env = {"HOME": self.test_dir, "OLSH_LAUNCH": mode}
+
+        # the empty loop run takes startup, history loading and the interpreter out of the number
+        self.write_history(history_lines)
+        _, _, code, baseline = self.run_olshell_script("launch_0.olsh", env=env)
+        self.assertEqual(code, 0)
+
+        self.write_history(history_lines)
+        _, stderr, code, elapsed = self.run_olshell_script("launch_n.olsh", env=env)
+        self.assertEqual(code, 0, stderr)
+
+        return max(elapsed - baseline, 0.0) / self.LAUNCHES
+
+    def test_spawn_vs_fork_latency(self):
+        """Compare per-command launch latency of both paths for growing shell sizes"""
+        self.write_launch_script("launch_0.olsh", 0)
+        self.write_launch_script("launch_n.olsh", self.LAUNCHES)
+
+        results = {}
+        print()
+        print(f"{'history lines':>14} {'fork (ms)':>10} {'spawn (ms)':>11}")
+        for history_lines in (0, 100000, 400000):
+            fork = self.measure_launch("fork", history_lines)
+            spawn = self.measure_launch("spawn", history_lines)
+            results[history_lines] = (fork, spawn)
+            print(f"{history_lines:>14} {fork * 1000:>10.3f} {spawn * 1000:>11.3f}")
+
+        # spawn shouldn't get slower with the shell size the way fork does
+        fork_big, spawn_big = results[400000]
+        self.assertLess(spawn_big, fork_big * 1.5 + 0.0005)
+
+
+@unittest.skipIf(not sys.platform.startswith("linux"), "splice/sendfile/copy_file_range are linux only")
+class TestZeroCopyThroughput(OlshellTestBase):
+    """Benchmark moving multi-GB files through cat/tee: zero-copy syscalls vs the buffered loop"""
+
+    # OLSH_BENCH_GB=... for a different size
+    SIZE_GB = float(os.environ.get("OLSH_BENCH_GB", "2"))
+
+    def setUp(self):
+        super().setUp()
+        self.size = int(self.SIZE_GB * (1 << 30))
+        # the source, the copies and some slack
+        if shutil.disk_usage(self.test_dir).free < self.size * 4:
+            self.skipTest(f"not enough free space for a {self.SIZE_GB} GB benchmark")
+
+        # random data so nothing along the way can cheat with zero pages
+        block = os.urandom(1 << 20)
+        with open(Path(self.test_dir) / "big.bin", "wb") as f:
+            for _ in range(self.size // len(block)):
+                f.write(block)
+        self.size = (self.size // len(block)) * len(block)
+
+    def measure(self, command, zero_copy):
+        self.create_test_file("bench.olsh", command + "\n")
+        env = {"HOME": self.test_dir, "OLSH_ZERO_COPY": "1" if zero_copy else "0"}
+        stdout, stderr, code, elapsed = self.run_olshell_script("bench.olsh", env=env, timeout=600)
+        self.assertEqual(code, 0, stderr)
+        return stdout, elapsed
+
+    def test_zero_copy_vs_buffered(self):
+        """Compare GB/s of file->file, file->pipe and pipe->pipe (cat and tee) on both paths"""
+        cases = [
+            ("cat file > file", "cat big.bin > copy.bin", "copy.bin"),
+            ("cat file | ext", "cat big.bin | wc -c", None),
+            ("ext | cat | ext", "head -c 100G big.bin | cat | wc -c", None),
+            ("ext | tee file | ext", "head -c 100G big.bin | tee copy.bin | wc -c", "copy.bin"),
+        ]
+
+        gb = self.size / (1 << 30)
+        print()
+        print(f"{'pipeline':>22} {'buffered (GB/s)':>16} {'zero-copy (GB/s)':>17}")
+        for name, command, copy in cases:
+            rates = []
+            for zero_copy in (False, True):
+                # best of two, writeback of the previous copy can land in either run
+                best = None
+                for _ in range(2):
+                    stdout, elapsed = self.measure(command, zero_copy)
+                    if copy:
+                        self.assertEqual((Path(self.test_dir) / copy).stat().st_size, self.size)
+                        (Path(self.test_dir) / copy).unlink()
+                    else:
+                        self.assertIn(str(self.size), stdout)
+                    best = elapsed if best is None else min(best, elapsed)
+                rates.append(gb / max(best, 1e-6))
+            print(f"{name:>22} {rates[0]:>16.2f} {rates[1]:>17.2f}")
+
+            # the kernel path should never lose to copying through the shell
+            self.assertGreater(rates[1], rates[0] * 0.8)
+
+
+class TestTokenizerThroughput(OlshellTestBase):
+    """Benchmark tokenizing a corpus of real command lines and 1 MB pasted argument lists"""
+
+    # no pipes or ; in here, every line runs as a single echo into /dev/null
+    CORPUS = [
+        'git log --oneline --graph --decorate -n 20 -- src/parser',
+        'grep -rn "TODO(fixme)" src/ include/ --include=*.cpp --exclude-dir=build',
+        "find . -name '*.o' -newer CMakeLists.txt -print",
+        'tar -czf backup-2024-10-01.tar.gz ~/Documents ~/Pictures/Ürlaub ~/Музыка',
+        'rsync -avz --delete --exclude=.git ./ deploy@build-01:/srv/app/releases/42',
+        'docker run --rm -e CC=clang -v $PWD:/src -w /src gcc:13 make -j8 all',
+        'ls -la /var/log/nginx 2>/dev/null',
+        'curl -fsSL -H "Authorization: Bearer $TOKEN" https://example.com/api/v1/items?page=2',
+        'ssh -o StrictHostKeyChecking=no -p 2222 ops@10.0.0.17 uptime',
+        'cp "Quarterly Report (final).pdf" "reports/2024/Q3 \\"draft\\".pdf"',
+        'convert 写真.jpg -resize 50% サムネイル.png',
+        'python3 -m pytest -k "not slow" --maxfail=1 tests/test_parser.py::TestQuotes',
+    ]
+    REPEAT = 300
+    PASTE_BYTES = 1 << 20
+
+    def run_lines(self, lines):
+        self.create_test_file("corpus.txt", "".join(f"echo {line} > /dev/null\n" for line in lines))
+        with open(Path(self.test_dir) / "corpus.txt", "rb") as corpus:
+            start = time.time()
+            result = subprocess.run([str(self.olshell_exe)], stdin=corpus, capture_output=True,
+                                    cwd=self.test_dir, env={**os.environ, "HOME": self.test_dir}, timeout=300)
+            elapsed = time.time() - start
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return elapsed
+
+    def test_tokenizer_throughput(self):
+        """Lines/s for the corpus and MB/s for huge argument lists, plain and quoted"""
+        baseline = self.run_lines([])  # startup and exit
+
+        corpus = self.CORPUS * self.REPEAT
+        elapsed = max(self.run_lines(corpus) - baseline, 1e-6)
+        corpus_rate = len(corpus) / elapsed
+
+        # a pasted file list, and the same text as one quoted argument with escapes in it
+        names = []
+        size = 0
+        while size < self.PASTE_BYTES:
+            names.append(f"build/obj/file_{len(names):07d}.o")
+            size += len(names[-1]) + 1
+        pasted = " ".join(names)
+        quoted = '"' + pasted.replace("file_0", '\\"file_0') + '"'
+
+        rates = {}
+        for name, line in (("plain 1 MB", pasted), ("quoted 1 MB", quoted)):
+            elapsed = max(self.run_lines([line] * 4) - baseline, 1e-6)
+            rates[name] = 4 * len(line) / (1 << 20) / elapsed
+
+        print()
+        print(f"{'corpus (lines/s)':>18} {'plain 1 MB (MB/s)':>18} {'quoted 1 MB (MB/s)':>19}")
+        print(f"{corpus_rate:>18.0f} {rates['plain 1 MB']:>18.1f} {rates['quoted 1 MB']:>19.1f}")
+
+        # nothing in there is quadratic, a 1 MB line has to go through in well under a second
+        self.assertGreater(rates["plain 1 MB"], 4)
+        self.assertGreater(rates["quoted 1 MB"], 4)
+
+    def test_utf8_words_survive(self):
+        """Bytes outside ASCII are part of words instead of being dropped"""
+        stdout, stderr, code = self.run_olshell_command('echo 文件.txt Ürlaub naïve $HOME a=b')
+        self.assertIn("文件.txt Ürlaub naïve $HOME a=b", stdout)
+
+
+class TestScriptInterpreter(OlshellTestBase):
+    """Benchmark the script VM on a tight loop and the playground script"""
+
+    ITERATIONS = 20000
+
+    def write_loop(self, name, count):
+        self.create_test_file(name, (
+            "set I = 0\n"
+            "set S = 0\n"
+            f"while [ $I -lt {count} ]; do\n"
+            "  if [ $I -gt 5 ]; then\n"
+            "    set S = $((S + I))\n"
+            "  elif [ $I -eq 3 ]; then\n"
+            "    set S = 1\n"
+            "  else\n"
+            "    set S = $((S + 1))\n"
+            "  fi\n"
+            "  set I = $((I + 1))\n"
+            "done\n"
+            "echo sum=$S\n"
+        ))
+
+    def best_of(self, script, runs=3, args=()):
+        best = None
+        for _ in range(runs):
+            stdout, stderr, code, elapsed = self.run_olshell_script(script, args=args, env={"HOME": self.test_dir})
+            self.assertEqual(code, 0, stderr)
+            best = elapsed if best is None else min(best, elapsed)
+        return stdout, best
+
+    def test_loop_iterations(self):
+        """Microseconds per iteration of a while loop with an if/elif/else inside"""
+        self.write_loop("loop_0.olsh", 0)
+        self.write_loop("loop_n.olsh", self.ITERATIONS)
+        _, baseline = self.best_of("loop_0.olsh")
+        stdout, elapsed = self.best_of("loop_n.olsh")
+
+        n = self.ITERATIONS
+        expected = 1 + 2 + sum(range(6, n))  # i=3 resets to 1, i=4,5 add one
+        self.assertIn(f"sum={expected}", stdout)
+
+        per_iteration = max(elapsed - baseline, 0.0) / n
+        print()
+        print(f"{'iterations':>11} {'us/iteration':>13}")
+        print(f"{n:>11} {per_iteration * 1e6:>13.2f}")
+        self.assertLess(per_iteration, 100e-6)
+
+    def test_counter_loops(self):
+        """Microseconds per iteration of counting with set $((...)) and with (( ++ ))"""
+        forms = {
+            "set $((I + 1))": ("while [ $I -lt {n} ]; do\n", "  set I = $((I + 1))\n"),
+            "(( I++ ))": ("while (( I < {n} )); do\n", "  (( I++ ))\n"),
+        }
+        print()
+        print(f"{'form':>16} {'us/iteration':>13}")
+        for name, (head, step) in forms.items():
+            for count in (0, self.ITERATIONS):
+                self.create_test_file(f"count_{count}.olsh", (
+                    "set I = 0\n" + head.format(n=count) + step + "done\necho count=$I\n"
+                ))
+            _, baseline = self.best_of("count_0.olsh")
+            stdout, elapsed = self.best_of(f"count_{self.ITERATIONS}.olsh")
+            self.assertIn(f"count={self.ITERATIONS}", stdout)
+            per_iteration = max(elapsed - baseline, 0.0) / self.ITERATIONS
+            print(f"{name:>16} {per_iteration * 1e6:>13.2f}")
+            self.assertLess(per_iteration, 100e-6)
+
+    def test_function_calls(self):
+        """Microseconds per call of a recursive function with locals"""
+        self.create_test_file("fib.olsh", (
+            "function fib {\n"
+            "  local N = $1\n"
+            "  if (( N < 2 )); then set R = $N; else\n"
+            "    fib $((N - 1))\n"
+            "    local A = $R\n"
+            "    fib $((N - 2))\n"
+            "    (( R += A ))\n"
+            "  fi\n"
+            "}\n"
+            "fib $1\n"
+            "echo fib=$R\n"
+        ))
+        _, baseline = self.best_of("fib.olsh", args=("0",))
+        stdout, elapsed = self.best_of("fib.olsh", args=("18",))
+        self.assertIn("fib=2584", stdout)
+
+        calls = 8361  # fib(18) makes 2 * fib(19) - 1 calls
+        per_call = max(elapsed - baseline, 0.0) / calls
+        print(f"\n{'calls':>11} {'us/call':>13}")
+        print(f"{calls:>11} {per_call * 1e6:>13.2f}")
+        self.assertLess(per_call, 200e-6)
+
+    def test_line_expansion(self):
+        """Microseconds per line for lines with nothing to expand and lines full of expansions"""
+        lines = {
+            "expansion-free": "set A = plain text without anything to expand in it at all",
+            "expansion-heavy": "set A = $X-$Y-${X}-$1-$#-$?-$((I * 2))-$X$Y$X$Y",
+        }
+        n = 50000
+
+        def script(body):
+            return ("set I = 0\nset X = x\nset Y = yy\n"
+                    f"while (( I < {n} )); do\n{body}  (( I++ ))\ndone\necho A=$A\n")
+
+        self.create_test_file("expand_0.olsh", script(""))
+        _, baseline = self.best_of("expand_0.olsh", args=("arg",))
+        print()
+        print(f"{'line':>16} {'us/line':>9}")
+        for name, line in lines.items():
+            self.create_test_file("expand_n.olsh", script(f"  {line}\n"))
+            stdout, elapsed = self.best_of("expand_n.olsh", args=("arg",))
+            per_line = max(elapsed - baseline, 0.0) / n
+            print(f"{name:>16} {per_line * 1e6:>9.3f}")
+            self.assertLess(per_line, 50e-6)
+        self.assertIn(f"A=x-yy-x-arg-1-0-{(n - 1) * 2}-xyyxyy", stdout)
+
+    def test_command_substitution(self):
+        """Microseconds per $(...) of a builtin, a function and an external"""
+        forms = {
+            "builtin": "set A = $(echo $I)",
+            "function": "set A = $(show $I)",
+            "external": "set A = $(true)",
+        }
+        counts = {"builtin": 5000, "function": 5000, "external": 200}
+
+        def script(n, body):
+            return ("function show {\n  echo $1\n}\nset I = 0\n"
+                    f"while (( I < {n} )); do\n{body}  (( I++ ))\ndone\necho done=$I\n")
+
+        print()
+        print(f"{'substitution':>13} {'us/each':>9}")
+        for name, line in forms.items():
+            n = counts[name]
+            self.create_test_file("subst_0.olsh", script(0, f"  {line}\n"))
+            self.create_test_file("subst_n.olsh", script(n, f"  {line}\n"))
+            _, baseline = self.best_of("subst_0.olsh")
+            stdout, elapsed = self.best_of("subst_n.olsh")
+            self.assertIn(f"done={n}", stdout)
+            each = max(elapsed - baseline, 0.0) / n
+            print(f"{name:>13} {each * 1e6:>9.2f}")
+            self.assertLess(each, 10e-3 if name == "external" else 200e-6)
+
+    def run_with_peak(self, path):
+        """Run a script, returning its stdout, seconds and peak resident KB"""
+        proc = subprocess.Popen([str(self.olshell_exe), path], stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE, cwd=self.test_dir)
+        start = time.time()
+        stdout = proc.stdout.read().decode()
+        stderr = proc.stderr.read().decode()
+        # wait4 instead of wait(), it has the peak memory of exactly this child
+        _, status, usage = os.wait4(proc.pid, 0)
+        proc.returncode = os.waitstatus_to_exitcode(status)
+        elapsed = time.time() - start
+        proc.stdout.close()
+        proc.stderr.close()
+        self.assertEqual(proc.returncode, 0, stderr)
+        return stdout, elapsed, usage.ru_maxrss
+
+    def test_streamed_script_memory(self):
+        """Peak memory and microseconds per line of a long generated script"""
+        n = 300000
+        path = os.path.join(self.test_dir, "generated.olsh")
+        with open(path, "w") as f:
+            for i in range(n):
+                f.write(f"set X{i % 50} = generated line number {i} $(({i} + 1))\n")
+            f.write("echo X7=$X7\n")
+        self.create_test_file("empty.olsh", "echo X7=\n")
+
+        _, _, base_kb = self.run_with_peak("empty.olsh")
+        stdout, elapsed, peak_kb = self.run_with_peak(path)
+        self.assertIn(f"X7=generated line number {n - 43} {n - 42}", stdout)
+
+        size_mb = os.path.getsize(path) / 1e6
+        grown_mb = max(peak_kb - base_kb, 0) / 1024
+        print(f"\n{'lines':>9} {'script MB':>10} {'grown MB':>9} {'us/line':>8}")
+        print(f"{n:>9} {size_mb:>10.1f} {grown_mb:>9.1f} {elapsed / n * 1e6:>8.2f}")
+        # statements run as they're read, the script is never held in memory as a whole
+        self.assertLess(grown_mb, size_mb / 4)
+
+    def test_cached_library_script(self):
+        """Milliseconds for a big library script compiled from scratch and loaded from the cache"""
+        with open(os.path.join(self.test_dir, "library.olsh"), "w") as f:
+            for i in range(2000):
+                f.write(f"function helper_{i} {{\n  local A = $1\n  if (( A > {i} )); then\n"
+                        f"    set R = $((A * {i} + 1))\n  else\n    set R = small_{i}\n  fi\n}}\n")
+            f.write("helper_1999 5000\necho R=$R\n")
+
+        def best(env):
+            times = []
+            for _ in range(5):
+                stdout, stderr, code, elapsed = self.run_olshell_script("library.olsh", env=env)
+                self.assertEqual(code, 0, stderr)
+                self.assertIn(f"R={5000 * 1999 + 1}", stdout)
+                times.append(elapsed)
+            return min(times)
+
+        compiled = best({"HOME": self.test_dir, "OLSH_SCRIPT_CACHE": "0"})
+        cached = best({"HOME": self.test_dir})
+        print(f"\n{'compiled ms':>12} {'cached ms':>10}")
+        print(f"{compiled * 1000:>12.2f} {cached * 1000:>10.2f}")
+        self.assertLess(cached, compiled)
+
+    def test_profiler_overhead(self):
+        """Microseconds per loop iteration with and without --profile"""
+        self.write_loop("loop_0.olsh", 0)
+        self.write_loop("loop_n.olsh", self.ITERATIONS)
+        _, baseline = self.best_of("loop_0.olsh")
+        _, plain = self.best_of("loop_n.olsh")
+        _, profiled = self.best_of("--profile=profile.json", args=("loop_n.olsh",))
+
+        n = self.ITERATIONS
+        plain = max(plain - baseline, 0.0) / n
+        profiled = max(profiled - baseline, 0.0) / n
+        print()
+        print(f"{'us/iteration':>13} {'profiled':>9} {'overhead':>9}")
+        print(f"{plain * 1e6:>13.2f} {profiled * 1e6:>9.2f} {(profiled / plain - 1) * 100 if plain else 0:>8.1f}%")
+        with open(os.path.join(self.test_dir, "profile.json")) as f:
+            self.assertIn('"line":11', f.read())
+        self.assertLess(profiled, plain * 1.5 + 5e-6)
+
+    def test_xtrace_cost(self):
+        """Microseconds per loop iteration untraced and with set -x going to a file"""
+        self.write_loop("loop_0.olsh", 0)
+        self.write_loop("loop_n.olsh", self.ITERATIONS)
+        with open(os.path.join(self.test_dir, "loop_n.olsh")) as f:
+            body = f.read()
+        self.create_test_file("traced_0.olsh", "set -x\n")
+        self.create_test_file("traced_n.olsh", "set -x\n" + body)
+        trace_file = os.path.join(self.test_dir, "trace.log")
+
+        def per_iteration(empty, full, env):
+            times = {}
+            for script in (empty, full):
+                best = None
+                for _ in range(3):
+                    if os.path.exists(trace_file):
+                        os.remove(trace_file)
+                    _, stderr, code, elapsed = self.run_olshell_script(script, env=env)
+                    self.assertEqual(code, 0, stderr)
+                    best = elapsed if best is None else min(best, elapsed)
+                times[script] = best
+            return max(times[full] - times[empty], 0.0) / self.ITERATIONS
+
+        plain = per_iteration("loop_0.olsh", "loop_n.olsh", {"HOME": self.test_dir})
+        traced = per_iteration("traced_0.olsh", "traced_n.olsh", {"HOME": self.test_dir, "OLSH_XTRACEFILE": trace_file})
+        with open(trace_file) as f:
+            lines = sum(1 for _ in f)
+        print()
+        print(f"{'us/iteration':>13} {'traced':>8} {'trace lines':>12}")
+        print(f"{plain * 1e6:>13.2f} {traced * 1e6:>8.2f} {lines:>12}")
+        self.assertGreater(lines, self.ITERATIONS * 3)
+
+    def test_read_lines(self):
+        """Microseconds per line of a while read loop splitting a file into fields"""
+        lines = 200000
+        data = os.path.join(self.test_dir, "lines.txt")
+        with open(data, "w") as f:
+            for i in range(lines):
+                f.write(f"{i} kind{i % 7} the rest of the line\n")
+        self.create_test_file("read_0.olsh", "set N = 0\necho $N\n")
+        self.create_test_file("read_n.olsh", (
+            "set N = 0\n"
+            f"while read id kind rest; do\n  (( N = N + 1 ))\ndone < {data}\n"
+            "echo $N\n"
+        ))
+        _, baseline = self.best_of("read_0.olsh")
+        stdout, elapsed = self.best_of("read_n.olsh")
+        per_line = max(elapsed - baseline, 0.0) / lines
+        print(f"\nwhile read: {per_line * 1e6:.2f} us/line, {elapsed * 1000:.1f} ms for {lines} lines")
+        self.assertEqual(stdout.strip(), str(lines))
+        self.assertLess(per_line, 20e-6)
+
+    def test_array_iteration(self):
+        """Microseconds per element walking an array, a word list and an associative array"""
+        count = 100000
+        setup = f"set LIST = $(seq 1 {count})\nset arr = ($LIST)\ndeclare -A map\n"
+        self.create_test_file("array_0.olsh", setup)
+        self.create_test_file("array_list.olsh", setup + "for x in $LIST; do\n  set V = $x\ndone\n")
+        self.create_test_file("array_arr.olsh", setup + "for x in \"${arr[@]}\"; do\n  set V = $x\ndone\n")
+        self.create_test_file("array_map.olsh", setup + (
+            "for x in \"${arr[@]}\"; do\n  set map[k$x] = $x\ndone\n"
+            "for x in \"${arr[@]}\"; do\n  set V = ${map[k$x]}\ndone\n"
+            "echo ${#map[@]} $V\n"
+        ))
+        _, baseline = self.best_of("array_0.olsh")
+        times = {}
+        for name in ("list", "arr", "map"):
+            stdout, elapsed = self.best_of(f"array_{name}.olsh")
+            times[name] = max(elapsed - baseline, 0.0) / count
+        print()
+        print(f"{'us/element':>11} {'word list':>10} {'array':>8} {'map set+get':>12}")
+        print(f"{'':>11} {times['list'] * 1e6:>10.2f} {times['arr'] * 1e6:>8.2f} {times['map'] * 1e6:>12.2f}")
+        self.assertEqual(stdout.split(), [str(count), str(count)])
+
+    def test_parameter_expansion(self):
+        """Microseconds per ${v##*/}-style expansion against forking basename for the same"""
+        self.create_test_file("expand_0.olsh", (
+            f"set I = 0\nwhile (( I < {self.ITERATIONS} )); do\n"
+            "  set P = /usr/local/lib/file$I.tar.gz\n"
+            "  (( I = I + 1 ))\ndone\n"
+        ))
+        self.create_test_file("expand_n.olsh", (
+            f"set I = 0\nwhile (( I < {self.ITERATIONS} )); do\n"
+            "  set P = /usr/local/lib/file$I.tar.gz\n"
+            "  set A = ${P##*/} ${P%%.*} ${P/lib/LIB} ${P:5:5} ${P^^}\n"
+            "  (( I = I + 1 ))\ndone\necho $A\n"
+        ))
+        forks = 200
+        self.create_test_file("expand_fork.olsh", (
+            f"set I = 0\nwhile (( I < {forks} )); do\n"
+            "  set A = $(basename /usr/local/lib/file$I.tar.gz)\n"
+            "  (( I = I + 1 ))\ndone\necho $A\n"
+        ))
+        _, baseline = self.best_of("expand_0.olsh")
+        stdout, elapsed = self.best_of("expand_n.olsh")
+        native = max(elapsed - baseline, 0.0) / (self.ITERATIONS * 5)
+        forked_out, forked = self.best_of("expand_fork.olsh")
+        forked /= forks
+        print()
+        print(f"{'us/expansion':>13} {'basename fork':>14}")
+        print(f"{native * 1e6:>13.2f} {forked * 1e6:>14.2f}")
+        self.assertIn(f"file{self.ITERATIONS - 1}.tar.gz", stdout)
+        self.assertIn(f"file{forks - 1}.tar.gz", forked_out)
+        self.assertLess(native, forked)
+
+    def test_playground_script(self):
+        """playground/quick-test.olsh as a regression benchmark"""
+        script = Path(__file__).resolve().parent.parent / "playground" / "quick-test.olsh"
+        stdout, elapsed = self.best_of(str(script), runs=5, args=("World",))
+        print(f"\nquick-test.olsh: {elapsed * 1000:.2f} ms")
+        for line in ("Hello, World!", "NUM=6", "six ok", "item:c", "cnt:2", "Hello from func, World!"):
+            self.assertIn(line, stdout)
+
+
 class TestResourceManagement(OlshellTestBase):
     """Test resource management and cleanup"""
     